@@ -234,6 +234,21 @@ namespace fs
 		// Do notning
 	}
 
+	u64 file_base::read_at(u64 offset, void* buffer, u64 size)
+	{
+		// Generic implementation changes the position temporarily
+		const u64 old_pos = seek(0, seek_cur);
+
+		if (seek(offset, seek_set) != offset)
+		{
+			return 0;
+		}
+
+		const u64 result = read(buffer, size);
+		verify("file::read_at" HERE), seek(old_pos, seek_set) == old_pos;
+		return result;
+	}
+
 	fs::native_handle fs::file_base::get_handle()
 	{
 #ifdef _WIN32
@@ -1067,6 +1082,33 @@ fs::file::file(const std::string& path, bs_t<open_mode> mode)
 			return nread;
 		}
 
+		u64 read_at(u64 offset, void* buffer, u64 count) override
+		{
+			// TODO (call ReadFile multiple times if count is too big)
+			const int size = narrow<int>(count, "file::read_at" HERE);
+
+			// Reading at explicit offset is safe for concurrent calls, but it moves the file pointer of synchronous handles
+			// The pointer is restored, concurrent read_at calls must not be mixed with sequential access
+			LARGE_INTEGER old_pos{};
+			verify("file::read_at" HERE), SetFilePointerEx(m_handle, old_pos, &old_pos, FILE_CURRENT);
+
+			OVERLAPPED ovl{};
+			ovl.Offset = static_cast<DWORD>(offset);
+			ovl.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+			DWORD nread = 0;
+
+			if (!ReadFile(m_handle, buffer, size, &nread, &ovl))
+			{
+				// Reading past the end of file
+				verify("file::read_at" HERE), GetLastError() == ERROR_HANDLE_EOF;
+				nread = 0;
+			}
+
+			verify("file::read_at" HERE), SetFilePointerEx(m_handle, old_pos, NULL, FILE_BEGIN);
+			return nread;
+		}
+
 		u64 write(const void* buffer, u64 count) override
 		{
 			// TODO (call WriteFile multiple times if count is too big)
@@ -1211,6 +1253,14 @@ fs::file::file(const std::string& path, bs_t<open_mode> mode)
 			return result;
 		}
 
+		u64 read_at(u64 offset, void* buffer, u64 count) override
+		{
+			const auto result = ::pread(m_fd, buffer, count, offset);
+			verify("file::read_at" HERE), result != -1;
+
+			return result;
+		}
+
 		u64 write(const void* buffer, u64 count) override
 		{
 			const auto result = ::write(m_fd, buffer, count);
@@ -1304,6 +1354,20 @@ fs::file::file(const void* ptr, std::size_t size)
 			return 0;
 		}
 
+		u64 read_at(u64 offset, void* buffer, u64 count) override
+		{
+			if (offset < m_size)
+			{
+				if (const u64 result = std::min<u64>(count, m_size - offset))
+				{
+					std::memcpy(buffer, m_ptr + offset, result);
+					return result;
+				}
+			}
+
+			return 0;
+		}
+
 		u64 write(const void* buffer, u64 count) override
 		{
 			return 0;
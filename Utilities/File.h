@@ -82,6 +82,7 @@ namespace fs
 		virtual void sync();
 		virtual bool trunc(u64 length) = 0;
 		virtual u64 read(void* buffer, u64 size) = 0;
+		virtual u64 read_at(u64 offset, void* buffer, u64 size);
 		virtual u64 write(const void* buffer, u64 size) = 0;
 		virtual u64 seek(s64 offset, seek_mode whence) = 0;
 		virtual u64 size() = 0;
@@ -254,6 +255,13 @@ namespace fs
 			return m_file->read(buffer, count);
 		}
 
+		// Read the data at specified position (the current position is preserved, concurrent calls are safe for native files)
+		u64 read_at(u64 offset, void* buffer, u64 count) const
+		{
+			if (!m_file) xnull();
+			return m_file->read_at(offset, buffer, count);
+		}
+
 		// Write the data to the file and return the amount of data actually written
 		u64 write(const void* buffer, u64 count) const
 		{
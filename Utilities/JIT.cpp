@@ -1178,18 +1178,24 @@ void jit_compiler::add(std::unique_ptr<llvm::Module> module)
 	}
 }
 
-void jit_compiler::add(const std::string& path)
+bool jit_compiler::add(const std::string& path)
 {
 	auto cache = ObjectCache::load(path);
 
-	if (auto object_file = llvm::object::ObjectFile::createObjectFile(*cache))
+	if (!cache)
 	{
-		m_engine->addObjectFile( std::move(*object_file) );
+		jit_log.error("ObjectCache: Loading failed: %s", path);
+		return false;
 	}
-	else
+
+	if (auto object_file = llvm::object::ObjectFile::createObjectFile(*cache))
 	{
-		jit_log.error("ObjectCache: Adding failed: %s", path);
+		m_engine->addObjectFile( std::move(*object_file) );
+		return true;
 	}
+
+	jit_log.error("ObjectCache: Adding failed: %s", path);
+	return false;
 }
 
 void jit_compiler::fin()
@@ -168,8 +168,8 @@ public:
 	// Add module (not cached)
 	void add(std::unique_ptr<llvm::Module> module);
 
-	// Add object (path to obj file)
-	void add(const std::string& path);
+	// Add object (path to obj file), returns false if it can't be loaded
+	bool add(const std::string& path);
 
 	// Finalize
 	void fin();
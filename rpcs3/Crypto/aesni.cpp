@@ -33,6 +33,10 @@
 #if defined(_MSC_VER) && defined(_M_X64)
 #define POLARSSL_HAVE_MSVC_X64_INTRINSICS
 #include <intrin.h>
+#define AESNI_FUNC
+#else
+#include <immintrin.h>
+#define AESNI_FUNC __attribute__((__target__("aes")))
 #endif
 
 /*
@@ -680,3 +684,102 @@ int aesni_setkey_enc( unsigned char *rk,
 
     return( 0 );
 }
+
+/*
+ * Big-endian 128-bit counter block
+ */
+static inline __m128i aesni_ctr_block( unsigned long long hi, unsigned long long lo )
+{
+#if defined(POLARSSL_HAVE_MSVC_X64_INTRINSICS)
+    return( _mm_set_epi64x( (long long) _byteswap_uint64( lo ), (long long) _byteswap_uint64( hi ) ) );
+#else
+    return( _mm_set_epi64x( (long long) __builtin_bswap64( lo ), (long long) __builtin_bswap64( hi ) ) );
+#endif
+}
+
+/*
+ * AES-NI AES-CTR buffer encryption/decryption (4 blocks interleaved)
+ */
+AESNI_FUNC void aesni_crypt_ctr( aes_context *ctx,
+                                 size_t length,
+                                 unsigned char nonce_counter[16],
+                                 const unsigned char *input,
+                                 unsigned char *output )
+{
+    const __m128i* rk = (const __m128i*)ctx->rk;
+    const int nr = ctx->nr;
+    unsigned long long hi = 0, lo = 0;
+    __m128i b0, b1, b2, b3, k;
+    unsigned char tmp[16];
+    size_t i;
+    int r;
+
+    for( i = 0; i < 8; i++ )
+    {
+        hi = hi << 8 | nonce_counter[i];
+        lo = lo << 8 | nonce_counter[i + 8];
+    }
+
+    while( length >= 64 )
+    {
+        k  = _mm_loadu_si128( rk );
+        b0 = _mm_xor_si128( aesni_ctr_block( hi + ( lo + 0 < lo ), lo + 0 ), k );
+        b1 = _mm_xor_si128( aesni_ctr_block( hi + ( lo + 1 < lo ), lo + 1 ), k );
+        b2 = _mm_xor_si128( aesni_ctr_block( hi + ( lo + 2 < lo ), lo + 2 ), k );
+        b3 = _mm_xor_si128( aesni_ctr_block( hi + ( lo + 3 < lo ), lo + 3 ), k );
+
+        hi += lo + 4 < lo;
+        lo += 4;
+
+        for( r = 1; r < nr; r++ )
+        {
+            k  = _mm_loadu_si128( rk + r );
+            b0 = _mm_aesenc_si128( b0, k );
+            b1 = _mm_aesenc_si128( b1, k );
+            b2 = _mm_aesenc_si128( b2, k );
+            b3 = _mm_aesenc_si128( b3, k );
+        }
+
+        k  = _mm_loadu_si128( rk + nr );
+        b0 = _mm_aesenclast_si128( b0, k );
+        b1 = _mm_aesenclast_si128( b1, k );
+        b2 = _mm_aesenclast_si128( b2, k );
+        b3 = _mm_aesenclast_si128( b3, k );
+
+        _mm_storeu_si128( (__m128i*)( output + 0x00 ), _mm_xor_si128( b0, _mm_loadu_si128( (const __m128i*)( input + 0x00 ) ) ) );
+        _mm_storeu_si128( (__m128i*)( output + 0x10 ), _mm_xor_si128( b1, _mm_loadu_si128( (const __m128i*)( input + 0x10 ) ) ) );
+        _mm_storeu_si128( (__m128i*)( output + 0x20 ), _mm_xor_si128( b2, _mm_loadu_si128( (const __m128i*)( input + 0x20 ) ) ) );
+        _mm_storeu_si128( (__m128i*)( output + 0x30 ), _mm_xor_si128( b3, _mm_loadu_si128( (const __m128i*)( input + 0x30 ) ) ) );
+
+        input  += 64;
+        output += 64;
+        length -= 64;
+    }
+
+    while( length )
+    {
+        const size_t n = length < 16 ? length : 16;
+
+        b0 = _mm_xor_si128( aesni_ctr_block( hi, lo ), _mm_loadu_si128( rk ) );
+
+        hi += ++lo == 0;
+
+        for( r = 1; r < nr; r++ )
+            b0 = _mm_aesenc_si128( b0, _mm_loadu_si128( rk + r ) );
+
+        _mm_storeu_si128( (__m128i*)tmp, _mm_aesenclast_si128( b0, _mm_loadu_si128( rk + nr ) ) );
+
+        for( i = 0; i < n; i++ )
+            output[i] = (unsigned char)( input[i] ^ tmp[i] );
+
+        input  += n;
+        output += n;
+        length -= n;
+    }
+
+    for( i = 0; i < 8; i++ )
+    {
+        nonce_counter[7 - i]  = (unsigned char)( hi >> ( i * 8 ) );
+        nonce_counter[15 - i] = (unsigned char)( lo >> ( i * 8 ) );
+    }
+}
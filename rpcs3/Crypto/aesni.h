@@ -98,6 +98,25 @@ int aesni_setkey_enc( unsigned char *rk,
                       const unsigned char *key,
                       size_t bits );
 
+/**
+ * \brief          AES-NI AES-CTR buffer encryption/decryption
+ *                 (4 blocks are processed in parallel)
+ *
+ * \param ctx      AES context (initialized with aes_setkey_enc)
+ * \param length   The length of the data
+ * \param nonce_counter The 128-bit big-endian counter (updated)
+ * \param input    The input data stream
+ * \param output   The output data stream (may be equal to input)
+ *
+ * \note           Unlike aes_crypt_ctr(), a partial trailing block
+ *                 discards the rest of its keystream.
+ */
+void aesni_crypt_ctr( aes_context *ctx,
+                      size_t length,
+                      unsigned char nonce_counter[16],
+                      const unsigned char *input,
+                      unsigned char *output );
+
 #ifdef __cplusplus
 }
 #endif
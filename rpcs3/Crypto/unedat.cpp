@@ -2,7 +2,15 @@
 #include "key_vault.h"
 #include "unedat.h"
 
+#include "Utilities/Thread.h"
+#include "Utilities/lockless.h"
+#include "Emu/IdManager.h"
+
 #include <cmath>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
 
 LOG_CHANNEL(edat_log, "EDAT");
 
@@ -172,11 +180,9 @@ s64 decrypt_block(const fs::file* in, u8* out, EDAT_HEADER *edat, NPD_HEADER *np
 	{
 		metadata_sec_offset = metadata_offset + u64{block_num} * metadata_section_size;
 
-		in->seek(file_offset + metadata_sec_offset);
-
 		unsigned char metadata[0x20];
 		memset(metadata, 0, 0x20);
-		in->read(metadata, 0x20);
+		in->read_at(file_offset + metadata_sec_offset, metadata, 0x20);
 
 		// If the data is compressed, decrypt the metadata.
 		// NOTE: For NPD version 1 the metadata is not encrypted.
@@ -197,11 +203,10 @@ s64 decrypt_block(const fs::file* in, u8* out, EDAT_HEADER *edat, NPD_HEADER *np
 	{
 		// If FLAG 0x20, the metadata precedes each data block.
 		metadata_sec_offset = metadata_offset + u64{block_num} * (metadata_section_size + edat->block_size);
-		in->seek(file_offset + metadata_sec_offset);
 
 		unsigned char metadata[0x20];
 		memset(metadata, 0, 0x20);
-		in->read(metadata, 0x20);
+		in->read_at(file_offset + metadata_sec_offset, metadata, 0x20);
 		memcpy(hash_result, metadata, 0x14);
 
 		// If FLAG 0x20 is set, apply custom xor.
@@ -217,9 +222,7 @@ s64 decrypt_block(const fs::file* in, u8* out, EDAT_HEADER *edat, NPD_HEADER *np
 	else
 	{
 		metadata_sec_offset = metadata_offset + u64{block_num} * metadata_section_size;
-		in->seek(file_offset + metadata_sec_offset);
-
-		in->read(hash_result, 0x10);
+		in->read_at(file_offset + metadata_sec_offset, hash_result, 0x10);
 		offset = metadata_offset + u64{block_num} * edat->block_size + total_blocks * metadata_section_size;
 		length = edat->block_size;
 
@@ -237,8 +240,7 @@ s64 decrypt_block(const fs::file* in, u8* out, EDAT_HEADER *edat, NPD_HEADER *np
 	memset(hash, 0, 0x10);
 	memset(key_result, 0, 0x10);
 
-	in->seek(file_offset + offset);
-	in->read(enc_data.get(), length);
+	in->read_at(file_offset + offset, enc_data.get(), length);
 
 	// Generate a key for the current block.
 	std::array<u8, 0x10> b_key = get_block_key(block_num, npd);
@@ -880,6 +882,210 @@ fs::file DecryptEDAT(const fs::file& input, const std::string& input_file_name,
 	return output;
 }
 
+struct edat_block_cache;
+
+// Read-ahead worker shared by all decrypters
+struct edat_read_ahead
+{
+	lf_queue<std::pair<edat_block_cache*, u32>> requests;
+
+	void operator()();
+
+	static constexpr auto thread_name = "EDAT Read-ahead"sv;
+};
+
+struct edat_read_ahead_manager
+{
+	std::mutex mutex;
+
+	// Created on first sequential read (destroyed first)
+	std::unique_ptr<named_thread<edat_read_ahead>> thread;
+};
+
+// Bounded LRU cache of decrypted blocks, filled ahead of sequential reads by the shared worker
+struct edat_block_cache
+{
+	// Max number of cached blocks
+	static constexpr u32 max_blocks = 64;
+
+	// Number of blocks decrypted ahead of a sequential read
+	static constexpr u32 read_ahead = 8;
+
+	EDATADecrypter& edat;
+
+	// Protects the fields below
+	std::mutex mutex;
+
+	// Signaled when a block is decrypted
+	std::condition_variable cv;
+
+	// Cached blocks, most recently used first
+	std::list<std::pair<u32, std::vector<u8>>> lru;
+	std::unordered_map<u32, decltype(lru)::iterator> index;
+
+	// Blocks being decrypted (outside of the lock)
+	std::unordered_set<u32> in_flight;
+
+	// Block following the last read (to detect sequential access)
+	u32 next_block = 0;
+
+	// First block not requested from the worker yet
+	u32 ahead_block = 0;
+
+	// Requests queued to the worker and not yet processed
+	atomic_t<u32> pending{0};
+
+	edat_block_cache(EDATADecrypter& edat)
+		: edat(edat)
+	{
+	}
+
+	~edat_block_cache()
+	{
+		// The worker may still use this cache
+		while (pending)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// Get the block from the cache or decrypt it, returns its size or -1 on error
+	// If prefetch is set, out is only used as a temporary buffer and the block is skipped if it's cached or being decrypted
+	u64 read(u32 block, u8* out, bool prefetch)
+	{
+		std::unique_lock lock(mutex);
+
+		while (true)
+		{
+			if (const auto found = index.find(block); found != index.end())
+			{
+				if (prefetch)
+				{
+					return 0;
+				}
+
+				lru.splice(lru.begin(), lru, found->second);
+				std::memcpy(out, found->second->second.data(), found->second->second.size());
+				return found->second->second.size();
+			}
+
+			if (!in_flight.count(block))
+			{
+				break;
+			}
+
+			if (prefetch)
+			{
+				return 0;
+			}
+
+			// Decrypted by another thread
+			cv.wait(lock);
+		}
+
+		in_flight.emplace(block);
+		lock.unlock();
+
+		const u64 res = edat.DecryptBlock(block, out);
+
+		lock.lock();
+		in_flight.erase(block);
+
+		if (res != -1)
+		{
+			lru.emplace_front(block, std::vector<u8>(out, out + res));
+			index.emplace(block, lru.begin());
+
+			if (lru.size() > max_blocks)
+			{
+				index.erase(lru.back().first);
+				lru.pop_back();
+			}
+		}
+
+		cv.notify_all();
+		return res;
+	}
+
+	// Register read of blocks [first, end), request read-ahead if the access is sequential
+	void on_read(u32 first, u32 end)
+	{
+		std::vector<u32> blocks;
+		{
+			std::lock_guard lock(mutex);
+
+			const bool sequential = first == next_block || first + 1 == next_block;
+			next_block = end;
+
+			if (!sequential)
+			{
+				ahead_block = end;
+				return;
+			}
+
+			const u32 limit = std::min(end + read_ahead, edat.total_blocks);
+
+			for (ahead_block = std::max(ahead_block, end); ahead_block < limit; ahead_block++)
+			{
+				if (!index.count(ahead_block) && !in_flight.count(ahead_block))
+				{
+					blocks.push_back(ahead_block);
+				}
+			}
+		}
+
+		if (blocks.empty())
+		{
+			return;
+		}
+
+		const auto m = g_fxo->get<edat_read_ahead_manager>();
+
+		if (!m)
+		{
+			return;
+		}
+
+		std::lock_guard lock(m->mutex);
+
+		if (!m->thread)
+		{
+			m->thread = std::make_unique<named_thread<edat_read_ahead>>();
+		}
+
+		for (u32 block : blocks)
+		{
+			pending++;
+			m->thread->requests.push(this, block);
+		}
+	}
+};
+
+void edat_read_ahead::operator()()
+{
+	std::vector<u8> buf;
+
+	while (thread_ctrl::state() != thread_state::aborting)
+	{
+		for (auto&& [cache, block] : requests.pop_all())
+		{
+			buf.resize(cache->edat.edatHeader.block_size);
+			cache->read(block, buf.data(), true);
+
+			// The cache may be destroyed after this
+			cache->pending--;
+		}
+
+		requests.wait();
+	}
+
+	// Drop the remaining requests
+	for (auto&& [cache, block] : requests.pop_all())
+	{
+		cache->pending--;
+	}
+}
+
 bool EDATADecrypter::ReadHeader()
 {
 	edata_file.seek(0);
@@ -939,9 +1145,37 @@ bool EDATADecrypter::ReadHeader()
 	file_size = edatHeader.file_size;
 	total_blocks = static_cast<u32>((edatHeader.file_size + edatHeader.block_size - 1) / edatHeader.block_size);
 
+	m_cache = std::make_unique<edat_block_cache>(*this);
 	return true;
 }
 
+EDATADecrypter::EDATADecrypter(fs::file&& input)
+	: edata_file(std::move(input))
+{
+}
+
+EDATADecrypter::EDATADecrypter(fs::file&& input, const std::array<u8, 0x10>& dev_key, const std::array<u8, 0x10>& rif_key)
+	: edata_file(std::move(input))
+	, rif_key(rif_key)
+	, dev_key(dev_key)
+{
+}
+
+EDATADecrypter::~EDATADecrypter()
+{
+}
+
+u64 EDATADecrypter::DecryptBlock(u32 block, u8* out)
+{
+	// File position stays at 0, decrypt_block only uses positional reads
+	return decrypt_block(&edata_file, out, &edatHeader, &npdHeader, dec_key.data(), block, total_blocks, edatHeader.file_size);
+}
+
+u64 EDATADecrypter::ReadBlock(u32 block, u8* out)
+{
+	return m_cache->read(block, out, false);
+}
+
 u64 EDATADecrypter::ReadData(u64 pos, u8* data, u64 size)
 {
 	if (pos > edatHeader.file_size)
@@ -964,8 +1198,7 @@ u64 EDATADecrypter::ReadData(u64 pos, u8* data, u64 size)
 	u64 writeOffset = 0;
 	for (u32 i = starting_block; i < ending_block; ++i)
 	{
-		edata_file.seek(0);
-		u64 res = decrypt_block(&edata_file, &data_buf[writeOffset], &edatHeader, &npdHeader, dec_key.data(), i, total_blocks, edatHeader.file_size);
+		u64 res = ReadBlock(i, &data_buf[writeOffset]);
 		if (res == -1)
 		{
 			edat_log.error("Error Decrypting data");
@@ -974,6 +1207,8 @@ u64 EDATADecrypter::ReadData(u64 pos, u8* data, u64 size)
 		writeOffset += res;
 	}
 
+	m_cache->on_read(starting_block, ending_block);
+
 	const u64 bytesWrote = std::min<u64>(writeOffset - startOffset, size);
 
 	memcpy(data, &data_buf[startOffset], bytesWrote);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <memory>
 
 #include "utils.h"
 
@@ -48,6 +49,9 @@ extern bool VerifyEDATHeaderWithKLicense(const fs::file& input, const std::strin
 
 extern std::array<u8, 0x10> GetEdatRifKeyFromRapFile(const fs::file& rap_file);
 
+// Decrypted block cache with shared read-ahead thread (unedat.cpp)
+struct edat_block_cache;
+
 struct EDATADecrypter final : fs::file_base
 {
 	// file stream
@@ -68,15 +72,22 @@ struct EDATADecrypter final : fs::file_base
 	// edat usage
 	std::array<u8, 0x10> rif_key{};
 	std::array<u8, 0x10> dev_key{};
+
+	// Created by ReadHeader()
+	std::unique_ptr<edat_block_cache> m_cache;
+
+	// Decrypt single block (through the cache)
+	u64 ReadBlock(u32 block, u8* out);
+
+	// Decrypt single block (bypassing the cache, thread-safe)
+	u64 DecryptBlock(u32 block, u8* out);
 public:
 	// SdataByFd usage
-	EDATADecrypter(fs::file&& input)
-		: edata_file(std::move(input)) {}
+	EDATADecrypter(fs::file&& input);
 	// Edat usage
-	EDATADecrypter(fs::file&& input, const std::array<u8, 0x10>& dev_key, const std::array<u8, 0x10>& rif_key)
-		: edata_file(std::move(input)), rif_key(rif_key), dev_key(dev_key) {}
+	EDATADecrypter(fs::file&& input, const std::array<u8, 0x10>& dev_key, const std::array<u8, 0x10>& rif_key);
 
-	~EDATADecrypter() override {}
+	~EDATADecrypter() override;
 	// false if invalid
 	bool ReadHeader();
 	u64 ReadData(u64 pos, u8* data, u64 size);
@@ -102,6 +113,10 @@ public:
 		pos += bytesRead;
 		return bytesRead;
 	}
+	u64 read_at(u64 offset, void* buffer, u64 size) override
+	{
+		return ReadData(offset, static_cast<u8*>(buffer), size);
+	}
 	u64 write(const void* buffer, u64 size) override
 	{
 		return 0;
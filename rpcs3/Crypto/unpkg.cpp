@@ -1,13 +1,18 @@
 ﻿#include "stdafx.h"
 #include "utils.h"
 #include "aes.h"
+#include "aesni.h"
 #include "sha1.h"
 #include "key_vault.h"
 #include "Utilities/StrFmt.h"
+#include "Utilities/Thread.h"
 #include "Emu/System.h"
 #include "Emu/VFS.h"
 #include "unpkg.h"
 
+#include <deque>
+#include <thread>
+
 LOG_CHANNEL(pkg_log, "PKG");
 
 bool pkg_install(const std::string& path, atomic_t<double>& sync)
@@ -217,16 +222,49 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 		return false;
 	}
 
-	// Allocate buffer with BUF_SIZE size or more if required
-	const std::unique_ptr<u128[]> buf(new u128[std::max<u64>(BUF_SIZE, sizeof(PKGEntry) * header.file_count) / sizeof(u128)]);
+	// Get part sizes for positional reads
+	std::vector<u64> part_sizes;
+
+	for (const auto& part : filelist)
+	{
+		part_sizes.push_back(part.size());
+	}
 
-	// Define decryption subfunction (`psp` arg selects the key for specific block)
-	auto decrypt = [&](u64 offset, u64 size, const uchar* key) -> u64
+	// Read from any position of the archive (thread-safe, native files implement positional reads on every platform)
+	auto archive_read_at = [&](u64 offset, void* data_ptr, u64 num_bytes) -> u64
 	{
-		archive_seek(header.data_offset + offset);
+		u64 result = 0;
+
+		for (u32 i = 0; i < filelist.size() && num_bytes; i++)
+		{
+			if (offset >= part_sizes[i])
+			{
+				offset -= part_sizes[i];
+				continue;
+			}
+
+			const u64 count = std::min<u64>(part_sizes[i] - offset, num_bytes);
+			const u64 num_read = filelist[i].read_at(offset, static_cast<u8*>(data_ptr) + result, count);
+
+			result += num_read;
+
+			if (num_read != count)
+			{
+				break;
+			}
+
+			num_bytes -= count;
+			offset = 0;
+		}
 
+		return result;
+	};
+
+	// Define decryption subfunction (reads and decrypts the data into given buffer, thread-safe)
+	auto decrypt = [&](u64 offset, u64 size, const uchar* key, u128* buf) -> u64
+	{
 		// Read the data and set available size
-		const u64 read = archive_read(buf.get(), size);
+		const u64 read = archive_read_at(header.data_offset + offset, buf, size);
 
 		// Get block count
 		const u64 blocks = (read + 15) / 16;
@@ -269,6 +307,13 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 			// Initialize stream cipher for start position
 			be_t<u128> input = header.klicensee.value() + offset / 16;
 
+			if (aesni_supports(POLARSSL_AESNI_AES))
+			{
+				// Generate the keystream and apply it in one pass
+				aesni_crypt_ctr(&ctx, blocks * 16, reinterpret_cast<u8*>(&input), reinterpret_cast<const u8*>(buf), reinterpret_cast<u8*>(buf));
+				return read;
+			}
+
 			// Increment stream position for every block
 			for (u64 i = 0; i < blocks; i++, input++)
 			{
@@ -284,6 +329,9 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 		return read;
 	};
 
+	// Buffer for the entry table and names
+	const std::unique_ptr<u128[]> buf(new u128[(std::max<u64>(sizeof(PKGEntry) * header.file_count, 256) + 15) / 16]);
+
 	std::array<uchar, 16> dec_key;
 
 	if (header.pkg_platform == PKG_PLATFORM_TYPE_PSP && content_type >= 0x15 && content_type <= 0x17)
@@ -295,12 +343,12 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 		aes_context ctx;
 		aes_setkey_enc(&ctx, content_type == 0x15 ? psp2t1 : content_type == 0x16 ? psp2t2 : psp2t3, 128);
 		aes_crypt_ecb(&ctx, AES_ENCRYPT, reinterpret_cast<const uchar*>(&header.klicensee), dec_key.data());
-		decrypt(0, header.file_count * sizeof(PKGEntry), dec_key.data());
+		decrypt(0, header.file_count * sizeof(PKGEntry), dec_key.data(), buf.get());
 	}
 	else
 	{
 		std::memcpy(dec_key.data(), PKG_AES_KEY, dec_key.size());
-		decrypt(0, header.file_count * sizeof(PKGEntry), header.pkg_platform == PKG_PLATFORM_TYPE_PSP ? PKG_AES_KEY2 : dec_key.data());
+		decrypt(0, header.file_count * sizeof(PKGEntry), header.pkg_platform == PKG_PLATFORM_TYPE_PSP ? PKG_AES_KEY2 : dec_key.data(), buf.get());
 	}
 
 	size_t num_failures = 0;
@@ -309,6 +357,20 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 
 	std::memcpy(entries.data(), buf.get(), entries.size() * sizeof(PKGEntry));
 
+	// File to extract
+	struct pkg_file
+	{
+		std::string path;
+		std::string name;
+		u64 offset;
+		u64 size;
+		const uchar* key;
+		bool did_overwrite;
+	};
+
+	std::vector<pkg_file> files;
+
+	// Create directories and output files in the entry order
 	for (const auto& entry : entries)
 	{
 		const bool is_psp = (entry.type & PKG_FILE_ENTRY_PSP) != 0;
@@ -320,7 +382,7 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 			continue;
 		}
 
-		decrypt(entry.name_offset, entry.name_size, is_psp ? PKG_AES_KEY2 : dec_key.data());
+		decrypt(entry.name_offset, entry.name_size, is_psp ? PKG_AES_KEY2 : dec_key.data(), buf.get());
 
 		std::string name{reinterpret_cast<char*>(buf.get()), entry.name_size};
 
@@ -352,55 +414,9 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 
 			if (fs::file out{path, fs::rewrite})
 			{
-				bool extract_success = true;
-				for (u64 pos = 0; pos < entry.file_size; pos += BUF_SIZE)
-				{
-					const u64 block_size = std::min<u64>(BUF_SIZE, entry.file_size - pos);
-
-					if (decrypt(entry.file_offset + pos, block_size, is_psp ? PKG_AES_KEY2 : dec_key.data()) != block_size)
-					{
-						extract_success = false;
-						pkg_log.error("Failed to extract file %s", path);
-						break;
-					}
-
-					if (out.write(buf.get(), block_size) != block_size)
-					{
-						extract_success = false;
-						pkg_log.error("Failed to write file %s", path);
-						break;
-					}
-
-					if (sync.fetch_add((block_size + 0.0) / header.data_size) < 0.)
-					{
-						if (was_null)
-						{
-							pkg_log.error("Package installation cancelled: %s", dir);
-							out.close();
-							fs::remove_all(dir, true);
-							return false;
-						}
-
-						// Cannot cancel the installation
-						sync += 1.;
-					}
-				}
-
-				if (extract_success)
-				{
-					if (did_overwrite)
-					{
-						pkg_log.warning("Overwritten file %s", name);
-					}
-					else
-					{
-						pkg_log.notice("Created file %s", name);
-					}
-				}
-				else
-				{
-					num_failures++;
-				}
+				// Preallocate the file, the data is written by the workers
+				out.trunc(entry.file_size);
+				files.push_back(pkg_file{path, std::move(name), entry.file_offset, entry.file_size, is_psp ? PKG_AES_KEY2 : dec_key.data(), did_overwrite});
 			}
 			else
 			{
@@ -441,6 +457,130 @@ bool pkg_install(const std::string& path, atomic_t<double>& sync)
 		}
 	}
 
+	// Split the files into independent blocks (file index, position), ordered by archive offset
+	std::vector<std::pair<u32, u64>> jobs;
+
+	for (u32 i = 0; i < files.size(); i++)
+	{
+		for (u64 pos = 0; pos < files[i].size; pos += BUF_SIZE)
+		{
+			jobs.emplace_back(i, pos);
+		}
+	}
+
+	// Entries are not necessarily stored in entry order, read the archive sequentially
+	std::stable_sort(jobs.begin(), jobs.end(), [&](const std::pair<u32, u64>& a, const std::pair<u32, u64>& b)
+	{
+		return files[a.first].offset + a.second < files[b.first].offset + b.second;
+	});
+
+	std::vector<atomic_t<bool>> failed(files.size());
+
+	atomic_t<std::size_t> next_job = 0;
+	atomic_t<bool> cancelled = false;
+	atomic_t<bool> cancel_ignored = false;
+	atomic_t<u64> extracted = 0;
+
+	// Every worker reads, decrypts and writes its own blocks, so the stages of different blocks overlap
+	auto worker = [&]()
+	{
+		const std::unique_ptr<u128[]> wbuf(new u128[BUF_SIZE / sizeof(u128)]);
+
+		fs::file out;
+		u32 out_index = -1;
+
+		for (std::size_t index; !cancelled && (index = next_job++) < jobs.size();)
+		{
+			const auto [file_index, pos] = jobs[index];
+			const pkg_file& file = files[file_index];
+
+			if (failed[file_index])
+			{
+				continue;
+			}
+
+			if (out_index != file_index)
+			{
+				out_index = file_index;
+				out.open(file.path, fs::write);
+			}
+
+			const u64 block_size = std::min<u64>(BUF_SIZE, file.size - pos);
+
+			if (decrypt(file.offset + pos, block_size, file.key, wbuf.get()) != block_size)
+			{
+				failed[file_index] = true;
+				pkg_log.error("Failed to extract file %s", file.path);
+				continue;
+			}
+
+			if (!out || out.seek(pos) != pos || out.write(wbuf.get(), block_size) != block_size)
+			{
+				failed[file_index] = true;
+				pkg_log.error("Failed to write file %s", file.path);
+				continue;
+			}
+
+			extracted += block_size;
+
+			if (sync.fetch_add((block_size + 0.0) / header.data_size) < 0.)
+			{
+				if (was_null)
+				{
+					cancelled = true;
+					break;
+				}
+
+				// Cannot cancel the installation
+				if (!cancel_ignored.exchange(true))
+				{
+					sync += 1.;
+				}
+			}
+		}
+	};
+
+	const u64 start_time = get_system_time();
+	const u32 thread_count = std::clamp<u32>(std::thread::hardware_concurrency(), 1, 8);
+
+	{
+		std::deque<named_thread<std::function<void()>>> workers;
+
+		for (u32 i = 1; i < std::min<std::size_t>(thread_count, jobs.size()); i++)
+		{
+			workers.emplace_back(fmt::format("PKG Worker %u", i), worker);
+		}
+
+		worker();
+	}
+
+	if (cancelled)
+	{
+		pkg_log.error("Package installation cancelled: %s", dir);
+		fs::remove_all(dir, true);
+		return false;
+	}
+
+	const double elapsed = (get_system_time() - start_time) / 1000000.;
+
+	pkg_log.notice("Extracted %.2f MB in %.3f s (%.2f MB/s, %u threads)", extracted / 1048576., elapsed, extracted / 1048576. / std::max(elapsed, 0.001), thread_count);
+
+	for (u32 i = 0; i < files.size(); i++)
+	{
+		if (failed[i])
+		{
+			num_failures++;
+		}
+		else if (files[i].did_overwrite)
+		{
+			pkg_log.warning("Overwritten file %s", files[i].name);
+		}
+		else
+		{
+			pkg_log.notice("Created file %s", files[i].name);
+		}
+	}
+
 	if (num_failures == 0)
 	{
 		pkg_log.success("Package successfully installed to %s", dir);
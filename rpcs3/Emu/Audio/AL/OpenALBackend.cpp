@@ -195,14 +195,4 @@ u64 OpenALBackend::GetNumEnqueuedSamples()
 
 	// Return
 	return (num_queued * AUDIO_BUFFER_SAMPLES) + (sample_pos % AUDIO_BUFFER_SAMPLES);
-}
-
-f32 OpenALBackend::SetFrequencyRatio(f32 new_ratio)
-{
-	new_ratio = std::clamp(new_ratio, 0.5f, 2.0f);
-
-	alSourcef(m_source, AL_PITCH, new_ratio);
-	checkForAlError("SetFrequencyRatio->alSourcei(AL_PITCH)");
-
-	return new_ratio;
 }
\ No newline at end of file
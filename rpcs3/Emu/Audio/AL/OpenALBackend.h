@@ -26,7 +26,7 @@ public:
 
 	virtual const char* GetName() const override { return "OpenAL"; }
 
-	static const u32 capabilities = PLAY_PAUSE_FLUSH | IS_PLAYING | GET_NUM_ENQUEUED_SAMPLES | SET_FREQUENCY_RATIO;
+	static const u32 capabilities = PLAY_PAUSE_FLUSH | IS_PLAYING | GET_NUM_ENQUEUED_SAMPLES;
 	virtual u32 GetCapabilities() const override { return capabilities; }
 
 	virtual void Open(u32 num_buffers) override;
@@ -40,5 +40,4 @@ public:
 	virtual void Flush() override;
 
 	virtual u64 GetNumEnqueuedSamples() override;
-	virtual f32 SetFrequencyRatio(f32 new_ratio) override;
 };
\ No newline at end of file
@@ -18,7 +18,6 @@ public:
 		PLAY_PAUSE_FLUSH = 0x1, // Implements Play, Pause, Flush
 		IS_PLAYING = 0x2, // Implements IsPlaying
 		GET_NUM_ENQUEUED_SAMPLES = 0x4, // Implements GetNumEnqueuedSamples
-		SET_FREQUENCY_RATIO = 0x8, // Implements SetFrequencyRatio
 	};
 
 	virtual ~AudioBackend() = default;
@@ -76,14 +75,6 @@ public:
 		return 0;
 	}
 
-	// Sets a new frequency ratio. Backend is allowed to modify the ratio value, e.g. clamping it to the allowed range
-	// Returns the new frequency ratio set
-	// Should be implemented if capabilities & SET_FREQUENCY_RATIO
-	virtual f32 SetFrequencyRatio(f32 /* new_ratio */) // returns the new ratio
-	{
-		fmt::throw_exception("SetFrequencyRatio() not implemented");
-		return 1.0f;
-	}
 
 
 	/*
@@ -139,12 +130,6 @@ public:
 			count++;
 		}
 
-		if (capabilities & SET_FREQUENCY_RATIO)
-		{
-			fmt::append(out, "%sSET_FREQUENCY_RATIO", count > 0 ? " | " : "");
-			count++;
-		}
-
 		if (count == 0)
 		{
 			fmt::append(out, "NONE");
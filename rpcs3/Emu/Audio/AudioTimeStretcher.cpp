@@ -0,0 +1,208 @@
+#include "stdafx.h"
+#include "AudioTimeStretcher.h"
+
+#include <cmath>
+
+namespace
+{
+	// Dot product of two float arrays (size must be a multiple of 8)
+	float dot_product(const float* a, const float* b, u32 size)
+	{
+		__m128 s0 = _mm_setzero_ps();
+		__m128 s1 = _mm_setzero_ps();
+
+		for (u32 i = 0; i < size; i += 8)
+		{
+			s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i + 0), _mm_loadu_ps(b + i + 0)));
+			s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+		}
+
+		s0 = _mm_add_ps(s0, s1);
+		s0 = _mm_add_ps(s0, _mm_movehl_ps(s0, s0));
+		s0 = _mm_add_ss(s0, _mm_shuffle_ps(s0, s0, 1));
+		return _mm_cvtss_f32(s0);
+	}
+}
+
+audio_time_stretcher::audio_time_stretcher(u32 channels)
+	: m_channels(channels)
+	, m_tail(hop * channels)
+	, m_window(window * channels)
+{
+	// Periodic Hann window (overlapping halves sum to 1)
+	for (u32 i = 0; i < hop; i++)
+	{
+		const f32 w = static_cast<f32>(0.5 - 0.5 * std::cos(2. * 3.14159265358979323846 * i / window));
+
+		for (u32 c = 0; c < channels; c++)
+		{
+			m_window[i * channels + c] = w;
+			m_window[(i + hop) * channels + c] = 1.0f - w;
+		}
+	}
+
+	m_input.reserve((window * 2 + tolerance) * channels);
+}
+
+void audio_time_stretcher::push(const float* in)
+{
+	m_input.insert(m_input.end(), in, in + hop * m_channels);
+}
+
+u64 audio_time_stretcher::find_best_position(u64 ideal)
+{
+	const u64 first = std::max<u64>(ideal - std::min<u64>(ideal, tolerance), m_base);
+	const u64 last = ideal + tolerance;
+	const u64 ref = m_prev + hop;
+	const u32 count = static_cast<u32>(last - first + hop);
+
+	// Downmix candidates and the natural continuation of the previous segment to mono
+	m_mono.resize(count + hop);
+
+	const auto downmix = [&](u64 pos, u32 frames, float* out)
+	{
+		const float* in = get_frame(pos);
+
+		for (u32 i = 0; i < frames; i++, in += m_channels)
+		{
+			float sum = 0.0f;
+
+			for (u32 c = 0; c < m_channels; c++)
+			{
+				sum += in[c];
+			}
+
+			out[i] = sum;
+		}
+	};
+
+	float* const cand = m_mono.data();
+	float* const cont = cand + count;
+	downmix(first, count, cand);
+	downmix(ref, hop, cont);
+
+	// Maximize normalized cross-correlation (sliding candidate energy)
+	f32 energy = dot_product(cand, cand, hop);
+	f32 best_score = -1.0f;
+	u64 best = std::clamp(ideal, first, last);
+
+	for (u64 pos = first; pos <= last; pos++)
+	{
+		const u32 i = static_cast<u32>(pos - first);
+
+		if (energy > 1e-9f)
+		{
+			const f32 score = dot_product(cont, cand + i, hop) / std::sqrt(energy);
+
+			if (score > best_score)
+			{
+				best_score = score;
+				best = pos;
+			}
+		}
+
+		if (pos < last)
+		{
+			energy = std::max(energy + cand[i + hop] * cand[i + hop] - cand[i] * cand[i], 0.0f);
+		}
+	}
+
+	return best;
+}
+
+bool audio_time_stretcher::pop(float* out, f32 ratio)
+{
+	ratio = std::clamp(ratio, min_ratio, 1.0f);
+
+	const u64 end = get_end();
+	const u32 size = hop * m_channels;
+
+	u64 pos;
+
+	if (!m_started)
+	{
+		if (end < m_base + window)
+		{
+			return false;
+		}
+
+		// Initialize the tail so the first block reproduces the input
+		pos = m_base;
+		const float* in = get_frame(pos);
+
+		for (u32 i = 0; i < size; i++)
+		{
+			m_tail[i] = in[i] * m_window[size + i];
+		}
+
+		m_ideal = static_cast<f64>(pos);
+		m_started = true;
+	}
+	else if (ratio == 1.0f)
+	{
+		// Natural continuation of the previous segment (exact reconstruction)
+		pos = m_prev + hop;
+
+		if (pos + window > end)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		const u64 ideal = static_cast<u64>(m_ideal + 0.5);
+
+		if (ideal + tolerance + window > end)
+		{
+			return false;
+		}
+
+		pos = find_best_position(ideal);
+	}
+
+	// Overlap-add the first half of the segment and keep the second half
+	const float* in = get_frame(pos);
+
+	for (u32 i = 0; i < size; i += 4)
+	{
+		const __m128 x = _mm_mul_ps(_mm_loadu_ps(in + i), _mm_loadu_ps(m_window.data() + i));
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(m_tail.data() + i), x));
+		_mm_storeu_ps(m_tail.data() + i, _mm_mul_ps(_mm_loadu_ps(in + size + i), _mm_loadu_ps(m_window.data() + size + i)));
+	}
+
+	m_prev = pos;
+	m_ideal = ratio == 1.0f ? static_cast<f64>(pos + hop) : m_ideal + hop * ratio;
+
+	// Drop the input which can't be used anymore
+	const u64 ideal = static_cast<u64>(m_ideal);
+	const u64 keep = std::min<u64>(m_prev + hop, ideal - std::min<u64>(ideal, tolerance));
+
+	if (keep > m_base)
+	{
+		m_input.erase(m_input.begin(), m_input.begin() + (keep - m_base) * m_channels);
+		m_base = keep;
+	}
+
+	return true;
+}
+
+u64 audio_time_stretcher::get_buffered_frames() const
+{
+	const u64 end = get_end();
+
+	if (!m_started)
+	{
+		return end - m_base;
+	}
+
+	return end - std::min<u64>(end, m_prev + hop);
+}
+
+void audio_time_stretcher::reset()
+{
+	m_input.clear();
+	m_base = 0;
+	m_ideal = 0.;
+	m_prev = 0;
+	m_started = false;
+}
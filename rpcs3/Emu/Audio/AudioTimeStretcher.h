@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Utilities/types.h"
+#include "AudioBackend.h"
+
+#include <vector>
+
+// Pitch-preserving time stretcher (WSOLA), works on interleaved float blocks of AUDIO_BUFFER_SAMPLES frames
+class audio_time_stretcher
+{
+public:
+	// Output hop (one output block per segment)
+	static constexpr u32 hop = AUDIO_BUFFER_SAMPLES;
+
+	// Segment length (segments overlap by half)
+	static constexpr u32 window = hop * 2;
+
+	// Maximum segment position deviation (frames) searched for the best alignment
+	static constexpr u32 tolerance = 128;
+
+	// Minimum supported ratio (output is at most twice as long as input)
+	static constexpr f32 min_ratio = 0.5f;
+
+private:
+	const u32 m_channels;
+
+	// Buffered input frames (first frame has absolute position m_base)
+	std::vector<float> m_input;
+	u64 m_base = 0;
+
+	// Second half of the previous windowed segment
+	std::vector<float> m_tail;
+
+	// Window function expanded for every channel
+	std::vector<float> m_window;
+
+	// Mono downmix scratch buffer for the alignment search
+	std::vector<float> m_mono;
+
+	// Ideal position of the next segment
+	f64 m_ideal = 0.;
+
+	// Position of the previous segment
+	u64 m_prev = 0;
+
+	bool m_started = false;
+
+	u64 get_end() const
+	{
+		return m_base + m_input.size() / m_channels;
+	}
+
+	const float* get_frame(u64 pos) const
+	{
+		return m_input.data() + (pos - m_base) * m_channels;
+	}
+
+	// Find the segment position around the ideal one which fits the natural continuation of the previous segment best
+	u64 find_best_position(u64 ideal);
+
+public:
+	audio_time_stretcher(u32 channels);
+
+	// Append one input block
+	void push(const float* in);
+
+	// Produce one output block, returns false if more input is required (ratio = input speed / output speed)
+	bool pop(float* out, f32 ratio);
+
+	// Number of frames buffered in the stretcher (not yet output)
+	u64 get_buffered_frames() const;
+
+	// Drop all buffered data
+	void reset();
+};
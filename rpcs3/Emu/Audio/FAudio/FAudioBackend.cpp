@@ -166,18 +166,3 @@ u64 FAudioBackend::GetNumEnqueuedSamples()
 	// all buffers contain AUDIO_BUFFER_SAMPLES, so we can easily calculate how many samples there are remaining
 	return (AUDIO_BUFFER_SAMPLES - state.SamplesPlayed % AUDIO_BUFFER_SAMPLES) + (state.BuffersQueued * AUDIO_BUFFER_SAMPLES);
 }
-
-f32 FAudioBackend::SetFrequencyRatio(f32 new_ratio)
-{
-	new_ratio = std::clamp(new_ratio, FAUDIO_MIN_FREQ_RATIO, FAUDIO_DEFAULT_FREQ_RATIO);
-
-	u32 res = FAudioSourceVoice_SetFrequencyRatio(m_source_voice, new_ratio, FAUDIO_COMMIT_NOW);
-	if (res)
-	{
-		FAudio_.error("FAudioSourceVoice_SetFrequencyRatio() failed(0x%08x)", res);
-		Emu.Pause();
-		return 1.0f;
-	}
-
-	return new_ratio;
-}
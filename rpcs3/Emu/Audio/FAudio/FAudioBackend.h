@@ -23,7 +23,7 @@ public:
 		return "FAudio";
 	};
 
-	static const u32 capabilities = PLAY_PAUSE_FLUSH | IS_PLAYING | GET_NUM_ENQUEUED_SAMPLES | SET_FREQUENCY_RATIO;
+	static const u32 capabilities = PLAY_PAUSE_FLUSH | IS_PLAYING | GET_NUM_ENQUEUED_SAMPLES;
 	virtual u32 GetCapabilities() const override
 	{
 		return capabilities;
@@ -40,5 +40,4 @@ public:
 	virtual void Flush() override;
 
 	virtual u64 GetNumEnqueuedSamples() override;
-	virtual f32 SetFrequencyRatio(f32 new_ratio) override;
 };
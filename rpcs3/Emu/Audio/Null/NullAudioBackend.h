@@ -4,21 +4,24 @@
 
 class NullAudioBackend : public AudioBackend
 {
+	bool m_playing = false;
+
 public:
 	NullAudioBackend() {}
 	virtual ~NullAudioBackend() {}
 
 	virtual const char* GetName() const override { return "Null"; }
 
-	static const u32 capabilities = PLAY_PAUSE_FLUSH;
+	static const u32 capabilities = PLAY_PAUSE_FLUSH | IS_PLAYING;
 	virtual u32 GetCapabilities() const override { return capabilities; }
 
 	virtual void Open(u32) override {}
 	virtual void Close() override {}
 
-	virtual void Play() override {}
-	virtual void Pause() override {}
+	virtual void Play() override { m_playing = true; }
+	virtual void Pause() override { m_playing = false; }
+	virtual bool IsPlaying() override { return m_playing; }
 
 	virtual bool AddData(const void*, u32) override { return true; }
-	virtual void Flush() override {}
+	virtual void Flush() override { m_playing = false; }
 };
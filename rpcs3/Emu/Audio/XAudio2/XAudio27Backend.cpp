@@ -182,21 +182,6 @@ public:
 		// all buffers contain AUDIO_BUFFER_SAMPLES, so we can easily calculate how many samples there are remaining
 		return (AUDIO_BUFFER_SAMPLES - state.SamplesPlayed % AUDIO_BUFFER_SAMPLES) + (state.BuffersQueued * AUDIO_BUFFER_SAMPLES);
 	}
-
-	virtual f32 set_freq_ratio(f32 new_ratio) override
-	{
-		new_ratio = std::clamp(new_ratio, XAUDIO2_MIN_FREQ_RATIO, XAUDIO2_DEFAULT_FREQ_RATIO);
-
-		HRESULT hr = tls_source_voice->SetFrequencyRatio(new_ratio);
-		if (FAILED(hr))
-		{
-			XAudio.error("SetFrequencyRatio() failed(0x%08x)", (u32)hr);
-			Emu.Pause();
-			return 1.0f;
-		}
-
-		return new_ratio;
-	}
 };
 
 XAudio2Backend::XAudio2Library* XAudio2Backend::xa27_init(void* lib2_7)
@@ -87,8 +87,3 @@ u64 XAudio2Backend::GetNumEnqueuedSamples()
 {
 	return lib->enqueued_samples();
 }
-
-f32 XAudio2Backend::SetFrequencyRatio(f32 new_ratio)
-{
-	return lib->set_freq_ratio(new_ratio);
-}
@@ -20,7 +20,6 @@ public:
 		virtual bool is_playing() = 0;
 		virtual bool add(const void*, u32) = 0;
 		virtual u64 enqueued_samples() = 0;
-		virtual f32 set_freq_ratio(f32) = 0;
 	};
 
 private:
@@ -35,7 +34,7 @@ public:
 
 	virtual const char* GetName() const override { return "XAudio2"; };
 
-	static const u32 capabilities = PLAY_PAUSE_FLUSH | IS_PLAYING | GET_NUM_ENQUEUED_SAMPLES | SET_FREQUENCY_RATIO;
+	static const u32 capabilities = PLAY_PAUSE_FLUSH | IS_PLAYING | GET_NUM_ENQUEUED_SAMPLES;
 	virtual u32 GetCapabilities() const override { return capabilities;	};
 
 	virtual void Open(u32 /* num_buffers */) override;
@@ -49,5 +48,4 @@ public:
 	virtual void Flush() override;
 
 	virtual u64 GetNumEnqueuedSamples() override;
-	virtual f32 SetFrequencyRatio(f32 new_ratio) override;
 };
@@ -3,10 +3,12 @@
 
 #include "Emu/System.h"
 #include "Emu/Memory/vm_locking.h"
+#include "Emu/Memory/vm_reservation.h"
 #include "Emu/IdManager.h"
 #include "Emu/GDB.h"
 #include "Emu/Cell/PPUThread.h"
 #include "Emu/Cell/SPUThread.h"
+#include "Emu/RSX/rsx_write_tracker.h"
 
 #include <thread>
 #include <unordered_map>
@@ -348,6 +350,9 @@ void cpu_thread::operator()()
 	state += cpu_flag::wait;
 	g_cpu_suspend_lock.lock_unlock();
 
+	// Write faults must be handled on this thread (see rsx::write_tracker)
+	rsx::g_write_tracker.register_guest_thread();
+
 	// Check thread status
 	while (!(state & (cpu_flag::exit + cpu_flag::dbg_global_stop)) && thread_ctrl::state() != thread_state::aborting)
 	{
@@ -378,6 +383,10 @@ void cpu_thread::operator()()
 		ptr->compare_and_swap(this, nullptr);
 	}
 
+	vm::reservation_stats_flush();
+
+	rsx::g_write_tracker.unregister_guest_thread();
+
 	// Unregister and wait if necessary
 	state += cpu_flag::wait;
 	verify("g_cpu_array[...] -> null" HERE), g_cpu_array[array_slot].exchange(nullptr) == this;
@@ -6,15 +6,34 @@
 #include "Emu/Cell/lv2/sys_process.h"
 #include "Emu/Cell/lv2/sys_event.h"
 #include "cellAudio.h"
+#include "Utilities/sysinfo.h"
 #include <atomic>
 #include <cmath>
+#include <chrono>
+#include <random>
+
+#if defined(_MSC_VER)
+#define SSSE3_FUNC
+#define AVX2_FUNC
+#else
+#define SSSE3_FUNC __attribute__((__target__("ssse3")))
+#define AVX2_FUNC __attribute__((__target__("avx2")))
+#endif // _MSC_VER
 
 LOG_CHANNEL(cellAudio);
 
+const bool s_use_ssse3 = utils::has_ssse3();
+const bool s_use_avx2 = utils::has_avx2();
+
 vm::gvar<char, AUDIO_PORT_OFFSET * AUDIO_PORT_COUNT> g_audio_buffer;
 
 vm::gvar<u64, AUDIO_PORT_COUNT> g_audio_indices;
 
+namespace audio_mix
+{
+	static void self_test();
+}
+
 template <>
 void fmt_class_string<CellAudioError>::format(std::string& out, u64 arg)
 {
@@ -51,10 +70,6 @@ cell_audio_config::cell_audio_config()
 	{
 		cellAudio.error("Audio backend %s does not support buffering, this option will be ignored.", backend->GetName());
 	}
-	if (raw_time_stretching_enabled && !time_stretching_enabled)
-	{
-		cellAudio.error("Audio backend %s does not support time stretching, this option will be ignored.", backend->GetName());
-	}
 }
 
 
@@ -109,21 +124,6 @@ audio_ringbuffer::~audio_ringbuffer()
 	backend->Close();
 }
 
-f32 audio_ringbuffer::set_frequency_ratio(f32 new_ratio)
-{
-	if (!has_capability(AudioBackend::SET_FREQUENCY_RATIO))
-	{
-		ASSERT(new_ratio == 1.0f);
-		frequency_ratio = 1.0f;
-	}
-	else
-	{
-		frequency_ratio = backend->SetFrequencyRatio(new_ratio);
-		//cellAudio.trace("set_frequency_ratio(%1.2f) -> %1.2f", new_ratio, frequency_ratio);
-	}
-	return frequency_ratio;
-}
-
 void audio_ringbuffer::enqueue(const float* in_buffer)
 {
 	AUDIT(cur_pos < cfg.num_allocated_buffers);
@@ -184,11 +184,6 @@ void audio_ringbuffer::play()
 		return;
 	}
 
-	if (frequency_ratio != 1.0f)
-	{
-		set_frequency_ratio(1.0f);
-	}
-
 	playing = true;
 
 	ASSERT(enqueued_samples > 0);
@@ -212,11 +207,6 @@ void audio_ringbuffer::flush()
 
 	backend->Flush();
 
-	if (frequency_ratio != 1.0f)
-	{
-		set_frequency_ratio(1.0f);
-	}
-
 	enqueued_samples = 0;
 }
 
@@ -258,7 +248,7 @@ u64 audio_ringbuffer::update()
 		{
 			const u64 play_delta = timestamp - (play_timestamp > update_timestamp ? play_timestamp : update_timestamp);
 
-			const u64 delta_samples_tmp = play_delta * static_cast<u64>(cfg.audio_sampling_rate * frequency_ratio) + last_remainder;
+			const u64 delta_samples_tmp = play_delta * u64{cfg.audio_sampling_rate} + last_remainder;
 			last_remainder = delta_samples_tmp % 1'000'000;
 			const u64 delta_samples = delta_samples_tmp / 1'000'000;
 
@@ -444,7 +434,7 @@ void cell_audio_thread::advance(u64 timestamp, bool reset)
 	if (cfg.buffering_enabled)
 	{
 		// Calculate rolling average of enqueued playtime
-		const u64 enqueued_playtime = ringbuffer->get_enqueued_playtime(/* raw */ true);
+		const u64 enqueued_playtime = ringbuffer->get_enqueued_playtime();
 		m_average_playtime = cfg.period_average_alpha * enqueued_playtime + (1.0f - cfg.period_average_alpha) * m_average_playtime;
 		//cellAudio.error("m_average_playtime=%4.2f, enqueued_playtime=%u", m_average_playtime, enqueued_playtime);
 	}
@@ -479,9 +469,19 @@ void cell_audio_thread::operator()()
 {
 	thread_ctrl::set_native_priority(1);
 
+	if (g_cfg.audio.mixer_self_test)
+	{
+		audio_mix::self_test();
+	}
+
 	// Allocate ringbuffer
 	ringbuffer.reset(new audio_ringbuffer(cfg));
 
+	if (cfg.time_stretching_enabled)
+	{
+		stretcher = std::make_unique<audio_time_stretcher>(cfg.audio_channels);
+	}
+
 	// Initialize loop variables
 	m_counter = 0;
 	m_start_time = ringbuffer->get_timestamp();
@@ -520,8 +520,7 @@ void cell_audio_thread::operator()()
 		else
 		{
 			const u64 enqueued_samples = ringbuffer->get_enqueued_samples();
-			f32 frequency_ratio = ringbuffer->get_frequency_ratio();
-			u64 enqueued_playtime = ringbuffer->get_enqueued_playtime();
+			const u64 enqueued_playtime = ringbuffer->get_enqueued_playtime();
 			const u64 enqueued_buffers = enqueued_samples / AUDIO_BUFFER_SAMPLES;
 
 			const bool playing = ringbuffer->is_playing();
@@ -550,49 +549,39 @@ void cell_audio_thread::operator()()
 					desired_duration_adjusted /= std::max(average_playtime_ratio, 0.25f);
 				}
 
+				// Audio held by the stretcher counts as buffered (keeps the total latency unchanged)
+				const u64 stretcher_playtime = stretcher ? stretcher->get_buffered_frames() * 1'000'000 / cfg.audio_sampling_rate : 0;
+
 				if (cfg.time_stretching_enabled)
 				{
-					// Calculate what the playtime is without a frequency ratio
-					const u64 raw_enqueued_playtime = ringbuffer->get_enqueued_playtime(/* raw= */ true);
-
 					//  1.0 means exactly as desired
 					// <1.0 means not as full as desired
 					// >1.0 means more full than desired
-					const f32 desired_duration_rate = raw_enqueued_playtime / desired_duration_adjusted;
+					const f32 desired_duration_rate = (enqueued_playtime + stretcher_playtime) / desired_duration_adjusted;
 
-					// update frequency ratio if necessary
-					f32 new_ratio = frequency_ratio;
+					// update stretch ratio if necessary
 					if (desired_duration_rate < cfg.time_stretching_threshold)
 					{
 						const f32 normalized_desired_duration_rate = desired_duration_rate / cfg.time_stretching_threshold;
-						const f32 request_ratio = normalized_desired_duration_rate * cfg.time_stretching_scale;
+						const f32 request_ratio = std::max(normalized_desired_duration_rate * cfg.time_stretching_scale, audio_time_stretcher::min_ratio);
 						AUDIT(request_ratio <= 1.0f);
 
-						// change frequency ratio in steps
-						if (std::abs(frequency_ratio - request_ratio) > cfg.time_stretching_step)
+						// change stretch ratio in steps
+						if (std::abs(m_stretch_ratio - request_ratio) > cfg.time_stretching_step)
 						{
-							new_ratio = ringbuffer->set_frequency_ratio(request_ratio);
+							m_stretch_ratio = request_ratio;
 						}
 					}
-					else if (frequency_ratio != 1.0f)
-					{
-						new_ratio = ringbuffer->set_frequency_ratio(1.0f);
-					}
-
-					if (new_ratio != frequency_ratio)
+					else
 					{
-						// ratio changed, calculate new dynamic period
-						frequency_ratio = new_ratio;
-						enqueued_playtime = ringbuffer->get_enqueued_playtime();
-						m_dynamic_period = 0;
+						m_stretch_ratio = 1.0f;
 					}
 				}
 
-
 				//  1.0 means exactly as desired
 				// <1.0 means not as full as desired
 				// >1.0 means more full than desired
-				const f32 desired_duration_rate = enqueued_playtime / desired_duration_adjusted;
+				const f32 desired_duration_rate = (enqueued_playtime + stretcher_playtime) / desired_duration_adjusted;
 
 				if (desired_duration_rate >= 1.0f)
 				{
@@ -711,6 +700,12 @@ void cell_audio_thread::operator()()
 				ringbuffer->flush();
 				ringbuffer->enqueue_silence(cfg.desired_full_buffers);
 				finish_port_volume_stepping();
+
+				if (stretcher)
+				{
+					stretcher->reset();
+					m_stretch_ratio = 1.0f;
+				}
 				m_average_playtime = static_cast<f32>(ringbuffer->get_enqueued_playtime());
 			}
 		}
@@ -731,7 +726,20 @@ void cell_audio_thread::operator()()
 		}
 
 		// Enqueue
-		ringbuffer->enqueue();
+		if (stretcher)
+		{
+			// Produce as many blocks as the stretch ratio allows (the input is copied first)
+			stretcher->push(buf);
+
+			while (stretcher->pop(buf = ringbuffer->get_current_buffer(), m_stretch_ratio))
+			{
+				enqueue_mixed(buf);
+			}
+		}
+		else
+		{
+			enqueue_mixed(buf);
+		}
 
 		// Advance time
 		advance(timestamp);
@@ -741,6 +749,322 @@ void cell_audio_thread::operator()()
 	ringbuffer.reset();
 }
 
+namespace audio_mix
+{
+	// Vectorized port mixing, uses the same operation order as the scalar path (results are bit-identical)
+	static constexpr float minus_3db = 0.707f; /* value taken from
+						      https://www.dolby.com/us/en/technologies/a-guide-to-dolby-metadata.pdf */
+
+	SSSE3_FUNC static inline __m128 load_be_ps(const void* ptr)
+	{
+		const __m128i mask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+		return _mm_castsi128_ps(_mm_shuffle_epi8(_mm_loadu_si128(static_cast<const __m128i*>(ptr)), mask));
+	}
+
+	// Store (or add) the whole vector
+	template <bool First>
+	static inline void store_ps(float* dst, __m128 value)
+	{
+		_mm_storeu_ps(dst, First ? value : _mm_add_ps(_mm_loadu_ps(dst), value));
+	}
+
+	// Store (or add) two lower elements only
+	template <bool First>
+	static inline void store_lo_ps(float* dst, __m128 value)
+	{
+		_mm_storel_pi(reinterpret_cast<__m64*>(dst), First ? value : _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(dst)), value));
+	}
+
+	template <u32 Channels, bool First>
+	SSSE3_FUNC static void mix_2ch(float* out, const f32* in, const float* vol)
+	{
+		for (u32 i = 0; i < AUDIO_BUFFER_SAMPLES; i += 4, in += 8)
+		{
+			// Frame volumes: v0 v0 v1 v1, v2 v2 v3 v3
+			const __m128 v = _mm_loadu_ps(vol + i);
+			const __m128 x0 = _mm_mul_ps(load_be_ps(in + 0), _mm_unpacklo_ps(v, v));
+			const __m128 x1 = _mm_mul_ps(load_be_ps(in + 4), _mm_unpackhi_ps(v, v));
+
+			if constexpr (Channels == 2)
+			{
+				store_ps<First>(out + i * 2 + 0, x0);
+				store_ps<First>(out + i * 2 + 4, x1);
+			}
+			else
+			{
+				float* dst = out + i * 8;
+
+				if constexpr (First)
+				{
+					const __m128 zero = _mm_setzero_ps();
+					_mm_storeu_ps(dst + 0x00, _mm_movelh_ps(x0, zero));
+					_mm_storeu_ps(dst + 0x04, zero);
+					_mm_storeu_ps(dst + 0x08, _mm_movehl_ps(zero, x0));
+					_mm_storeu_ps(dst + 0x0c, zero);
+					_mm_storeu_ps(dst + 0x10, _mm_movelh_ps(x1, zero));
+					_mm_storeu_ps(dst + 0x14, zero);
+					_mm_storeu_ps(dst + 0x18, _mm_movehl_ps(zero, x1));
+					_mm_storeu_ps(dst + 0x1c, zero);
+				}
+				else
+				{
+					store_lo_ps<false>(dst + 0x00, x0);
+					store_lo_ps<false>(dst + 0x08, _mm_movehl_ps(x0, x0));
+					store_lo_ps<false>(dst + 0x10, x1);
+					store_lo_ps<false>(dst + 0x18, _mm_movehl_ps(x1, x1));
+				}
+			}
+		}
+	}
+
+	// Downmix one frame (L R C LFE, RL RR SL SR) to two lower elements
+	SSSE3_FUNC static inline __m128 downmix_frame(const f32* in, __m128 v)
+	{
+		const __m128 c3db = _mm_set1_ps(minus_3db);
+		const __m128 front = _mm_mul_ps(load_be_ps(in + 0), v);
+		const __m128 rear = _mm_mul_ps(load_be_ps(in + 4), v);
+
+		// (left + rear_left + side_left * minus_3db + center * minus_3db)
+		const __m128 side = _mm_mul_ps(_mm_movehl_ps(rear, rear), c3db);
+		const __m128 mid = _mm_mul_ps(_mm_shuffle_ps(front, front, 0xaa), c3db);
+		return _mm_add_ps(_mm_add_ps(_mm_add_ps(front, rear), side), mid);
+	}
+
+	template <bool First>
+	SSSE3_FUNC static void mix_8ch_to_2ch(float* out, const f32* in, const float* vol)
+	{
+		for (u32 i = 0; i < AUDIO_BUFFER_SAMPLES; i += 2, in += 16)
+		{
+			const __m128 f0 = downmix_frame(in + 0, _mm_set1_ps(vol[i + 0]));
+			const __m128 f1 = downmix_frame(in + 8, _mm_set1_ps(vol[i + 1]));
+			store_ps<First>(out + i * 2, _mm_movelh_ps(f0, f1));
+		}
+	}
+
+	template <bool First>
+	SSSE3_FUNC static void mix_8ch(float* out, const f32* in, const float* vol)
+	{
+		for (u32 i = 0; i < AUDIO_BUFFER_SAMPLES; i++, in += 8)
+		{
+			const __m128 v = _mm_set1_ps(vol[i]);
+			store_ps<First>(out + i * 8 + 0, _mm_mul_ps(load_be_ps(in + 0), v));
+			store_ps<First>(out + i * 8 + 4, _mm_mul_ps(load_be_ps(in + 4), v));
+		}
+	}
+
+	template <bool First>
+	AVX2_FUNC static void avx2_mix_8ch(float* out, const f32* in, const float* vol)
+	{
+		const __m256i mask = _mm256_set_epi8(
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+			12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+		for (u32 i = 0; i < AUDIO_BUFFER_SAMPLES; i++, in += 8)
+		{
+			const __m256 x = _mm256_mul_ps(_mm256_castsi256_ps(_mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in)), mask)), _mm256_set1_ps(vol[i]));
+			_mm256_storeu_ps(out + i * 8, First ? x : _mm256_add_ps(_mm256_loadu_ps(out + i * 8), x));
+		}
+	}
+
+	// Mix the whole port buffer (in_channels must be 2 or 8)
+	template <bool DownmixToStereo, bool First>
+	static void mix_port(float* out, const f32* in, const float* vol, u32 in_channels)
+	{
+		if (in_channels == 2)
+		{
+			mix_2ch<DownmixToStereo ? 2 : 8, First>(out, in, vol);
+		}
+		else if constexpr (DownmixToStereo)
+		{
+			mix_8ch_to_2ch<First>(out, in, vol);
+		}
+		else if (s_use_avx2)
+		{
+			avx2_mix_8ch<First>(out, in, vol);
+		}
+		else
+		{
+			mix_8ch<First>(out, in, vol);
+		}
+	}
+
+	// Scalar reference (any CPU)
+	template <bool DownmixToStereo, bool First>
+	static void mix_port_scalar(float* out_buffer, const be_t<f32>* buf, const float* vol, u32 in_channels)
+	{
+		constexpr u32 channels = DownmixToStereo ? 2 : 8;
+		constexpr u32 out_buffer_sz = channels * AUDIO_BUFFER_SAMPLES;
+		constexpr float k = 1.f;
+
+		if (in_channels == 2)
+		{
+			for (u32 out = 0, in = 0, i = 0; out < out_buffer_sz; out += channels, in += 2, i++)
+			{
+				const float m = vol[i];
+				const float left  = buf[in + 0] * m;
+				const float right = buf[in + 1] * m;
+
+				if constexpr (First)
+				{
+					out_buffer[out + 0] = left;
+					out_buffer[out + 1] = right;
+
+					if constexpr (!DownmixToStereo)
+					{
+						out_buffer[out + 2] = 0.0f;
+						out_buffer[out + 3] = 0.0f;
+						out_buffer[out + 4] = 0.0f;
+						out_buffer[out + 5] = 0.0f;
+						out_buffer[out + 6] = 0.0f;
+						out_buffer[out + 7] = 0.0f;
+					}
+				}
+				else
+				{
+					out_buffer[out + 0] += left;
+					out_buffer[out + 1] += right;
+				}
+			}
+
+			return;
+		}
+
+		for (u32 out = 0, in = 0, i = 0; out < out_buffer_sz; out += channels, in += 8, i++)
+		{
+			const float m = vol[i];
+			const float left       = buf[in + 0] * m;
+			const float right      = buf[in + 1] * m;
+			const float center     = buf[in + 2] * m;
+			const float low_freq   = buf[in + 3] * m;
+			const float rear_left  = buf[in + 4] * m;
+			const float rear_right = buf[in + 5] * m;
+			const float side_left  = buf[in + 6] * m;
+			const float side_right = buf[in + 7] * m;
+
+			if constexpr (DownmixToStereo)
+			{
+				const float mid = center * minus_3db; /* don't mix in the lfe as per
+									 dolby specification */
+				const float mix_left = (left + rear_left + (side_left * minus_3db) + mid) * k;
+				const float mix_right = (right + rear_right + (side_right * minus_3db) + mid) * k;
+
+				if constexpr (First)
+				{
+					out_buffer[out + 0] = mix_left;
+					out_buffer[out + 1] = mix_right;
+				}
+				else
+				{
+					out_buffer[out + 0] += mix_left;
+					out_buffer[out + 1] += mix_right;
+				}
+			}
+			else if constexpr (First)
+			{
+				out_buffer[out + 0] = left;
+				out_buffer[out + 1] = right;
+				out_buffer[out + 2] = center;
+				out_buffer[out + 3] = low_freq;
+				out_buffer[out + 4] = rear_left;
+				out_buffer[out + 5] = rear_right;
+				out_buffer[out + 6] = side_left;
+				out_buffer[out + 7] = side_right;
+			}
+			else
+			{
+				out_buffer[out + 0] += left;
+				out_buffer[out + 1] += right;
+				out_buffer[out + 2] += center;
+				out_buffer[out + 3] += low_freq;
+				out_buffer[out + 4] += rear_left;
+				out_buffer[out + 5] += rear_right;
+				out_buffer[out + 6] += side_left;
+				out_buffer[out + 7] += side_right;
+			}
+		}
+	}
+
+	// Mix random port data with both paths, returns false if the results differ
+	template <bool DownmixToStereo, bool First>
+	static bool self_test_layout(u32 in_channels, std::mt19937& rng, f64& scalar_time, f64& vector_time)
+	{
+		constexpr u32 out_size = (DownmixToStereo ? 2 : 8) * AUDIO_BUFFER_SAMPLES;
+
+		std::uniform_real_distribution<float> sample(-1.5f, 1.5f);
+		std::uniform_real_distribution<float> level(0.0f, 1.0f);
+
+		std::vector<be_t<f32>> in(in_channels * AUDIO_BUFFER_SAMPLES);
+		std::array<float, AUDIO_BUFFER_SAMPLES> vol;
+		std::vector<float> out_ref(out_size), out_vec(out_size);
+
+		for (auto& value : in)
+		{
+			value = sample(rng);
+		}
+
+		// Volume ramp
+		float m = level(rng);
+		const float inc = (level(rng) - m) / AUDIO_BUFFER_SAMPLES;
+
+		for (float& volume : vol)
+		{
+			volume = m += inc;
+		}
+
+		// Previously mixed ports
+		for (u32 i = 0; i < out_size; i++)
+		{
+			out_ref[i] = out_vec[i] = sample(rng);
+		}
+
+		const auto t0 = std::chrono::steady_clock::now();
+		mix_port_scalar<DownmixToStereo, First>(out_ref.data(), in.data(), vol.data(), in_channels);
+		const auto t1 = std::chrono::steady_clock::now();
+		mix_port<DownmixToStereo, First>(out_vec.data(), reinterpret_cast<const f32*>(in.data()), vol.data(), in_channels);
+		const auto t2 = std::chrono::steady_clock::now();
+
+		scalar_time += std::chrono::duration<f64, std::micro>(t1 - t0).count();
+		vector_time += std::chrono::duration<f64, std::micro>(t2 - t1).count();
+
+		return std::memcmp(out_ref.data(), out_vec.data(), out_size * sizeof(float)) == 0;
+	}
+
+	// Check that the vectorized mixing is bit-identical to the scalar reference and compare their speed
+	static void self_test()
+	{
+		if (!s_use_ssse3)
+		{
+			cellAudio.notice("Mixer self-test: SSSE3 is not available, only the scalar path is used");
+			return;
+		}
+
+		constexpr u32 rounds = 256;
+
+		std::mt19937 rng(std::random_device{}());
+
+		const auto test = [&](const char* name, auto&& func)
+		{
+			f64 scalar_time = 0, vector_time = 0;
+
+			for (u32 i = 0; i < rounds; i++)
+			{
+				if (!func(scalar_time, vector_time))
+				{
+					cellAudio.error("Mixer self-test: %s output differs from the scalar reference", name);
+					return;
+				}
+			}
+
+			cellAudio.notice("Mixer self-test: %s is bit-identical (scalar %.3f us, vectorized %.3f us per port)", name, scalar_time / rounds, vector_time / rounds);
+		};
+
+		test("2->2", [&](f64& st, f64& vt) { return self_test_layout<true, true>(2, rng, st, vt) && self_test_layout<true, false>(2, rng, st, vt); });
+		test("2->8", [&](f64& st, f64& vt) { return self_test_layout<false, true>(2, rng, st, vt) && self_test_layout<false, false>(2, rng, st, vt); });
+		test("8->2", [&](f64& st, f64& vt) { return self_test_layout<true, true>(8, rng, st, vt) && self_test_layout<true, false>(8, rng, st, vt); });
+		test(s_use_avx2 ? "8->8 (AVX2)" : "8->8", [&](f64& st, f64& vt) { return self_test_layout<false, true>(8, rng, st, vt) && self_test_layout<false, false>(8, rng, st, vt); });
+	}
+}
+
 template <bool DownmixToStereo>
 void cell_audio_thread::mix(float *out_buffer, s32 offset)
 {
@@ -756,10 +1080,12 @@ void cell_audio_thread::mix(float *out_buffer, s32 offset)
 	{
 		if (port.state != audio_port_state::started) continue;
 
+		if (port.num_channels != 2 && port.num_channels != 8)
+		{
+			fmt::throw_exception("Unknown channel count (port=%u, channel=%d)" HERE, port.number, port.num_channels);
+		}
+
 		auto buf = port.get_vm_ptr(offset);
-		static const float k = 1.f;
-		static const float minus_3db = 0.707f; /* value taken from
-							  https://www.dolby.com/us/en/technologies/a-guide-to-dolby-metadata.pdf */
 		float& m = port.level;
 
 		// part of cellAudioSetPortLevel functionality
@@ -781,123 +1107,48 @@ void cell_audio_thread::mix(float *out_buffer, s32 offset)
 			}
 		};
 
-		if (port.num_channels == 2)
+		// Volume of every frame
+		std::array<float, AUDIO_BUFFER_SAMPLES> volumes;
+
+		if (port.level_set.load().inc == 0.0f)
 		{
-			if (first_mix)
+			volumes.fill(m);
+		}
+		else
+		{
+			for (float& volume : volumes)
 			{
-				for (u32 out = 0, in = 0; out < out_buffer_sz; out += channels, in += 2)
-				{
-					step_volume(port);
-
-					const float left  = buf[in + 0] * m;
-					const float right = buf[in + 1] * m;
+				step_volume(port);
+				volume = m;
+			}
+		}
 
-					out_buffer[out + 0] = left;
-					out_buffer[out + 1] = right;
+		if (s_use_ssse3)
+		{
+			const auto in = reinterpret_cast<const f32*>(buf);
 
-					if constexpr (!DownmixToStereo)
-					{
-						out_buffer[out + 2] = 0.0f;
-						out_buffer[out + 3] = 0.0f;
-						out_buffer[out + 4] = 0.0f;
-						out_buffer[out + 5] = 0.0f;
-						out_buffer[out + 6] = 0.0f;
-						out_buffer[out + 7] = 0.0f;
-					}
-				}
-				first_mix = false;
+			if (first_mix)
+			{
+				audio_mix::mix_port<DownmixToStereo, true>(out_buffer, in, volumes.data(), port.num_channels);
 			}
 			else
 			{
-				for (u32 out = 0, in = 0; out < out_buffer_sz; out += channels, in += 2)
-				{
-					step_volume(port);
-
-					const float left  = buf[in + 0] * m;
-					const float right = buf[in + 1] * m;
-
-					out_buffer[out + 0] += left;
-					out_buffer[out + 1] += right;
-				}
+				audio_mix::mix_port<DownmixToStereo, false>(out_buffer, in, volumes.data(), port.num_channels);
 			}
 		}
-		else if (port.num_channels == 8)
+		else
 		{
 			if (first_mix)
 			{
-				for (u32 out = 0, in = 0; out < out_buffer_sz; out += channels, in += 8)
-				{
-					step_volume(port);
-
-					const float left       = buf[in + 0] * m;
-					const float right      = buf[in + 1] * m;
-					const float center     = buf[in + 2] * m;
-					const float low_freq   = buf[in + 3] * m;
-					const float rear_left  = buf[in + 4] * m;
-					const float rear_right = buf[in + 5] * m;
-					const float side_left  = buf[in + 6] * m;
-					const float side_right = buf[in + 7] * m;
-
-					if constexpr (DownmixToStereo)
-					{
-						const float mid = center * minus_3db; /* don't mix in the lfe as per
-											 dolby specification */
-						out_buffer[out + 0] = (left + rear_left + (side_left * minus_3db) + mid) * k;
-						out_buffer[out + 1] = (right + rear_right + (side_right * minus_3db) + mid) * k;
-					}
-					else
-					{
-						out_buffer[out + 0] = left;
-						out_buffer[out + 1] = right;
-						out_buffer[out + 2] = center;
-						out_buffer[out + 3] = low_freq;
-						out_buffer[out + 4] = rear_left;
-						out_buffer[out + 5] = rear_right;
-						out_buffer[out + 6] = side_left;
-						out_buffer[out + 7] = side_right;
-					}
-				}
-				first_mix = false;
+				audio_mix::mix_port_scalar<DownmixToStereo, true>(out_buffer, buf, volumes.data(), port.num_channels);
 			}
 			else
 			{
-				for (u32 out = 0, in = 0; out < out_buffer_sz; out += channels, in += 8)
-				{
-					step_volume(port);
-
-					const float left       = buf[in + 0] * m;
-					const float right      = buf[in + 1] * m;
-					const float center     = buf[in + 2] * m;
-					const float low_freq   = buf[in + 3] * m;
-					const float rear_left  = buf[in + 4] * m;
-					const float rear_right = buf[in + 5] * m;
-					const float side_left  = buf[in + 6] * m;
-					const float side_right = buf[in + 7] * m;
-
-					if constexpr (DownmixToStereo)
-					{
-						const float mid = center * minus_3db;
-						out_buffer[out + 0] += (left + rear_left + (side_left * minus_3db) + mid) * k;
-						out_buffer[out + 1] += (right + rear_right + (side_right * minus_3db) + mid) * k;
-					}
-					else
-					{
-						out_buffer[out + 0] += left;
-						out_buffer[out + 1] += right;
-						out_buffer[out + 2] += center;
-						out_buffer[out + 3] += low_freq;
-						out_buffer[out + 4] += rear_left;
-						out_buffer[out + 5] += rear_right;
-						out_buffer[out + 6] += side_left;
-						out_buffer[out + 7] += side_right;
-					}
-				}
+				audio_mix::mix_port_scalar<DownmixToStereo, false>(out_buffer, buf, volumes.data(), port.num_channels);
 			}
 		}
-		else
-		{
-			fmt::throw_exception("Unknown channel count (port=%u, channel=%d)" HERE, port.number, port.num_channels);
-		}
+
+		first_mix = false;
 	}
 
 	// Nothing was mixed, memset out_buffer to 0
@@ -905,7 +1156,14 @@ void cell_audio_thread::mix(float *out_buffer, s32 offset)
 	{
 		std::memset(out_buffer, 0, out_buffer_sz * sizeof(float));
 	}
-	else if (g_cfg.audio.convert_to_u16)
+}
+
+void cell_audio_thread::enqueue_mixed(float* out_buffer)
+{
+	// out_buffer must be the current ringbuffer buffer
+	const u32 out_buffer_sz = cfg.audio_buffer_length;
+
+	if (g_cfg.audio.convert_to_u16)
 	{
 		// convert the data from float to u16 with clipping:
 		// 2x MULPS
@@ -922,6 +1180,8 @@ void cell_audio_thread::mix(float *out_buffer, s32 offset)
 				_mm_cvtps_epi32(_mm_mul_ps(_mm_load_ps(out_buffer + i + 4), scale)))));
 		}
 	}
+
+	ringbuffer->enqueue();
 }
 
 void cell_audio_thread::finish_port_volume_stepping()
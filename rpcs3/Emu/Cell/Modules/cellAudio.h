@@ -5,6 +5,7 @@
 #include "Emu/Memory/vm.h"
 #include "Emu/Audio/AudioBackend.h"
 #include "Emu/Audio/AudioDumper.h"
+#include "Emu/Audio/AudioTimeStretcher.h"
 
 // Error codes
 enum CellAudioError : u32
@@ -207,14 +208,11 @@ public:
 	/*
 	 * Time Stretching
 	 */
-private:
-	const bool raw_time_stretching_enabled = buffering_enabled && g_cfg.audio.enable_time_stretching && (g_cfg.audio.time_stretching_threshold > 0);
-public:
-	// We need to be able to set a dynamic frequency ratio to be able to do time stretching
-	const bool time_stretching_enabled = raw_time_stretching_enabled && backend->has_capability(AudioBackend::SET_FREQUENCY_RATIO);
+	// Time stretching is done in-core (audio_time_stretcher), it only depends on buffering
+	const bool time_stretching_enabled = buffering_enabled && g_cfg.audio.enable_time_stretching && (g_cfg.audio.time_stretching_threshold > 0);
 
 	const f32 time_stretching_threshold = g_cfg.audio.time_stretching_threshold / 100.0f; // we only apply time stretching below this buffer fill rate (adjusted for average period)
-	const f32 time_stretching_step = 0.1f; // will only reduce/increase the frequency ratio in steps of at least this value
+	const f32 time_stretching_step = 0.1f; // will only reduce/increase the stretch ratio in steps of at least this value
 	const f32 time_stretching_scale = 0.9f;
 
 	/*
@@ -247,8 +245,6 @@ private:
 	u64 last_remainder = 0;
 	u64 enqueued_samples = 0;
 
-	f32 frequency_ratio = 1.0f;
-
 	u32 cur_pos = 0;
 
 	bool get_backend_playing() const
@@ -265,7 +261,6 @@ public:
 	void flush();
 	u64 update();
 	void enqueue_silence(u32 buf_count = 1);
-	f32 set_frequency_ratio(f32 new_ratio);
 
 	float* get_buffer(u32 num) const
 	{
@@ -290,11 +285,10 @@ public:
 		return enqueued_samples;
 	}
 
-	u64 get_enqueued_playtime(bool raw = false) const
+	u64 get_enqueued_playtime() const
 	{
 		AUDIT(cfg.buffering_enabled);
-		u64 sampling_rate = raw ? cfg.audio_sampling_rate : static_cast<u64>(cfg.audio_sampling_rate * frequency_ratio);
-		return enqueued_samples * 1'000'000 / sampling_rate;
+		return enqueued_samples * 1'000'000 / cfg.audio_sampling_rate;
 	}
 
 	bool is_playing() const
@@ -302,11 +296,6 @@ public:
 		return playing;
 	}
 
-	f32 get_frequency_ratio() const
-	{
-		return frequency_ratio;
-	}
-
 	u32 has_capability(u32 cap) const
 	{
 		return backend->has_capability(cap);
@@ -323,12 +312,17 @@ class cell_audio_thread
 {
 	std::unique_ptr<audio_ringbuffer> ringbuffer;
 
+	// Pitch-preserving stretch stage between mix() and the ringbuffer (if time stretching is enabled)
+	std::unique_ptr<audio_time_stretcher> stretcher;
+	f32 m_stretch_ratio = 1.0f;
+
 	void reset_ports(s32 offset = 0);
 	void advance(u64 timestamp, bool reset = true);
 	std::tuple<u32, u32, u32, u32> count_port_buffer_tags();
 	template <bool DownmixToStereo>
 	void mix(float *out_buffer, s32 offset = 0);
 	void finish_port_volume_stepping();
+	void enqueue_mixed(float* buf);
 
 	constexpr static u64 get_thread_wait_delay(u64 time_left)
 	{
@@ -5,6 +5,8 @@
 
 #include "Emu/Cell/lv2/sys_fs.h"
 #include "Emu/Cell/lv2/sys_sync.h"
+#include "Emu/Cell/lv2/sys_ppu_thread.h"
+#include "sysPrxForUser.h"
 #include "cellFs.h"
 
 #include "Utilities/StrUtil.h"
@@ -863,67 +865,298 @@ s32 cellFsStReadWaitCallback(u32 fd, u64 size, vm::ptr<void(s32 xfd, u64 xsize)>
 
 using fs_aio_cb_t = vm::ptr<void(vm::ptr<CellFsAio> xaio, s32 error, s32 xid, u64 size)>;
 
-// temporarily
-struct lv2_fs_mount_point
+struct fs_aio_request
 {
-	std::mutex mutex;
+	u32 type; // 1 = read, 2 = write, 0 = wake up the dispatcher
+	s32 xid;
+	vm::ptr<CellFsAio> aio;
+	fs_aio_cb_t func;
+
+	// Copied from CellFsAio on submission
+	u32 fd;
+	u64 offset;
+	vm::ptr<void> buf;
+	u64 size;
+};
+
+struct fs_aio_completion
+{
+	fs_aio_request req;
+	s32 error;
+	u64 size;
+};
+
+// Host I/O worker, processes a batch of requests for one file (several adjacent reads are merged)
+struct fs_aio_worker
+{
+	lf_queue<std::vector<fs_aio_request>> batches;
+
+	// Number of batches sent to this worker and not yet processed
+	atomic_t<u32> pending = 0;
+
+	// File of the last batch (only used by the dispatcher)
+	u32 fd = 0;
+
+	void operator()();
+
+	static constexpr auto thread_name = "FS AIO Worker"sv;
+};
+
+// Request dispatcher, owns the worker pool
+struct fs_aio_dispatcher
+{
+	void operator()();
+
+	static constexpr auto thread_name = "FS AIO"sv;
 };
 
-struct fs_aio_thread : ppu_thread
+struct fs_aio_manager
 {
-	using ppu_thread::ppu_thread;
+	shared_mutex mutex;
+
+	// Requests from cellFsAioRead/cellFsAioWrite
+	lf_queue<fs_aio_request> requests;
+
+	// Completed requests for the callback thread (possibly out of order)
+	lf_queue<fs_aio_completion> completions;
+
+	// Callback thread id
+	u32 ppu_tid = 0;
+
+	// Initialized by the first cellFsAioInit call (destroyed first)
+	std::unique_ptr<named_thread<fs_aio_dispatcher>> thread;
+
+	// Number of worker threads (I/O bound)
+	static constexpr u32 worker_count = 4;
+
+	// Max size of merged reads
+	static constexpr u64 merge_max = 0x100000;
+};
+
+void fs_aio_dispatcher::operator()()
+{
+	const auto m = g_fxo->get<fs_aio_manager>();
+
+	std::vector<std::unique_ptr<named_thread<fs_aio_worker>>> workers(fs_aio_manager::worker_count);
+
+	for (auto& worker : workers)
+	{
+		worker = std::make_unique<named_thread<fs_aio_worker>>();
+	}
+
+	// Requests in submission order
+	std::vector<fs_aio_request> queued;
 
-	void non_task()
+	while (thread_ctrl::state() != thread_state::aborting)
 	{
-		while (cmd64 cmd = cmd_wait())
+		for (auto&& req : m->requests.pop_all())
 		{
-			const u32 type = cmd.arg1<u32>();
-			const s32 xid = cmd.arg2<s32>();
-			const cmd64 cmd2 = cmd_get(1);
-			const auto aio = cmd2.arg1<vm::ptr<CellFsAio>>();
-			const auto func = cmd2.arg2<fs_aio_cb_t>();
-			cmd_pop(1);
+			if (req.type)
+			{
+				queued.emplace_back(req);
+			}
+		}
+
+		if (queued.empty())
+		{
+			m->requests.wait();
+			continue;
+		}
+
+		// Find idle worker
+		const auto worker = std::find_if(workers.begin(), workers.end(), [](const auto& w) { return w->pending == 0; });
+
+		if (worker == workers.end())
+		{
+			// Wait for new requests or for a worker to finish
+			m->requests.wait();
+			continue;
+		}
+
+		// Oldest request for a file which isn't processed by another worker (requests for one file are processed in order)
+		const auto first = std::find_if(queued.begin(), queued.end(), [&](const fs_aio_request& req)
+		{
+			return std::none_of(workers.begin(), workers.end(), [&](const auto& w) { return w->pending && w->fd == req.fd; });
+		});
 
-			s32 error = CELL_OK;
-			u64 result = 0;
+		if (first == queued.end())
+		{
+			// Wait for new requests or for a worker to finish
+			m->requests.wait();
+			continue;
+		}
 
-			const auto file = idm::get<lv2_fs_object, lv2_file>(aio->fd);
+		// Take the request and the reads which continue it (earlier requests are for other files)
+		const std::size_t index = first - queued.begin();
+		std::vector<fs_aio_request> batch{*first};
+		queued.erase(first);
+
+		for (u64 end = batch[0].offset + batch[0].size, total = batch[0].size; batch[0].type == 1;)
+		{
+			// Reads can't be moved past a write to the same file
+			const auto limit = std::find_if(queued.begin() + index, queued.end(), [&](const fs_aio_request& req)
+			{
+				return req.type != 1 && req.fd == batch[0].fd;
+			});
+
+			const auto next = std::find_if(queued.begin() + index, limit, [&](const fs_aio_request& req)
+			{
+				return req.type == 1 && req.fd == batch[0].fd && req.offset == end;
+			});
+
+			if (next == limit || total + next->size > fs_aio_manager::merge_max)
+			{
+				break;
+			}
+
+			end += next->size;
+			total += next->size;
+			batch.emplace_back(*next);
+			queued.erase(next);
+		}
+
+		(*worker)->fd = batch[0].fd;
+		(*worker)->pending++;
+		(*worker)->batches.push(std::move(batch));
+	}
+}
+
+void fs_aio_worker::operator()()
+{
+	const auto m = g_fxo->get<fs_aio_manager>();
+
+	while (thread_ctrl::state() != thread_state::aborting)
+	{
+		for (auto&& batch : batches.pop_all())
+		{
+			const u32 type = batch[0].type;
+			const auto file = idm::get<lv2_fs_object, lv2_file>(batch[0].fd);
 
 			if (!file || (type == 1 && file->flags & CELL_FS_O_WRONLY) || (type == 2 && !(file->flags & CELL_FS_O_ACCMODE)))
 			{
-				error = CELL_EBADF;
+				const s32 error = CELL_EBADF;
+
+				for (const auto& req : batch)
+				{
+					m->completions.push(fs_aio_completion{req, error, 0});
+				}
+			}
+			else if (batch.size() == 1)
+			{
+				const auto& req = batch[0];
+
+				s32 error = CELL_OK;
+				u64 result = 0;
+				{
+					reader_lock mp_lock(file->mp->mutex);
+					std::lock_guard lock(file->mutex);
+
+					if (type == 2)
+					{
+						const auto old_pos = file->file.pos(); file->file.seek(req.offset);
+						std::tie(result, error) = file->op_write(req.buf, req.size);
+						file->file.seek(old_pos);
+					}
+					else
+					{
+						std::tie(result, error) = file->op_read(req.buf, req.size, req.offset);
+					}
+				}
+
+				m->completions.push(fs_aio_completion{req, error, result});
 			}
 			else
 			{
-				std::lock_guard lock(file->mp->mutex);
+				// Merged read: read the whole range at once and distribute the data
+				const u64 start = batch[0].offset;
+				const u64 total = batch.back().offset + batch.back().size - start;
+
+				std::vector<uchar> data(total);
+				u64 nread = 0;
+				{
+					reader_lock mp_lock(file->mp->mutex);
+					std::lock_guard lock(file->mutex);
+					nread = file->file.read_at(start, data.data(), total);
+				}
+
+				for (const auto& req : batch)
+				{
+					const u64 pos = req.offset - start;
+					const u64 size = nread > pos ? std::min<u64>(nread - pos, req.size) : 0;
+
+					s32 error = CELL_OK;
+
+					if (!vm::try_access(req.buf.addr(), data.data() + pos, static_cast<u32>(size), true))
+					{
+						cellFs.error("cellFsAioRead(): Memory access failure (buf=*0x%x, size=0x%llx)", req.buf, size);
+						error = CELL_EFAULT;
+					}
+
+					m->completions.push(fs_aio_completion{req, error, error ? 0 : size});
+				}
+			}
 
-				const auto old_pos = file->file.pos(); file->file.seek(aio->offset);
+			// Notify the dispatcher
+			pending--;
+			m->requests.push(fs_aio_request{});
+		}
 
-				std::tie(result, error) = type == 2
-					? file->op_write(aio->buf, aio->size)
-					: file->op_read(aio->buf, aio->size);
+		batches.wait();
+	}
+}
 
-				file->file.seek(old_pos);
-			}
+static void fsAioEntry(ppu_thread& ppu)
+{
+	const auto m = g_fxo->get<fs_aio_manager>();
 
-			func(*this, aio, error, xid, result);
-			lv2_obj::sleep(*this);
+	// Deliver completions through the callbacks (res can be nullptr)
+	for (auto* res : m->completions)
+	{
+		if (thread_ctrl::state() == thread_state::aborting)
+		{
+			break;
+		}
+
+		if (res)
+		{
+			res->req.func(ppu, res->req.aio, res->error, res->req.xid, res->size);
+			lv2_obj::sleep(ppu);
 		}
 	}
-};
 
-struct fs_aio_manager
-{
-	std::shared_ptr<fs_aio_thread> thread;
-};
+	ppu.state += cpu_flag::exit;
+}
 
-s32 cellFsAioInit(vm::cptr<char> mount_point)
+s32 cellFsAioInit(ppu_thread& ppu, vm::cptr<char> mount_point)
 {
 	cellFs.warning("cellFsAioInit(mount_point=%s)", mount_point);
 
-	// TODO: create AIO thread (if not exists) for specified mount point
-	fmt::throw_exception("cellFsAio disabled, use LLE.");
+	const auto m = g_fxo->get<fs_aio_manager>();
+
+	std::lock_guard lock(m->mutex);
 
+	if (m->thread)
+	{
+		return CELL_OK;
+	}
+
+	// Create callback thread
+	vm::var<u64> _tid;
+	vm::var<char[]> _name = vm::make_str("HLE FS AIO");
+	ppu_execute<&sys_ppu_thread_create>(ppu, +_tid, 0x10000, 0, 1001, 0x4000, SYS_PPU_THREAD_CREATE_INTERRUPT, +_name);
+
+	const auto thrd = idm::get<named_thread<ppu_thread>>(static_cast<u32>(*_tid));
+
+	thrd->cmd_list
+	({
+		{ ppu_cmd::hle_call, FIND_FUNC(fsAioEntry) },
+	});
+
+	thrd->state -= cpu_flag::stop;
+	thread_ctrl::notify(*thrd);
+
+	m->ppu_tid = thrd->id;
+	m->thread = std::make_unique<named_thread<fs_aio_dispatcher>>();
 	return CELL_OK;
 }
 
@@ -938,52 +1171,39 @@ s32 cellFsAioFinish(vm::cptr<char> mount_point)
 
 atomic_t<s32> g_fs_aio_id;
 
-s32 cellFsAioRead(vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
+static s32 fs_aio_submit(u32 type, vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
 {
-	cellFs.warning("cellFsAioRead(aio=*0x%x, id=*0x%x, func=*0x%x)", aio, id, func);
-
-	// TODO: detect mount point and send AIO request to the AIO thread of this mount point
-
 	const auto m = g_fxo->get<fs_aio_manager>();
 
-	if (!m)
+	reader_lock lock(m->mutex);
+
+	if (!m->thread)
 	{
 		return CELL_ENXIO;
 	}
 
 	const s32 xid = (*id = ++g_fs_aio_id);
 
-	m->thread->cmd_list
-	({
-		{ 1, xid },
-		{ aio, func },
-	});
-
+	m->requests.push(fs_aio_request{type, xid, aio, func, aio->fd, aio->offset, aio->buf, aio->size});
 	return CELL_OK;
 }
 
-s32 cellFsAioWrite(vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
+s32 cellFsAioRead(vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
 {
-	cellFs.warning("cellFsAioWrite(aio=*0x%x, id=*0x%x, func=*0x%x)", aio, id, func);
+	cellFs.warning("cellFsAioRead(aio=*0x%x, id=*0x%x, func=*0x%x)", aio, id, func);
 
 	// TODO: detect mount point and send AIO request to the AIO thread of this mount point
 
-	const auto m = g_fxo->get<fs_aio_manager>();
-
-	if (!m)
-	{
-		return CELL_ENXIO;
-	}
+	return fs_aio_submit(1, aio, id, func);
+}
 
-	const s32 xid = (*id = ++g_fs_aio_id);
+s32 cellFsAioWrite(vm::ptr<CellFsAio> aio, vm::ptr<s32> id, fs_aio_cb_t func)
+{
+	cellFs.warning("cellFsAioWrite(aio=*0x%x, id=*0x%x, func=*0x%x)", aio, id, func);
 
-	m->thread->cmd_list
-	({
-		{ 2, xid },
-		{ aio, func },
-	});
+	// TODO: detect mount point and send AIO request to the AIO thread of this mount point
 
-	return CELL_OK;
+	return fs_aio_submit(2, aio, id, func);
 }
 
 s32 cellFsAioCancel(s32 id)
@@ -1095,4 +1315,6 @@ DECLARE(ppu_module_manager::cellFs)("sys_fs", []()
 	REG_FUNC(sys_fs, cellFsUtime);
 	REG_FUNC(sys_fs, cellFsWrite).flag(MFF_PERFECT);
 	REG_FUNC(sys_fs, cellFsWriteWithOffset);
+
+	REG_FUNC(sys_fs, fsAioEntry).flag(MFF_HIDDEN);
 });
@@ -33,6 +33,7 @@ extern "C"
 #include <mutex>
 #include <queue>
 #include <cmath>
+#include <thread>
 #include "Utilities/lockless.h"
 #include <variant>
 
@@ -89,12 +90,105 @@ struct vdec_frame
 	u32 frc{};
 	bool PicItemRecieved = false;
 
+	// Sequential frame number (identifies the frame for the converter thread)
+	u64 seq{};
+
+	// Picture converted ahead of cellVdecGetPicture (see vdec_picture_format)
+	u32 converted_format{};
+	std::vector<u8> converted;
+
 	AVFrame* operator ->() const
 	{
 		return avf.get();
 	}
 };
 
+// Packed output format key (0 means unknown)
+static constexpr u32 vdec_picture_format(u32 type, u8 alpha)
+{
+	return 0x80000000 | type << 8 | alpha;
+}
+
+// Get libswscale formats for the conversion, false if not supported
+static bool vdec_get_pixel_formats(const AVFrame* frame, u32 type, AVPixelFormat& in_f, AVPixelFormat& out_f)
+{
+	bool alpha = false;
+
+	switch (type)
+	{
+	case CELL_VDEC_PICFMT_ARGB32_ILV: out_f = AV_PIX_FMT_ARGB; alpha = true; break;
+	case CELL_VDEC_PICFMT_RGBA32_ILV: out_f = AV_PIX_FMT_RGBA; alpha = true; break;
+	case CELL_VDEC_PICFMT_UYVY422_ILV: out_f = AV_PIX_FMT_UYVY422; break;
+	case CELL_VDEC_PICFMT_YUV420_PLANAR: out_f = AV_PIX_FMT_YUV420P; break;
+	default: return false;
+	}
+
+	switch (frame->format)
+	{
+	case AV_PIX_FMT_YUVJ420P:
+	case AV_PIX_FMT_YUV420P:
+		in_f = alpha ? AV_PIX_FMT_YUVA420P : static_cast<AVPixelFormat>(frame->format);
+		break;
+	default: return false;
+	}
+
+	return true;
+}
+
+// Get size of the converted picture
+static u32 vdec_get_picture_size(const AVFrame* frame, u32 type)
+{
+	const u32 w = frame->width;
+	const u32 h = frame->height;
+
+	switch (type)
+	{
+	case CELL_VDEC_PICFMT_ARGB32_ILV:
+	case CELL_VDEC_PICFMT_RGBA32_ILV: return w * h * 4;
+	case CELL_VDEC_PICFMT_UYVY422_ILV: return w * h * 2;
+	default: return w * h * 3 / 2;
+	}
+}
+
+// Convert the picture (formats must be obtained with vdec_get_pixel_formats, out must have vdec_get_picture_size bytes)
+static void vdec_convert_picture(SwsContext*& sws, const AVFrame* frame, AVPixelFormat in_f, AVPixelFormat out_f, u8 alpha, u8* out)
+{
+	const int w = frame->width;
+	const int h = frame->height;
+
+	// TODO: color matrix
+
+	std::unique_ptr<u8[]> alpha_plane;
+
+	if (in_f == AV_PIX_FMT_YUVA420P)
+	{
+		alpha_plane.reset(new u8[w * h]);
+		std::memset(alpha_plane.get(), alpha, w * h);
+	}
+
+	sws = sws_getCachedContext(sws, w, h, in_f, w, h, out_f, SWS_POINT, NULL, NULL, NULL);
+
+	u8* in_data[4] = { frame->data[0], frame->data[1], frame->data[2], alpha_plane.get() };
+	int in_line[4] = { frame->linesize[0], frame->linesize[1], frame->linesize[2], w * 1 };
+	u8* out_data[4] = { out };
+	int out_line[4] = { w * 4 };
+
+	if (out_f == AV_PIX_FMT_UYVY422)
+	{
+		out_line[0] = w * 2;
+	}
+	else if (out_f == AV_PIX_FMT_YUV420P)
+	{
+		out_data[1] = out_data[0] + w * h;
+		out_data[2] = out_data[0] + w * h * 5 / 4;
+		out_line[0] = w;
+		out_line[1] = w / 2;
+		out_line[2] = w / 2;
+	}
+
+	sws_scale(sws, in_data, in_line, 0, h, out_data, out_line);
+}
+
 struct vdec_context final
 {
 	static const u32 id_base = 0xf0000000;
@@ -123,11 +217,21 @@ struct vdec_context final
 
 	std::deque<vdec_frame> out;
 	atomic_t<u32> out_max = 60;
+	u64 out_seq{};
+
+	// Max number of frames converted ahead of cellVdecGetPicture
+	static constexpr u32 convert_ahead_max = 3;
+
+	// Last format requested by cellVdecGetPicture (used by the converter thread)
+	atomic_t<u32> picture_format{0};
 
 	atomic_t<u32> au_count{0};
 
 	lf_queue<std::variant<vdec_start_seq_t, vdec_close_t, vdec_cmd, CellVdecFrameRate>> in_cmd;
 
+	// Colour conversion thread
+	std::unique_ptr<named_thread<std::function<void()>>> converter;
+
 	vdec_context(s32 type, u32 profile, u32 addr, u32 size, vm::ptr<CellVdecCbMsg> func, u32 arg)
 		: type(type)
 		, mem_addr(addr)
@@ -172,26 +276,107 @@ struct vdec_context final
 			fmt::throw_exception("avcodec_alloc_context3() failed (type=0x%x)" HERE, type);
 		}
 
+		// Frame threading (falls back to slice threading if not supported by the codec)
+		ctx->thread_count = std::clamp<int>(std::thread::hardware_concurrency(), 1, 4);
+		ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
 		AVDictionary* opts{};
 		av_dict_set(&opts, "refcounted_frames", "1", 0);
 
-		std::lock_guard lock(g_mutex_avcodec_open2);
-
-		int err = avcodec_open2(ctx, codec, &opts);
-		if (err || opts)
 		{
-			avcodec_free_context(&ctx);
-			fmt::throw_exception("avcodec_open2() failed (err=0x%x, opts=%d)" HERE, err, opts ? 1 : 0);
+			std::lock_guard lock(g_mutex_avcodec_open2);
+
+			int err = avcodec_open2(ctx, codec, &opts);
+			if (err || opts)
+			{
+				avcodec_free_context(&ctx);
+				fmt::throw_exception("avcodec_open2() failed (err=0x%x, opts=%d)" HERE, err, opts ? 1 : 0);
+			}
 		}
+
+		converter = std::make_unique<named_thread<std::function<void()>>>("HLE Video Converter", [this]
+		{
+			convert_ahead();
+		});
 	}
 
 	~vdec_context()
 	{
+		converter.reset();
 		avcodec_close(ctx);
 		avcodec_free_context(&ctx);
 		sws_freeContext(sws);
 	}
 
+	// Convert the frames at the front of the output queue to the last requested format
+	void convert_ahead()
+	{
+		SwsContext* conv_sws{};
+
+		while (thread_ctrl::state() != thread_state::aborting)
+		{
+			const u32 format = picture_format;
+
+			std::unique_ptr<AVFrame, vdec_frame::frame_dtor> ref;
+			u64 seq = 0;
+
+			if (format)
+			{
+				std::lock_guard lock(mutex);
+
+				for (u32 i = 0; i < out.size() && i < convert_ahead_max; i++)
+				{
+					auto& frame = out[i];
+
+					if (frame.converted_format != format)
+					{
+						// Take a new reference to the frame data (the frame may be removed before the conversion is done)
+						frame.converted_format = format;
+						frame.converted.clear();
+						ref.reset(av_frame_clone(frame.avf.get()));
+						seq = frame.seq;
+						break;
+					}
+				}
+			}
+
+			if (!ref)
+			{
+				thread_ctrl::wait();
+				continue;
+			}
+
+			const u32 type = format >> 8 & 0xff;
+			AVPixelFormat in_f, out_f;
+
+			if (!vdec_get_pixel_formats(ref.get(), type, in_f, out_f))
+			{
+				// Leave it to cellVdecGetPicture
+				continue;
+			}
+
+			std::vector<u8> data(vdec_get_picture_size(ref.get(), type));
+			vdec_convert_picture(conv_sws, ref.get(), in_f, out_f, static_cast<u8>(format), data.data());
+
+			std::lock_guard lock(mutex);
+
+			for (auto& frame : out)
+			{
+				if (frame.seq == seq)
+				{
+					if (frame.converted_format == format)
+					{
+						frame.converted = std::move(data);
+					}
+
+					break;
+				}
+			}
+		}
+
+		sws_freeContext(conv_sws);
+	}
+
 	void exec(ppu_thread& ppu, u32 vid)
 	{
 		ppu_tid = ppu.id;
@@ -243,6 +428,9 @@ struct vdec_context final
 						next_dts = au_dts;
 					}
 
+					// Carried through the decoder, the picture may be output several AUs later (frame threading, reordering)
+					ctx->reordered_opaque = static_cast<s64>(au_usrd);
+
 					ctx->skip_frame =
 						au_mode == CELL_VDEC_DEC_MODE_NORMAL ? AVDISCARD_DEFAULT :
 						au_mode == CELL_VDEC_DEC_MODE_B_SKIP ? AVDISCARD_NONREF : AVDISCARD_NONINTRA;
@@ -256,13 +444,9 @@ struct vdec_context final
 					cellVdec.trace("End sequence...");
 				}
 
+				// Decode the AU, or drain the frames delayed by the decoder at the end of sequence
 				while (out_max)
 				{
-					if (cmd->mode == -1)
-					{
-						break;
-					}
-
 					vdec_frame frame;
 					frame.avf.reset(av_frame_alloc());
 
@@ -284,6 +468,12 @@ struct vdec_context final
 
 					if (got_picture == 0)
 					{
+						if (cmd->mode == -1)
+						{
+							// Drained: reset the decoder for the next sequence
+							avcodec_flush_buffers(ctx);
+						}
+
 						break;
 					}
 
@@ -317,7 +507,7 @@ struct vdec_context final
 
 						frame.pts = next_pts;
 						frame.dts = next_dts;
-						frame.userdata = au_usrd;
+						frame.userdata = static_cast<u64>(frame->reordered_opaque);
 
 						if (frc_set)
 						{
@@ -386,7 +576,9 @@ struct vdec_context final
 
 						cellVdec.trace("Got picture (pts=0x%llx[0x%llx], dts=0x%llx[0x%llx])", frame.pts, frame->pkt_pts, frame.dts, frame->pkt_dts);
 
+						frame.seq = ++out_seq;
 						std::lock_guard{mutex}, out.push_back(std::move(frame));
+						thread_ctrl::notify(*converter);
 
 						cb_func(ppu, vid, CELL_VDEC_MSG_TYPE_PICOUT, CELL_OK, cb_arg);
 						current_state = CELL_VDEC_MSG_TYPE_PICOUT;
@@ -812,65 +1004,33 @@ error_code cellVdecGetPicture(u32 handle, vm::cptr<CellVdecPicFormat> format, vm
 
 	if (outBuff)
 	{
-		const int w = frame->width;
-		const int h = frame->height;
-
-		AVPixelFormat out_f = AV_PIX_FMT_YUV420P;
+		const u32 type = format->formatType;
+		const u32 picture_format = vdec_picture_format(type, format->alpha);
 
-		std::unique_ptr<u8[]> alpha_plane;
+		AVPixelFormat in_f, out_f;
 
-		switch (const u32 type = format->formatType)
-		{
-		case CELL_VDEC_PICFMT_ARGB32_ILV: out_f = AV_PIX_FMT_ARGB; alpha_plane.reset(new u8[w * h]); break;
-		case CELL_VDEC_PICFMT_RGBA32_ILV: out_f = AV_PIX_FMT_RGBA; alpha_plane.reset(new u8[w * h]); break;
-		case CELL_VDEC_PICFMT_UYVY422_ILV: out_f = AV_PIX_FMT_UYVY422; break;
-		case CELL_VDEC_PICFMT_YUV420_PLANAR: out_f = AV_PIX_FMT_YUV420P; break;
-
-		default:
+		if (!vdec_get_pixel_formats(frame.avf.get(), type, in_f, out_f))
 		{
-			fmt::throw_exception("Unknown formatType (%d)" HERE, type);
+			fmt::throw_exception("Unknown format (formatType=%d, format=%d)" HERE, type, frame->format);
 		}
-		}
-
-		// TODO: color matrix
 
-		if (alpha_plane)
+		if (frame->format == AV_PIX_FMT_YUVJ420P)
 		{
-			std::memset(alpha_plane.get(), format->alpha, w * h);
+			cellVdec.error("cellVdecGetPicture(): experimental AVPixelFormat (%d). This may cause suboptimal video quality.", frame->format);
 		}
 
-		AVPixelFormat in_f = AV_PIX_FMT_YUV420P;
-
-		switch (frame->format)
+		if (frame.converted_format == picture_format && !frame.converted.empty())
 		{
-		case AV_PIX_FMT_YUVJ420P:
-			cellVdec.error("cellVdecGetPicture(): experimental AVPixelFormat (%d). This may cause suboptimal video quality.", frame->format);
-		case AV_PIX_FMT_YUV420P:
-			in_f = alpha_plane ? AV_PIX_FMT_YUVA420P : static_cast<AVPixelFormat>(frame->format);
-			break;
-		default:
-		{
-			fmt::throw_exception("Unknown format (%d)" HERE, frame->format);
-		}
+			// Picture is ready
+			std::memcpy(outBuff.get_ptr(), frame.converted.data(), frame.converted.size());
 		}
-
-		vdec->sws = sws_getCachedContext(vdec->sws, w, h, in_f, w, h, out_f, SWS_POINT, NULL, NULL, NULL);
-
-		u8* in_data[4] = { frame->data[0], frame->data[1], frame->data[2], alpha_plane.get() };
-		int in_line[4] = { frame->linesize[0], frame->linesize[1], frame->linesize[2], w * 1 };
-		u8* out_data[4] = { outBuff.get_ptr() };
-		int out_line[4] = { w * 4 };
-
-		if (!alpha_plane)
+		else
 		{
-			out_data[1] = out_data[0] + w * h;
-			out_data[2] = out_data[0] + w * h * 5 / 4;
-			out_line[0] = w;
-			out_line[1] = w / 2;
-			out_line[2] = w / 2;
+			vdec_convert_picture(vdec->sws, frame.avf.get(), in_f, out_f, format->alpha, outBuff.get_ptr());
 		}
 
-		sws_scale(vdec->sws, in_data, in_line, 0, h, out_data, out_line);
+		// Start converting the next frames to the same format
+		vdec->picture_format = picture_format;
 
 		//const u32 buf_size = align(av_image_get_buffer_size(vdec->ctx->pix_fmt, vdec->ctx->width, vdec->ctx->height, 1), 128);
 
@@ -883,6 +1043,8 @@ error_code cellVdecGetPicture(u32 handle, vm::cptr<CellVdecPicFormat> format, vm
 		//}
 	}
 
+	thread_ctrl::notify(*vdec->converter);
+
 	return CELL_OK;
 }
 
@@ -4,9 +4,14 @@
 #include "PPUOpcodes.h"
 #include "PPUModule.h"
 
+#include "Emu/System.h"
+#include "Utilities/Thread.h"
 #include <unordered_set>
+#include <deque>
+#include <thread>
 #include "yaml-cpp/yaml.h"
 #include "Utilities/asm.h"
+#include "xxhash.h"
 
 LOG_CHANNEL(ppu_validator);
 
@@ -535,8 +540,196 @@ namespace ppu_patterns
 	};
 }
 
+// Analysis cache format version (must be increased if the analyser changes)
+static constexpr u32 s_ppu_analysis_version = 1;
+
+// Get analysis cache location for the module (keyed by the hash and the current contents)
+static std::string ppu_analysis_path(const ppu_module& info, u32 lib_toc, u32 entry)
+{
+	std::vector<u64> key;
+	key.emplace_back(s_ppu_analysis_version);
+	key.emplace_back(u64{lib_toc} << 32 | entry);
+
+	for (const auto& seg : info.segs)
+	{
+		key.emplace_back(u64{seg.addr} << 32 | seg.size);
+		key.emplace_back(XXH64(vm::base(seg.addr), seg.size, 0));
+	}
+
+	for (const auto& sec : info.secs)
+	{
+		key.emplace_back(u64{sec.addr} << 32 | sec.size);
+	}
+
+	return fmt::format("%scache/ppu/%s-%016llx.fn", fs::get_cache_dir(), fmt::base57(info.sha1), XXH64(key.data(), key.size() * sizeof(u64), 0));
+}
+
+static void ppu_save_analysis(const std::string& path, const std::vector<ppu_function>& funcs)
+{
+	std::string out;
+
+	auto put = [&](u32 value)
+	{
+		const be_t<u32> data = value;
+		out.append(reinterpret_cast<const char*>(&data), sizeof(data));
+	};
+
+	put("PPUA"_u32);
+	put(s_ppu_analysis_version);
+	put(::size32(funcs));
+
+	for (const auto& func : funcs)
+	{
+		put(func.addr);
+		put(func.toc);
+		put(func.size);
+		put(static_cast<u32>(func.attr));
+		put(func.stack_frame);
+		put(func.trampoline);
+
+		put(::size32(func.blocks));
+
+		for (const auto& block : func.blocks)
+		{
+			put(block.first);
+			put(block.second);
+		}
+
+		put(::size32(func.calls));
+
+		for (u32 addr : func.calls)
+		{
+			put(addr);
+		}
+
+		put(::size32(func.callers));
+
+		for (u32 addr : func.callers)
+		{
+			put(addr);
+		}
+
+		put(::size32(func.name));
+		out += func.name;
+	}
+
+	const be_t<u64> hash = XXH64(out.data(), out.size(), 0);
+	out.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+
+	// Write to temporary file first (other instances may be reading it)
+	const std::string tmp = fmt::format("%s.%x.tmp", path, std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+	if (!fs::create_path(fs::get_parent_dir(path)) || !fs::write_file(tmp, fs::rewrite, out) || !fs::rename(tmp, path, true))
+	{
+		ppu_log.error("Failed to save analysis results: %s (%s)", path, fs::g_tls_error);
+		fs::remove_file(tmp);
+	}
+}
+
+static bool ppu_load_analysis(const std::string& path, std::vector<ppu_function>& funcs)
+{
+	const fs::file file(path);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	const auto data = file.to_vector<u8>();
+
+	if (data.size() < 12 + sizeof(u64) || XXH64(data.data(), data.size() - sizeof(u64), 0) != *reinterpret_cast<const be_t<u64, 1>*>(data.data() + data.size() - sizeof(u64)))
+	{
+		ppu_log.error("Analysis cache is corrupted: %s", path);
+		return false;
+	}
+
+	std::size_t pos = 0;
+	const std::size_t end = data.size() - sizeof(u64);
+
+	auto get = [&]() -> u32
+	{
+		if (end - pos < sizeof(u32))
+		{
+			pos = end + 1;
+			return 0;
+		}
+
+		const u32 value = *reinterpret_cast<const be_t<u32, 1>*>(data.data() + pos);
+		pos += sizeof(u32);
+		return value;
+	};
+
+	if (get() != "PPUA"_u32 || get() != s_ppu_analysis_version)
+	{
+		return false;
+	}
+
+	std::vector<ppu_function> result(get());
+
+	for (auto& func : result)
+	{
+		func.addr = get();
+		func.toc = get();
+		func.size = get();
+
+		for (u32 attr = get(), i = 0; i < static_cast<u32>(ppu_attr::__bitset_enum_max); i++)
+		{
+			if (attr & (1u << i))
+			{
+				func.attr += static_cast<ppu_attr>(i);
+			}
+		}
+
+		func.stack_frame = get();
+		func.trampoline = get();
+
+		for (u32 i = 0, count = get(); i < count && pos <= end; i++)
+		{
+			const u32 addr = get();
+			func.blocks.emplace(addr, get());
+		}
+
+		for (u32 i = 0, count = get(); i < count && pos <= end; i++)
+		{
+			func.calls.emplace(get());
+		}
+
+		for (u32 i = 0, count = get(); i < count && pos <= end; i++)
+		{
+			func.callers.emplace(get());
+		}
+
+		const u32 size = get();
+
+		if (pos > end || end - pos < size)
+		{
+			return false;
+		}
+
+		func.name.assign(reinterpret_cast<const char*>(data.data() + pos), size);
+		pos += size;
+	}
+
+	if (pos != end)
+	{
+		return false;
+	}
+
+	funcs = std::move(result);
+	return true;
+}
+
 void ppu_module::analyse(u32 lib_toc, u32 entry)
 {
+	// Load cached results if the module wasn't changed
+	const std::string cache_path = ppu_analysis_path(*this, lib_toc, entry);
+
+	if (ppu_load_analysis(cache_path, funcs))
+	{
+		ppu_log.notice("Function analysis: %zu functions (cached)", funcs.size());
+		return;
+	}
+
 	// Assume first segment is executable
 	const u32 start = segs[0].addr;
 	const u32 end = segs[0].addr + segs[0].size;
@@ -620,26 +813,73 @@ void ppu_module::analyse(u32 lib_toc, u32 entry)
 		return it == known_functions.end() ? end : *it;
 	};
 
-	// Find references indiscriminately
-	for (const auto& seg : segs)
+	// Find references indiscriminately (split into 1 MiB chunks scanned in parallel)
 	{
-		for (vm::cptr<u32> ptr = vm::cast(seg.addr); ptr.addr() < seg.addr + seg.size; ptr++)
-		{
-			const u32 value = *ptr;
+		std::vector<std::pair<u32, u32>> chunks;
 
-			if (value % 4)
+		for (const auto& seg : segs)
+		{
+			for (u32 off = 0; off < seg.size; off += 0x100000)
 			{
-				continue;
+				chunks.emplace_back(seg.addr + off, std::min<u32>(seg.size - off, 0x100000));
 			}
+		}
+
+		std::vector<std::vector<u32>> found(chunks.size());
+		atomic_t<std::size_t> cnext{};
 
-			for (const auto& _seg : segs)
+		auto scan = [&]()
+		{
+			for (std::size_t i = cnext++; i < chunks.size(); i = cnext++)
 			{
-				if (value >= _seg.addr && value < _seg.addr + _seg.size)
+				if (Emu.IsStopped())
 				{
-					addr_heap.emplace(value);
 					break;
 				}
+
+				const auto [addr, size] = chunks[i];
+
+				for (vm::cptr<u32> ptr = vm::cast(addr); ptr.addr() < addr + size; ptr++)
+				{
+					const u32 value = *ptr;
+
+					if (value % 4)
+					{
+						continue;
+					}
+
+					for (const auto& _seg : segs)
+					{
+						if (value >= _seg.addr && value < _seg.addr + _seg.size)
+						{
+							found[i].emplace_back(value);
+							break;
+						}
+					}
+				}
+
+				std::sort(found[i].begin(), found[i].end());
 			}
+		};
+
+		// Use the same number of workers as the LLVM compiler (the current thread takes part)
+		const u32 max_threads = static_cast<u32>(g_cfg.core.llvm_threads);
+		const u32 thread_count = std::min(max_threads > 0 ? std::min(max_threads, std::thread::hardware_concurrency()) : std::thread::hardware_concurrency(), ::size32(chunks));
+
+		{
+			std::deque<named_thread<std::function<void()>>> thread_queue;
+
+			for (u32 i = 1; i < thread_count; i++)
+			{
+				thread_queue.emplace_back("PPU Analyser Worker " + std::to_string(i), scan);
+			}
+
+			scan();
+		}
+
+		for (const auto& values : found)
+		{
+			addr_heap.insert(values.begin(), values.end());
 		}
 	}
 
@@ -1532,6 +1772,14 @@ void ppu_module::analyse(u32 lib_toc, u32 entry)
 	}
 
 	ppu_log.notice("Function analysis: %zu functions (%zu enqueued)", funcs.size(), func_queue.size());
+
+	if (Emu.IsStopped())
+	{
+		// The reference scan may be incomplete
+		return;
+	}
+
+	ppu_save_analysis(cache_path, funcs);
 }
 
 void ppu_acontext::UNK(ppu_opcode_t op)
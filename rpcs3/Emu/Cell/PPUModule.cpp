@@ -931,6 +931,9 @@ std::shared_ptr<lv2_prx> ppu_load_prx(const ppu_prx_object& elf, const std::stri
 		}
 	}
 
+	// Finalize the hash (used by the analyser)
+	sha1_finish(&sha, prx->sha1);
+
 	if (!elf.progs.empty() && elf.progs[0].p_paddr)
 	{
 		struct ppu_prx_library_info
@@ -974,8 +977,6 @@ std::shared_ptr<lv2_prx> ppu_load_prx(const ppu_prx_object& elf, const std::stri
 	prx->name = path.substr(path.find_last_of('/') + 1);
 	prx->path = path;
 
-	sha1_finish(&sha, prx->sha1);
-
 	// Format patch name
 	std::string hash("PRX-0000000000000000000000000000000000000000");
 	for (u32 i = 0; i < 20; i++)
@@ -1,6 +1,7 @@
 ﻿#include "stdafx.h"
 #include "Utilities/VirtualMemory.h"
 #include "Utilities/sysinfo.h"
+#include "Utilities/StrUtil.h"
 #include "Utilities/JIT.h"
 #include "Crypto/sha1.h"
 #include "Emu/Memory/vm_reservation.h"
@@ -164,6 +165,7 @@ extern const ppu_decoder<ppu_interpreter_fast> g_ppu_interpreter_fast([](auto& t
 extern void ppu_initialize();
 extern void ppu_initialize(const ppu_module& info);
 static void ppu_initialize2(class jit_compiler& jit, const ppu_module& module_part, const std::string& cache_path, const std::string& obj_name);
+static void ppu_import_title_cache(const ppu_module& _main);
 extern void ppu_execute_syscall(ppu_thread& ppu, u64 code);
 static bool ppu_break(ppu_thread& ppu, ppu_opcode_t op);
 
@@ -999,18 +1001,29 @@ static T ppu_load_acquire_reservation(ppu_thread& ppu, u32 addr)
 		}
 	}
 
-	ppu.rtime = vm::reservation_acquire(addr, sizeof(T));
-
-	if ((ppu.rtime & 127) == 0) [[likely]]
+	// Optimistic seqlock read (retry shortly before giving up the passive lock)
+	for (u32 i = 0; i < 16; i++)
 	{
-		ppu.rdata = data;
+		ppu.rtime = vm::reservation_acquire(addr, sizeof(T));
 
-		if (vm::reservation_acquire(addr, sizeof(T)) == ppu.rtime) [[likely]]
+		if ((ppu.rtime & 127) == 0) [[likely]]
 		{
-			return static_cast<T>(ppu.rdata << data_off >> size_off);
+			ppu.rdata = data;
+
+			if (vm::reservation_acquire(addr, sizeof(T)) == ppu.rtime) [[likely]]
+			{
+				vm::g_tls_reservation_stats.fast_load++;
+				return static_cast<T>(ppu.rdata << data_off >> size_off);
+			}
 		}
+
+		_mm_pause();
 	}
 
+	vm::g_tls_reservation_stats.slow_load++;
+
+	const u64 start = vm::reservation_prof_time();
+
 	vm::passive_unlock(ppu);
 
 	for (u64 i = 0;; i++)
@@ -1037,17 +1050,20 @@ static T ppu_load_acquire_reservation(ppu_thread& ppu, u32 addr)
 		}
 	}
 
+	vm::reservation_prof_wait(addr, start);
 	vm::passive_lock(ppu);
 	return static_cast<T>(ppu.rdata << data_off >> size_off);
 }
 
 extern u32 ppu_lwarx(ppu_thread& ppu, u32 addr)
 {
+	vm::reservation_prof_op(addr, true);
 	return ppu_load_acquire_reservation<u32>(ppu, addr);
 }
 
 extern u64 ppu_ldarx(ppu_thread& ppu, u32 addr)
 {
+	vm::reservation_prof_op(addr, true);
 	return ppu_load_acquire_reservation<u64>(ppu, addr);
 }
 
@@ -1097,7 +1113,7 @@ const auto ppu_stwcx_tx = build_function_asm<u32(*)(u32 raddr, u64 rtime, u64 rd
 	c.ret();
 });
 
-extern bool ppu_stwcx(ppu_thread& ppu, u32 addr, u32 reg_value)
+static bool ppu_stwcx_internal(ppu_thread& ppu, u32 addr, u32 reg_value)
 {
 	auto& data = vm::_ref<atomic_be_t<u32>>(addr & -4);
 	const u32 old_data = static_cast<u32>(ppu.rdata << ((addr & 7) * 8) >> 32);
@@ -1145,9 +1161,39 @@ extern bool ppu_stwcx(ppu_thread& ppu, u32 addr, u32 reg_value)
 		return false;
 	}
 
+	auto& res = vm::reservation_acquire(addr, sizeof(u32));
+
+	// Try to lock the line without waiting (waiting in passive lock state may deadlock with vm::writer_lock)
+	if (res.compare_and_swap_test(ppu.rtime, ppu.rtime | 1))
+	{
+		ppu.raddr = 0;
+
+		if (data.compare_and_swap_test(old_data, reg_value))
+		{
+			res += 127;
+			vm::reservation_notifier(addr, sizeof(u32)).notify_all();
+			vm::g_tls_reservation_stats.fast_store++;
+			return true;
+		}
+
+		res -= 1;
+		vm::g_tls_reservation_stats.store_fail++;
+		return false;
+	}
+
+	if ((res & -128) != ppu.rtime)
+	{
+		// Reservation lost
+		ppu.raddr = 0;
+		vm::g_tls_reservation_stats.store_fail++;
+		return false;
+	}
+
+	// The line is locked by another writer
+	vm::g_tls_reservation_stats.slow_store++;
 	vm::passive_unlock(ppu);
 
-	auto& res = vm::reservation_lock(addr, sizeof(u32));
+	vm::reservation_lock(addr, sizeof(u32));
 	const u64 old_time = res.load() & -128;
 
 	const bool result = ppu.rtime == old_time && data.compare_and_swap_test(old_data, reg_value);
@@ -1167,6 +1213,13 @@ extern bool ppu_stwcx(ppu_thread& ppu, u32 addr, u32 reg_value)
 	return result;
 }
 
+extern bool ppu_stwcx(ppu_thread& ppu, u32 addr, u32 reg_value)
+{
+	const bool result = ppu_stwcx_internal(ppu, addr, reg_value);
+	vm::reservation_prof_op(addr, result);
+	return result;
+}
+
 const auto ppu_stdcx_tx = build_function_asm<u32(*)(u32 raddr, u64 rtime, u64 rdata, u64 value)>([](asmjit::X86Assembler& c, auto& args)
 {
 	using namespace asmjit;
@@ -1213,7 +1266,7 @@ const auto ppu_stdcx_tx = build_function_asm<u32(*)(u32 raddr, u64 rtime, u64 rd
 	c.ret();
 });
 
-extern bool ppu_stdcx(ppu_thread& ppu, u32 addr, u64 reg_value)
+static bool ppu_stdcx_internal(ppu_thread& ppu, u32 addr, u64 reg_value)
 {
 	auto& data = vm::_ref<atomic_be_t<u64>>(addr & -8);
 	const u64 old_data = ppu.rdata << ((addr & 7) * 8);
@@ -1261,9 +1314,39 @@ extern bool ppu_stdcx(ppu_thread& ppu, u32 addr, u64 reg_value)
 		return false;
 	}
 
+	auto& res = vm::reservation_acquire(addr, sizeof(u64));
+
+	// Try to lock the line without waiting (waiting in passive lock state may deadlock with vm::writer_lock)
+	if (res.compare_and_swap_test(ppu.rtime, ppu.rtime | 1))
+	{
+		ppu.raddr = 0;
+
+		if (data.compare_and_swap_test(old_data, reg_value))
+		{
+			res += 127;
+			vm::reservation_notifier(addr, sizeof(u64)).notify_all();
+			vm::g_tls_reservation_stats.fast_store++;
+			return true;
+		}
+
+		res -= 1;
+		vm::g_tls_reservation_stats.store_fail++;
+		return false;
+	}
+
+	if ((res & -128) != ppu.rtime)
+	{
+		// Reservation lost
+		ppu.raddr = 0;
+		vm::g_tls_reservation_stats.store_fail++;
+		return false;
+	}
+
+	// The line is locked by another writer
+	vm::g_tls_reservation_stats.slow_store++;
 	vm::passive_unlock(ppu);
 
-	auto& res = vm::reservation_lock(addr, sizeof(u64));
+	vm::reservation_lock(addr, sizeof(u64));
 	const u64 old_time = res.load() & -128;
 
 	const bool result = ppu.rtime == old_time && data.compare_and_swap_test(old_data, reg_value);
@@ -1283,6 +1366,13 @@ extern bool ppu_stdcx(ppu_thread& ppu, u32 addr, u64 reg_value)
 	return result;
 }
 
+extern bool ppu_stdcx(ppu_thread& ppu, u32 addr, u64 reg_value)
+{
+	const bool result = ppu_stdcx_internal(ppu, addr, reg_value);
+	vm::reservation_prof_op(addr, result);
+	return result;
+}
+
 extern void ppu_initialize()
 {
 	const auto _main = g_fxo->get<ppu_module>();
@@ -1297,6 +1387,9 @@ extern void ppu_initialize()
 		return;
 	}
 
+	// Import library caches left in the title directory by older versions
+	ppu_import_title_cache(*_main);
+
 	// Initialize main module
 	if (!_main->segs.empty())
 	{
@@ -1320,6 +1413,92 @@ extern void ppu_initialize()
 	spu_cache::initialize();
 }
 
+// Add shared module cache directory to the list of modules used by the title
+static void ppu_add_to_manifest(const std::string& title_dir, const std::string& module_dir)
+{
+	static shared_mutex s_mutex;
+
+	std::lock_guard lock(s_mutex);
+
+	if (!fs::create_path(title_dir))
+	{
+		ppu_log.error("Failed to create cache directory: %s (%s)", title_dir, fs::g_tls_error);
+		return;
+	}
+
+	fs::file manifest(title_dir + "ppu-modules.lst", fs::read + fs::write + fs::create + fs::append);
+
+	if (!manifest)
+	{
+		ppu_log.error("Failed to open PPU cache manifest: %sppu-modules.lst (%s)", title_dir, fs::g_tls_error);
+		return;
+	}
+
+	for (const auto& line : fmt::split(manifest.to_string(), {"\n"}))
+	{
+		if (line == module_dir)
+		{
+			return;
+		}
+	}
+
+	manifest.write(module_dir + '\n');
+}
+
+// Move library caches of the title from its directory (old per-title layout) to the shared cache
+static void ppu_import_title_cache(const ppu_module& _main)
+{
+	if (Emu.GetTitleID().empty() || Emu.GetCat() == "1P")
+	{
+		return;
+	}
+
+	const std::string cache_dir = fs::get_cache_dir() + "cache/";
+	const std::string title_dir = cache_dir + Emu.GetTitleID() + "/";
+
+	// Library cache directories are named ppu-<sha1>-<file> (skip executables)
+	std::vector<std::string> module_dirs;
+
+	for (const auto& entry : fs::dir(title_dir))
+	{
+		const std::string name = fmt::to_lower(entry.name);
+		const std::string ext = name.substr(name.find_last_of('.') + 1);
+
+		if (entry.is_directory && name.compare(0, 4, "ppu-") == 0 && (ext == "sprx" || ext == "prx") && title_dir + entry.name + '/' != _main.cache)
+		{
+			module_dirs.emplace_back(entry.name);
+		}
+	}
+
+	for (const std::string& name : module_dirs)
+	{
+		const std::string from = title_dir + name;
+		const std::string to = cache_dir + name;
+
+		if (fs::is_dir(to))
+		{
+			// Already compiled in the shared cache
+			if (!fs::remove_all(from))
+			{
+				ppu_log.error("Failed to remove old PPU cache: %s (%s)", from, fs::g_tls_error);
+				continue;
+			}
+		}
+		else if (!fs::rename(from, to, false))
+		{
+			ppu_log.error("Failed to move old PPU cache: %s -> %s (%s)", from, to, fs::g_tls_error);
+			continue;
+		}
+
+		ppu_add_to_manifest(title_dir, name + '/');
+	}
+
+	if (!module_dirs.empty())
+	{
+		ppu_log.notice("Imported %u PPU library caches of %s into the shared cache", module_dirs.size(), Emu.GetTitleID());
+	}
+}
+
 extern void ppu_initialize(const ppu_module& info)
 {
 	if (g_cfg.core.ppu_decoder != ppu_decoder_type::llvm)
@@ -1395,24 +1574,22 @@ extern void ppu_initialize(const ppu_module& info)
 	}
 	else
 	{
-		// New PPU cache location
-		cache_path = fs::get_cache_dir() + "cache/";
+		// Shared PPU cache location (content-addressed: identical libraries bundled with different titles share it)
+		const std::string module_dir = fmt::format("ppu-%s-%s/", fmt::base57(info.sha1), info.path.substr(info.path.find_last_of('/') + 1));
 
-		const std::string dev_flash = vfs::get("/dev_flash/");
+		cache_path = fs::get_cache_dir() + "cache/" + module_dir;
 
-		if (info.path.compare(0, dev_flash.size(), dev_flash) != 0 && !Emu.GetTitleID().empty() && Emu.GetCat() != "1P")
+		if (!fs::create_path(cache_path))
 		{
-			// Add prefix for anything except dev_flash files, standalone elfs or PS1 classics
-			cache_path += Emu.GetTitleID();
-			cache_path += '/';
+			fmt::throw_exception("Failed to create cache directory: %s (%s)", cache_path, fs::g_tls_error);
 		}
 
-		// Add PPU hash and filename
-		fmt::append(cache_path, "ppu-%s-%s/", fmt::base57(info.sha1), info.path.substr(info.path.find_last_of('/') + 1));
+		const std::string dev_flash = vfs::get("/dev_flash/");
 
-		if (!fs::create_path(cache_path))
+		if (info.path.compare(0, dev_flash.size(), dev_flash) != 0 && !Emu.GetTitleID().empty() && Emu.GetCat() != "1P")
 		{
-			fmt::throw_exception("Failed to create cache directory: %s (%s)", cache_path, fs::g_tls_error);
+			// Record the module in the title manifest (anything except dev_flash files, standalone elfs or PS1 classics)
+			ppu_add_to_manifest(fs::get_cache_dir() + "cache/" + Emu.GetTitleID() + "/", module_dir);
 		}
 	}
 
@@ -183,6 +183,13 @@ public:
 	cmd64 cmd_get(u32 index) { return cmd_queue[cmd_queue.peek() + index].load(); }
 
 	u64 start_time{0}; // Sleep start timepoint
+
+	// lv2 scheduler queue state (protected by the scheduler mutex)
+	ppu_thread* sched_prev{}; // Previous thread of the same priority
+	ppu_thread* sched_next{}; // Next thread of the same priority
+	s32 sched_prio{}; // Priority used for queueing
+	bool sched_queued = false;
+	u64 sched_ready_time{0}; // Time when the suspended thread became ready (for statistics)
 	const char* current_function{}; // Current function name for diagnosis, optimized for speed.
 	const char* last_function{}; // Sticky copy of current_function, is not cleared on function return
 
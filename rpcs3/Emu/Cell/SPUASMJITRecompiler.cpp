@@ -79,6 +79,8 @@ spu_function_t spu_recompiler::compile(spu_program&& _func)
 		cache->add(func);
 	}
 
+	m_block_size = func.block_size;
+
 	{
 		sha1_context ctx;
 		u8 output[20];
@@ -183,13 +185,31 @@ spu_function_t spu_recompiler::compile(spu_program&& _func)
 		}
 	}
 
+	// Used as the first tier of LLVM recompiler
+	const bool tiered = g_cfg.core.spu_decoder == spu_decoder_type::llvm;
+
+	if (tiered)
+	{
+		// 8-byte instruction for patching (long NOP)
+		for (u8 b : {0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00})
+		{
+			c->db(b);
+		}
+	}
+
 	// Load actual PC and check status
 	c->sub(x86::rsp, 0x28);
 	c->mov(pc0->r32(), SPU_OFF_32(pc));
 	c->cmp(SPU_OFF_32(state), 0);
 	c->jnz(label_stop);
 
-	if (g_cfg.core.spu_prof && g_cfg.core.spu_verification)
+	if (tiered)
+	{
+		// Update block_hash for the LLVM mini-profiler
+		c->mov(x86::rax, m_hash_start);
+		c->mov(SPU_OFF_64(block_hash), x86::rax);
+	}
+	else if (g_cfg.core.spu_prof && g_cfg.core.spu_verification)
 	{
 		c->mov(x86::rax, m_hash_start & -0xffff);
 		c->mov(SPU_OFF_64(block_hash), x86::rax);
@@ -907,6 +927,12 @@ spu_function_t spu_recompiler::compile(spu_program&& _func)
 	// Install compiled function pointer
 	const bool added = !add_loc->compiled && add_loc->compiled.compare_and_swap_test(nullptr, fn);
 
+	if (added && tiered)
+	{
+		// Send work to LLVM compiler threads
+		enqueue_llvm(m_hash_start, add_loc);
+	}
+
 	// Rebuild trampoline if necessary
 	if (!m_spurt->rebuild_ubertrampoline(func.data[0]))
 	{
@@ -1125,7 +1151,7 @@ void spu_recompiler::branch_indirect(spu_opcode_t op, bool jt, bool ret)
 	c->cmp(SPU_OFF_32(state), 0);
 	c->jnz(label_stop);
 
-	if (g_cfg.core.spu_block_size != spu_block_size_type::safe && ret)
+	if (m_block_size != spu_block_size_type::safe && ret)
 	{
 		// Get stack pointer, try to use native return address (check SPU return address)
 		Label fail = c->newLabel();
@@ -1139,7 +1165,7 @@ void spu_recompiler::branch_indirect(spu_opcode_t op, bool jt, bool ret)
 		c->bind(fail);
 	}
 
-	if (jt || g_cfg.core.spu_block_size == spu_block_size_type::giga)
+	if (jt || m_block_size == spu_block_size_type::giga)
 	{
 		if (!instr_table.isValid())
 		{
@@ -1181,7 +1207,7 @@ void spu_recompiler::branch_set_link(u32 target)
 {
 	using namespace asmjit;
 
-	if (g_cfg.core.spu_block_size != spu_block_size_type::safe)
+	if (m_block_size != spu_block_size_type::safe)
 	{
 		// Find instruction at target
 		const auto local = instr_labels.find(target);
@@ -1430,7 +1456,7 @@ void spu_recompiler::STOP(spu_opcode_t op)
 
 	c->add(SPU_OFF_32(pc), 4);
 
-	if (g_cfg.core.spu_block_size == spu_block_size_type::safe)
+	if (m_block_size == spu_block_size_type::safe)
 	{
 		c->jmp(label_stop);
 		m_pos = -1;
@@ -1446,7 +1472,7 @@ void spu_recompiler::SYNC(spu_opcode_t op)
 	// This instruction must be used following a store instruction that modifies the instruction stream.
 	c->mfence();
 
-	if (g_cfg.core.spu_block_size == spu_block_size_type::safe)
+	if (m_block_size == spu_block_size_type::safe)
 	{
 		c->lea(addr->r64(), get_pc(m_pos + 4));
 		c->and_(*addr, 0x3fffc);
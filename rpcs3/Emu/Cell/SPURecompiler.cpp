@@ -9,6 +9,8 @@
 #include "Utilities/sysinfo.h"
 #include "util/init_mutex.hpp"
 
+#include "xxhash.h"
+
 #include "SPUThread.h"
 #include "SPUAnalyser.h"
 #include "SPUInterpreter.h"
@@ -16,6 +18,7 @@
 #include <algorithm>
 #include <mutex>
 #include <thread>
+#include <set>
 
 extern atomic_t<const char*> g_progr;
 extern atomic_t<u32> g_progr_ptotal;
@@ -90,14 +93,27 @@ DECLARE(spu_runtime::tr_interpreter) = []
 	return reinterpret_cast<spu_function_t>(trptr);
 }();
 
+DECLARE(spu_runtime::g_dispatcher_default) = []
+{
+	// Allocate 2^10 positions in data area
+	const auto ptr = reinterpret_cast<decltype(g_dispatcher_default)>(jit_runtime::alloc(sizeof(*g_dispatcher_default), 64, false));
+
+	for (auto& x : *ptr)
+	{
+		x.raw() = tr_dispatch;
+	}
+
+	return ptr;
+}();
+
 DECLARE(spu_runtime::g_dispatcher) = []
 {
-	// Allocate 2^20 positions in data area
+	// Allocate 2^10 page pointers in data area (pages are allocated by rebuild_ubertrampoline)
 	const auto ptr = reinterpret_cast<decltype(g_dispatcher)>(jit_runtime::alloc(sizeof(*g_dispatcher), 64, false));
 
 	for (auto& x : *ptr)
 	{
-		x.raw() = tr_dispatch;
+		x.raw() = g_dispatcher_default;
 	}
 
 	return ptr;
@@ -105,7 +121,7 @@ DECLARE(spu_runtime::g_dispatcher) = []
 
 DECLARE(spu_runtime::tr_all) = []
 {
-	u8* const trptr = jit_runtime::alloc(32, 16);
+	u8* const trptr = jit_runtime::alloc(64, 16);
 	u8* raw = trptr;
 
 	// Load PC: mov eax, [r13 + spu_thread::pc]
@@ -130,14 +146,34 @@ DECLARE(spu_runtime::tr_all) = []
 	*raw++ = 0xe8;
 	*raw++ = 0x0c;
 
-	// Load g_dispatcher to rdx
-	*raw++ = 0x48;
+	// Get page index: mov edx, eax; shr edx, 10
+	*raw++ = 0x89;
+	*raw++ = 0xc2;
+	*raw++ = 0xc1;
+	*raw++ = 0xea;
+	*raw++ = 0x0a;
+
+	// Get position in the page: and eax, 0x3ff
+	*raw++ = 0x25;
+	*raw++ = 0xff;
+	*raw++ = 0x03;
+	*raw++ = 0x00;
+	*raw++ = 0x00;
+
+	// Load g_dispatcher to r8
+	*raw++ = 0x4c;
 	*raw++ = 0x8d;
-	*raw++ = 0x15;
+	*raw++ = 0x05;
 	const s32 r32 = ::narrow<s32>(reinterpret_cast<u64>(g_dispatcher) - reinterpret_cast<u64>(raw) - 4, HERE);
 	std::memcpy(raw, &r32, 4);
 	raw += 4;
 
+	// Load page to rdx: mov rdx, [r8 + rdx * 8]
+	*raw++ = 0x49;
+	*raw++ = 0x8b;
+	*raw++ = 0x14;
+	*raw++ = 0xd0;
+
 	// Update block_hash (set zero): mov [r13 + spu_thread::m_block_hash], 0
 	*raw++ = 0x49;
 	*raw++ = 0xc7;
@@ -282,59 +318,253 @@ DECLARE(spu_runtime::g_interpreter_table) = {};
 
 DECLARE(spu_runtime::g_interpreter) = nullptr;
 
+// SPU cache file header (v2)
+struct spu_cache_header
+{
+	le_t<u32> magic;
+	be_t<u32> version;
+};
+
+// SPU cache record header (v2), followed by program data
+struct spu_cache_record
+{
+	// Number of instructions (0 if the program is in the shared store)
+	be_t<u32> size;
+
+	// Entry point (equal to the lower bound)
+	be_t<u32> addr;
+
+	// XXH64 of the program data
+	be_t<u64> hash;
+};
+
+// Block size strategy record (sidecar file)
+struct spu_cache_profile
+{
+	// Entry point
+	be_t<u32> addr;
+
+	// First instruction at the entry point (raw)
+	le_t<u32> inst;
+
+	// Selected block size type
+	be_t<u32> type;
+};
+
+static constexpr u32 s_spu_cache_magic = "SPUC"_u32;
+static constexpr u32 s_spu_cache_version = 2;
+
+// Decode full record at ptr, returns false if it's incomplete or corrupted
+static bool spu_cache_decode(const u8* ptr, u64 avail, spu_program& res)
+{
+	spu_cache_record rec;
+
+	if (avail < sizeof(rec))
+	{
+		return false;
+	}
+
+	std::memcpy(&rec, ptr, sizeof(rec));
+	ptr += sizeof(rec);
+	avail -= sizeof(rec);
+
+	if (!rec.size || avail < rec.size * 4 || XXH64(ptr, rec.size * 4, 0) != rec.hash)
+	{
+		return false;
+	}
+
+	res.entry_point = rec.addr;
+	res.lower_bound = rec.addr;
+	res.data.resize(rec.size);
+	std::memcpy(res.data.data(), ptr, rec.size * 4);
+	return true;
+}
+
+static std::string spu_store_path(u32 addr, u64 hash)
+{
+	return fmt::format("%scache/spu/%05x-%016llx.dat", fs::get_cache_dir(), addr, hash);
+}
+
 spu_cache::spu_cache(const std::string& loc)
 	: m_file(loc, fs::read + fs::write + fs::create + fs::append)
 {
+	if (!m_file)
+	{
+		return;
+	}
+
+	spu_cache_header header{};
+
+	if (m_file.size() >= sizeof(header))
+	{
+		m_file.seek(0);
+		m_file.read(header);
+	}
+
+	if (header.magic != s_spu_cache_magic || header.version != s_spu_cache_version)
+	{
+		if (m_file.size())
+		{
+			spu_log.error("SPU Cache: Unrecognized file header, discarding: %s", loc);
+		}
+
+		header.magic = s_spu_cache_magic;
+		header.version = s_spu_cache_version;
+
+		m_file.trunc(0);
+		m_file.write(header);
+	}
 }
 
 spu_cache::~spu_cache()
 {
 }
 
-std::deque<spu_program> spu_cache::get()
+std::size_t spu_cache::index()
 {
-	std::deque<spu_program> result;
+	m_data.clear();
+	m_index.clear();
 
 	if (!m_file)
 	{
-		return result;
+		return 0;
 	}
 
-	m_file.seek(0);
+	// Read everything at once, records are decoded later in parallel
+	m_data = m_file.to_vector<u8>();
 
-	// TODO: signal truncated or otherwise broken file
-	while (true)
+	u64 pos = sizeof(spu_cache_header);
+
+	while (m_data.size() - pos >= sizeof(spu_cache_record))
 	{
-		be_t<u32> size;
-		be_t<u32> addr;
-		std::vector<u32> func;
+		spu_cache_record rec;
+		std::memcpy(&rec, m_data.data() + pos, sizeof(rec));
 
-		if (!m_file.read(size) || !m_file.read(addr))
+		const u64 size = u64{rec.size} * 4;
+
+		if (m_data.size() - pos - sizeof(rec) < size)
 		{
 			break;
 		}
 
-		func.resize(size);
+		m_index.emplace_back(pos);
+		pos += sizeof(rec) + size;
+	}
 
-		if (m_file.read(func.data(), func.size() * 4) != func.size() * 4)
+	if (pos != m_data.size())
+	{
+		spu_log.error("SPU Cache: Broken record found at 0x%x (file size 0x%x), truncating.", pos, m_data.size());
+		m_file.trunc(pos);
+		m_data.resize(pos);
+	}
+
+	return m_index.size();
+}
+
+spu_program spu_cache::get(std::size_t index) const
+{
+	spu_program res{};
+
+	const u64 pos = m_index.at(index);
+
+	spu_cache_record rec;
+	std::memcpy(&rec, m_data.data() + pos, sizeof(rec));
+
+	if (rec.size)
+	{
+		if (!spu_cache_decode(m_data.data() + pos, m_data.size() - pos, res))
 		{
-			break;
+			res.data.clear();
 		}
 
-		if (!size || !func[0])
+		return res;
+	}
+
+	// Load referenced program from the shared store
+	const fs::file store(spu_store_path(rec.addr, rec.hash));
+
+	if (!store)
+	{
+		spu_log.error("SPU Cache: Program missing in the shared store: %05x-%016llx", rec.addr, rec.hash);
+		return res;
+	}
+
+	const auto data = store.to_vector<u8>();
+
+	if (data.size() < sizeof(spu_cache_header) || !spu_cache_decode(data.data() + sizeof(spu_cache_header), data.size() - sizeof(spu_cache_header), res) ||
+		res.entry_point != rec.addr)
+	{
+		res.data.clear();
+	}
+
+	return res;
+}
+
+void spu_cache::trim(std::size_t count)
+{
+	if (m_file && count < m_index.size())
+	{
+		spu_log.error("SPU Cache: Dropping %u broken record(s) at 0x%x.", m_index.size() - count, m_index[count]);
+		m_file.trunc(m_index[count]);
+	}
+
+	m_data = {};
+	m_index = {};
+}
+
+void spu_cache::migrate(const std::string& old_loc)
+{
+	const fs::file old(old_loc);
+
+	if (!m_file || !old)
+	{
+		return;
+	}
+
+	std::size_t count = 0;
+
+	// Import only into an empty file
+	if (m_file.size() == sizeof(spu_cache_header))
+	{
+		while (true)
 		{
-			// Skip old format Giga entries
-			continue;
+			be_t<u32> size;
+			be_t<u32> addr;
+			std::vector<u32> func;
+
+			if (!old.read(size) || !old.read(addr) || size > 0x10000)
+			{
+				break;
+			}
+
+			func.resize(size);
+
+			if (old.read(func.data(), func.size() * 4) != func.size() * 4)
+			{
+				break;
+			}
+
+			if (!size || !func[0])
+			{
+				// Skip old format Giga entries
+				continue;
+			}
+
+			spu_program res;
+			res.entry_point = addr;
+			res.lower_bound = addr;
+			res.data = std::move(func);
+			add(res);
+			count++;
 		}
+	}
 
-		spu_program res;
-		res.entry_point = addr;
-		res.lower_bound = addr;
-		res.data = std::move(func);
-		result.emplace_front(std::move(res));
+	if (!fs::remove_file(old_loc))
+	{
+		spu_log.error("SPU Cache: Failed to remove old cache file: %s (%s)", old_loc, fs::g_tls_error);
 	}
 
-	return result;
+	spu_log.notice("SPU Cache: Imported %u programs from %s", count, old_loc);
 }
 
 void spu_cache::add(const spu_program& func)
@@ -344,18 +574,99 @@ void spu_cache::add(const spu_program& func)
 		return;
 	}
 
-	be_t<u32> size = ::size32(func.data);
-	be_t<u32> addr = func.entry_point;
+	spu_cache_record rec;
+	rec.size = ::size32(func.data);
+	rec.addr = func.entry_point;
+	rec.hash = XXH64(func.data.data(), func.data.size() * 4, 0);
+
+	spu_cache_header header;
+	header.magic = s_spu_cache_magic;
+	header.version = s_spu_cache_version;
 
 	const fs::iovec_clone gather[3]
 	{
-		{&size, sizeof(size)},
-		{&addr, sizeof(addr)},
+		{&header, sizeof(header)},
+		{&rec, sizeof(rec)},
 		{func.data.data(), func.data.size() * 4}
 	};
 
+	// Write the program to the shared store unless another title already did
+	const std::string path = spu_store_path(rec.addr, rec.hash);
+
+	if (!fs::is_file(path))
+	{
+		const std::string tmp = fmt::format("%s.%x.tmp", path, std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+		fs::file store(tmp, fs::rewrite);
+
+		const bool ok = store && store.write_gather(gather, 3) == gather[0].iov_len + gather[1].iov_len + gather[2].iov_len;
+
+		store.close();
+
+		if (!ok || !fs::rename(tmp, path, true))
+		{
+			fs::remove_file(tmp);
+		}
+	}
+
+	if (fs::is_file(path))
+	{
+		// Append reference
+		rec.size = 0;
+		m_file.write(rec);
+		return;
+	}
+
 	// Append data
-	m_file.write_gather(gather, 3);
+	m_file.write_gather(gather + 1, 2);
+}
+
+void spu_cache::load_profile(const std::string& loc, spu_runtime& rt)
+{
+	m_prof.open(loc, fs::read + fs::write + fs::create + fs::append);
+
+	if (!m_prof)
+	{
+		spu_log.error("SPU Cache: Failed to open block size profile: %s", loc);
+		return;
+	}
+
+	const auto data = m_prof.to_vector<spu_cache_profile>();
+
+	if (m_prof.size() % sizeof(spu_cache_profile))
+	{
+		spu_log.error("SPU Cache: Broken block size profile (size 0x%x), truncating.", m_prof.size());
+		m_prof.trunc(data.size() * sizeof(spu_cache_profile));
+	}
+
+	std::size_t count = 0;
+
+	for (const auto& rec : data)
+	{
+		if (rec.type <= static_cast<u32>(spu_block_size_type::giga) && rt.set_block_size(rec.addr, rec.inst, static_cast<spu_block_size_type>(+rec.type)))
+		{
+			count++;
+		}
+	}
+
+	if (count)
+	{
+		spu_log.notice("SPU Cache: Loaded block size strategy for %u program entries.", count);
+	}
+}
+
+void spu_cache::add_profile(u32 entry, u32 inst, spu_block_size_type type)
+{
+	if (!m_prof)
+	{
+		return;
+	}
+
+	spu_cache_profile rec;
+	rec.addr = entry;
+	rec.inst = inst;
+	rec.type = static_cast<u32>(type);
+	m_prof.write(rec);
 }
 
 void spu_cache::initialize()
@@ -364,7 +675,7 @@ void spu_cache::initialize()
 
 	if (g_cfg.core.spu_decoder == spu_decoder_type::precise || g_cfg.core.spu_decoder == spu_decoder_type::fast)
 	{
-		for (auto& x : *spu_runtime::g_dispatcher)
+		for (auto& x : *spu_runtime::g_dispatcher_default)
 		{
 			x.raw() = spu_runtime::tr_interpreter;
 		}
@@ -378,7 +689,8 @@ void spu_cache::initialize()
 	}
 
 	// SPU cache file (version + block size type)
-	const std::string loc = ppu_cache + "spu-" + fmt::to_lower(g_cfg.core.spu_block_size.to_string()) + "-v1-tane.dat";
+	const std::string loc_base = ppu_cache + "spu-" + fmt::to_lower(g_cfg.core.spu_block_size.to_string());
+	const std::string loc = loc_base + "-v2-tane.dat";
 
 	spu_cache cache(loc);
 
@@ -388,11 +700,25 @@ void spu_cache::initialize()
 		return;
 	}
 
-	// Read cache
-	auto func_list = cache.get();
+	// Shared program store (content-addressed, all titles)
+	fs::create_dir(fs::get_cache_dir() + "cache/spu/");
+
+	if (fs::is_file(loc_base + "-v1-tane.dat"))
+	{
+		cache.migrate(loc_base + "-v1-tane.dat");
+	}
+
+	// Per-program block size strategy (must be applied before building)
+	cache.load_profile(loc_base + "-v2-prof.dat", *g_fxo->get<spu_runtime>());
+
+	// Index cache (records are decoded by the workers)
+	const std::size_t func_count = cache.index();
 	atomic_t<std::size_t> fnext{};
 	atomic_t<u8> fail_flag{0};
 
+	// Set for records which failed the checksum test
+	std::vector<u8> fbad(func_count);
+
 	// Initialize compiler instances for parallel compilation
 	u32 max_threads = static_cast<u32>(g_cfg.core.llvm_threads);
 	u32 thread_count = max_threads > 0 ? std::min(max_threads, std::thread::hardware_concurrency()) : std::thread::hardware_concurrency();
@@ -439,7 +765,7 @@ void spu_cache::initialize()
 		compiler->init();
 	}
 
-	if (compilers.size() && !func_list.empty())
+	if (compilers.size() && func_count)
 	{
 		// Initialize progress dialog (wait for previous progress done)
 		while (g_progr_ptotal)
@@ -448,7 +774,7 @@ void spu_cache::initialize()
 		}
 
 		g_progr = "Building SPU cache...";
-		g_progr_ptotal += func_list.size();
+		g_progr_ptotal += ::size32(func_count);
 	}
 
 	std::deque<named_thread<std::function<void()>>> thread_queue;
@@ -458,17 +784,25 @@ void spu_cache::initialize()
 		// Fake LS
 		std::vector<be_t<u32>> ls(0x10000);
 
-		// Build functions
-		for (std::size_t func_i = fnext++; func_i < func_list.size(); func_i = fnext++)
+		// Build functions (latest first)
+		for (std::size_t func_i = fnext++; func_i < func_count; func_i = fnext++)
 		{
-			const spu_program& func = std::as_const(func_list)[func_i];
-
 			if (Emu.IsStopped() || fail_flag)
 			{
 				g_progr_pdone++;
 				continue;
 			}
 
+			const std::size_t rec_i = func_count - 1 - func_i;
+			const spu_program func = cache.get(rec_i);
+
+			if (func.data.empty())
+			{
+				fbad[rec_i] = 1;
+				g_progr_pdone++;
+				continue;
+			}
+
 			// Get data start
 			const u32 start = func.lower_bound;
 			const u32 size0 = ::size32(func.data);
@@ -479,8 +813,19 @@ void spu_cache::initialize()
 				ls[pos / 4] = std::bit_cast<be_t<u32>>(func.data[i]);
 			}
 
-			// Call analyser
-			spu_program func2 = compiler->analyse(ls.data(), func.entry_point);
+			// Call analyser (try the profiled strategy, then the configured one and lower)
+			const u32 inst = func.data[(func.entry_point - func.lower_bound) / 4];
+			const spu_block_size_type type = compiler->get_runtime().get_block_size(func.entry_point, inst);
+
+			spu_program func2 = compiler->analyse(ls.data(), func.entry_point, type);
+
+			for (u32 t = static_cast<u32>(g_cfg.core.spu_block_size.get()) + 1; func2 != func && t--;)
+			{
+				if (t != static_cast<u32>(type))
+				{
+					func2 = compiler->analyse(ls.data(), func.entry_point, static_cast<spu_block_size_type>(t));
+				}
+			}
 
 			if (func2 != func)
 			{
@@ -517,9 +862,24 @@ void spu_cache::initialize()
 		return;
 	}
 
-	if (compilers.size() && !func_list.empty())
+	if (const std::size_t bad_count = std::count(fbad.begin(), fbad.end(), 1))
+	{
+		spu_log.error("SPU Runtime: %u cached program(s) failed the checksum test.", bad_count);
+	}
+
+	// Drop the corrupted tail (if any) and release the index
+	std::size_t good_count = func_count;
+
+	while (good_count && fbad[good_count - 1])
+	{
+		good_count--;
+	}
+
+	cache.trim(good_count);
+
+	if (compilers.size() && func_count)
 	{
-		spu_log.success("SPU Runtime: Built %u functions.", func_list.size());
+		spu_log.success("SPU Runtime: Built %u functions.", func_count);
 	}
 
 	// Initialize global cache instance
@@ -581,6 +941,41 @@ spu_runtime::spu_runtime()
 	}
 }
 
+spu_runtime::~spu_runtime()
+{
+	for (auto& page : m_stuff)
+	{
+		delete page.load();
+	}
+}
+
+lf_bunch<spu_item>& spu_runtime::get_bunch(u32 id_inst)
+{
+	auto& page = m_stuff[id_inst >> 22];
+
+	if (!page)
+	{
+		auto _new = new bunch_page();
+
+		if (!page.compare_and_swap_test(nullptr, _new))
+		{
+			delete _new;
+		}
+	}
+
+	return (*page.load())[(id_inst >> 12) % 1024];
+}
+
+const lf_bunch<spu_item>* spu_runtime::find_bunch(u32 id_inst) const
+{
+	if (const auto page = m_stuff[id_inst >> 22].load())
+	{
+		return &(*page)[(id_inst >> 12) % 1024];
+	}
+
+	return nullptr;
+}
+
 spu_item* spu_runtime::add_empty(spu_program&& data)
 {
 	if (data.data.empty())
@@ -592,7 +987,7 @@ spu_item* spu_runtime::add_empty(spu_program&& data)
 	spu_item* prev = nullptr;
 
 	//Try to add item that doesn't exist yet
-	const auto ret = m_stuff[data.data[0] >> 12].push_if([&](spu_item& _new, spu_item& _old)
+	const auto ret = get_bunch(data.data[0]).push_if([&](spu_item& _new, spu_item& _old)
 	{
 		if (_new.data == _old.data)
 		{
@@ -616,9 +1011,11 @@ spu_function_t spu_runtime::rebuild_ubertrampoline(u32 id_inst)
 	// Prepare sorted list
 	static thread_local std::vector<std::pair<std::basic_string_view<u32>, spu_function_t>> m_flat_list;
 
+	auto& bunch = get_bunch(id_inst);
+
 	// Remember top position
-	auto stuff_it = m_stuff.at(id_inst >> 12).begin();
-	auto stuff_end = m_stuff.at(id_inst >> 12).end();
+	auto stuff_it = bunch.begin();
+	auto stuff_end = bunch.end();
 	{
 		if (stuff_it->trampoline)
 		{
@@ -643,12 +1040,44 @@ spu_function_t spu_runtime::rebuild_ubertrampoline(u32 id_inst)
 		}
 	}
 
-	std::sort(m_flat_list.begin(), m_flat_list.end(), [&](const auto& a, const auto& b)
+	const u32 size0 = ::size32(m_flat_list);
+
+	// Guard stub chained to the previous ubertrampoline (avoid full rebuild)
+	spu_function_t stub = nullptr;
+
+	// Number of guard stubs in front of the last full ubertrampoline
+	u32 depth = 0;
+
+	if (size0 > 1 && stuff_it != stuff_end && stuff_it->compiled)
 	{
-		std::basic_string_view<u32> lhs = a.first;
-		std::basic_string_view<u32> rhs = b.first;
-		return lhs < rhs;
-	});
+		auto prev_it = stuff_it;
+
+		while (++prev_it != stuff_end && !prev_it->compiled)
+		{
+		}
+
+		// Previous ubertrampoline must cover all other functions
+		if (prev_it != stuff_end && prev_it->depth < 8 && prev_it->covered + 1 == size0)
+		{
+			if (const auto prev = prev_it->trampoline.load())
+			{
+				stub = make_guard_stub(*stuff_it, bunch, prev);
+				depth = prev_it->depth + 1;
+			}
+		}
+	}
+
+	if (!stub)
+	{
+		depth = 0;
+
+		std::sort(m_flat_list.begin(), m_flat_list.end(), [&](const auto& a, const auto& b)
+		{
+			std::basic_string_view<u32> lhs = a.first;
+			std::basic_string_view<u32> rhs = b.first;
+			return lhs < rhs;
+		});
+	}
 
 	struct work
 	{
@@ -666,11 +1095,10 @@ spu_function_t spu_runtime::rebuild_ubertrampoline(u32 id_inst)
 	// Generate a dispatcher (übertrampoline)
 	const auto beg = m_flat_list.begin();
 	const auto _end = m_flat_list.end();
-	const u32 size0 = ::size32(m_flat_list);
 
-	auto result = beg->second;
+	auto result = stub ? stub : beg->second;
 
-	if (size0 != 1)
+	if (!stub && size0 != 1)
 	{
 		// Allocate some writable executable memory
 		u8* const wxptr = jit_runtime::alloc(size0 * 22 + 14, 16);
@@ -939,50 +1367,184 @@ spu_function_t spu_runtime::rebuild_ubertrampoline(u32 id_inst)
 			}
 		}
 
-		workload.clear();
-		result = reinterpret_cast<spu_function_t>(reinterpret_cast<u64>(wxptr));
+		workload.clear();
+		result = reinterpret_cast<spu_function_t>(reinterpret_cast<u64>(wxptr));
+	}
+
+	stuff_it->depth = depth;
+	stuff_it->covered = size0;
+
+	if (auto _old = stuff_it->trampoline.compare_and_swap(nullptr, result))
+	{
+		return _old;
+	}
+
+	// Install ubertrampoline (allocate dispatcher page if necessary)
+	auto& page = spu_runtime::g_dispatcher->at(id_inst >> 22);
+
+	if (page.load() == g_dispatcher_default)
+	{
+		const auto _new = reinterpret_cast<dispatcher_page*>(jit_runtime::alloc(sizeof(dispatcher_page), 64, false));
+
+		if (!_new)
+		{
+			return nullptr;
+		}
+
+		for (auto& x : *_new)
+		{
+			x.raw() = tr_dispatch;
+		}
+
+		page.compare_and_swap(g_dispatcher_default, _new);
+	}
+
+	auto& insert_to = page.load()->at((id_inst >> 12) % 1024);
+
+	auto _old = insert_to.load();
+
+	do
+	{
+		// Make sure we are replacing an older ubertrampoline but not newer one
+		if (_old != tr_dispatch)
+		{
+			bool ok = false;
+
+			for (auto it = stuff_it; it != stuff_end; ++it)
+			{
+				if (it->trampoline == _old)
+				{
+					ok = true;
+					break;
+				}
+			}
+
+			if (!ok)
+			{
+				return result;
+			}
+		}
+	}
+	while (!insert_to.compare_exchange(_old, result));
+
+	return result;
+}
+
+spu_function_t spu_runtime::make_guard_stub(const spu_item& top, const lf_bunch<spu_item>& bunch, spu_function_t prev) const
+{
+	std::basic_string_view<u32> range{top.data.data.data(), top.data.data.size()};
+	range.remove_prefix((top.data.entry_point - top.data.lower_bound) / 4);
+
+	// Positions (in words from the entry point) distinguishing the function from all others
+	std::basic_string<u32> levels;
+
+	for (auto& item : bunch)
+	{
+		if (&item == &top || !item.compiled)
+		{
+			continue;
+		}
+
+		std::basic_string_view<u32> other{item.data.data.data(), item.data.data.size()};
+		other.remove_prefix((item.data.entry_point - item.data.lower_bound) / 4);
+
+		const u32 level = ::narrow<u32>(std::mismatch(range.begin(), range.end(), other.begin(), other.end()).first - range.begin(), HERE);
+
+		if (level >= range.size() || !range[level])
+		{
+			// Cannot distinguish: function is a prefix of another one or the difference is in a hole
+			return nullptr;
+		}
+
+		if (levels.find(level) == levels.npos)
+		{
+			levels += level;
+		}
+
+		if (levels.size() > 8)
+		{
+			// Too many comparisons, full rebuild is preferred
+			return nullptr;
+		}
 	}
 
-	if (auto _old = stuff_it->trampoline.compare_and_swap(nullptr, result))
+	std::sort(levels.begin(), levels.end());
+
+	// Allocate some writable executable memory
+	u8* const wxptr = jit_runtime::alloc(::size32(levels) * 17 + 5, 16);
+
+	if (!wxptr)
 	{
-		return _old;
+		return nullptr;
 	}
 
-	// Install ubertrampoline
-	auto& insert_to = spu_runtime::g_dispatcher->at(id_inst >> 12);
-
-	auto _old = insert_to.load();
+	u8* raw = wxptr;
 
-	do
+	// Write jump instruction with rel32 immediate
+	auto make_jump = [&](u8 op, spu_function_t target)
 	{
-		// Make sure we are replacing an older ubertrampoline but not newer one
-		if (_old != tr_dispatch)
+		const s64 rel = reinterpret_cast<u64>(target) - reinterpret_cast<u64>(raw) - (op != 0xe9 ? 6 : 5);
+
+		verify(HERE), rel >= INT32_MIN, rel <= INT32_MAX;
+
+		if (op != 0xe9)
 		{
-			bool ok = false;
+			// First jcc byte
+			*raw++ = 0x0f;
+		}
 
-			for (auto it = stuff_it; it != stuff_end; ++it)
-			{
-				if (it->trampoline == _old)
-				{
-					ok = true;
-					break;
-				}
-			}
+		*raw++ = op;
 
-			if (!ok)
-			{
-				return result;
-			}
+		const s32 r32 = static_cast<s32>(rel);
+
+		std::memcpy(raw, &r32, 4);
+		raw += 4;
+	};
+
+	// LS address starting from PC is already loaded into rcx (see spu_runtime::tr_all)
+	for (u32 level : levels)
+	{
+		// Emit load: mov eax, [rcx + addr]
+		const u32 cmp_lsa = level * 4u;
+
+		if (cmp_lsa < 0x80)
+		{
+			*raw++ = 0x8b;
+			*raw++ = 0x41;
+			*raw++ = ::narrow<s8>(cmp_lsa);
+		}
+		else
+		{
+			*raw++ = 0x8b;
+			*raw++ = 0x81;
+			std::memcpy(raw, &cmp_lsa, 4);
+			raw += 4;
 		}
+
+		// Emit comparison: cmp eax, imm32
+		*raw++ = 0x3d;
+		std::memcpy(raw, &range[level], 4);
+		raw += 4;
+
+		// Mismatch: try previous ubertrampoline
+		make_jump(0x85, prev); // jne rel32
 	}
-	while (!insert_to.compare_exchange(_old, result));
 
-	return result;
+	make_jump(0xe9, top.compiled); // jmp rel32
+
+	return reinterpret_cast<spu_function_t>(wxptr);
 }
 
 spu_function_t spu_runtime::find(const u32* ls, u32 addr) const
 {
-	for (auto& item : m_stuff.at(ls[addr / 4] >> 12))
+	const auto bunch = find_bunch(ls[addr / 4]);
+
+	if (!bunch)
+	{
+		return nullptr;
+	}
+
+	for (auto& item : *bunch)
 	{
 		if (const auto ptr = item.compiled.load())
 		{
@@ -1004,6 +1566,88 @@ spu_function_t spu_runtime::find(const u32* ls, u32 addr) const
 	return nullptr;
 }
 
+spu_block_size_type spu_runtime::get_block_size(u32 entry, u32 inst) const
+{
+	const spu_block_size_type type = g_cfg.core.spu_block_size;
+
+	reader_lock lock(m_prof_mutex);
+
+	if (const auto found = m_prof.find(u64{entry} << 32 | inst); found != m_prof.end() && found->second < type)
+	{
+		return found->second;
+	}
+
+	return type;
+}
+
+bool spu_runtime::set_block_size(u32 entry, u32 inst, spu_block_size_type type)
+{
+	std::lock_guard lock(m_prof_mutex);
+
+	const auto [found, ok] = m_prof.try_emplace(u64{entry} << 32 | inst, type);
+
+	if (!ok)
+	{
+		// Strategy can only be lowered
+		if (found->second <= type)
+		{
+			return false;
+		}
+
+		found->second = type;
+	}
+
+	return true;
+}
+
+void spu_runtime::add_miss(const spu_program& data)
+{
+	if (data.data.empty() || data.block_size == spu_block_size_type::safe)
+	{
+		return;
+	}
+
+	const u32 inst = data.data[(data.entry_point - data.lower_bound) / 4];
+
+	const auto bunch = find_bunch(data.data[0]);
+
+	if (!bunch)
+	{
+		return;
+	}
+
+	// Count other programs built from the same entry point with the same strategy
+	u32 count = 0;
+
+	for (auto& item : *bunch)
+	{
+		const spu_program& prog = item.data;
+
+		if (prog.entry_point == data.entry_point && prog.block_size == data.block_size && prog.data[(prog.entry_point - prog.lower_bound) / 4] == inst && prog != data)
+		{
+			count++;
+		}
+	}
+
+	// Large blocks keep being invalidated by code modifications: use smaller blocks for this entry
+	if (count < 3)
+	{
+		return;
+	}
+
+	const auto type = static_cast<spu_block_size_type>(static_cast<u32>(data.block_size) - 1);
+
+	if (set_block_size(data.entry_point, inst, type))
+	{
+		spu_log.notice("[0x%05x] Block size lowered to %s (%u variants)", data.entry_point, type, count + 1);
+
+		if (auto cache = g_fxo->get<spu_cache>(); cache && g_cfg.core.spu_cache)
+		{
+			cache->add_profile(data.entry_point, inst, type);
+		}
+	}
+}
+
 spu_function_t spu_runtime::make_branch_patchpoint(u16 data) const
 {
 	u8* const raw = jit_runtime::alloc(16, 16);
@@ -1067,7 +1711,7 @@ void spu_recompiler_base::dispatch(spu_thread& spu, void*, u8* rip)
 	}
 
 	// Second attempt (recover from the recursion after repeated unsuccessful trampoline call)
-	if (spu.block_counter != spu.block_recover && &dispatch != spu_runtime::g_dispatcher->at(spu._ref<nse_t<u32>>(spu.pc) >> 12))
+	if (spu.block_counter != spu.block_recover && &dispatch != spu_runtime::get_dispatcher(spu._ref<nse_t<u32>>(spu.pc)))
 	{
 		spu.block_recover = spu.block_counter;
 		return;
@@ -1082,7 +1726,12 @@ void spu_recompiler_base::dispatch(spu_thread& spu, void*, u8* rip)
 		return;
 	}
 
-	const auto func = spu.jit->compile(spu.jit->analyse(spu._ptr<u32>(0), spu.pc));
+	spu_program prog = spu.jit->analyse(spu._ptr<u32>(0), spu.pc);
+
+	// Update block size statistics
+	spu.jit->get_runtime().add_miss(prog);
+
+	const auto func = spu.jit->compile(std::move(prog));
 
 	if (!func)
 	{
@@ -1191,12 +1840,19 @@ catch (const std::exception& e)
 }
 
 spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
+{
+	return analyse(ls, entry_point, get_runtime().get_block_size(entry_point, std::bit_cast<u32>(ls[entry_point / 4])));
+}
+
+spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point, spu_block_size_type type)
 {
 	// Result: addr + raw instruction data
 	spu_program result;
 	result.data.reserve(10000);
 	result.entry_point = entry_point;
 	result.lower_bound = entry_point;
+	result.block_size = type;
+	m_block_size = type;
 
 	// Initialize block entries
 	m_block_info.reset();
@@ -1246,7 +1902,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 	u32 lsa = entry_point;
 	u32 limit = 0x40000;
 
-	if (g_cfg.core.spu_block_size == spu_block_size_type::giga)
+	if (m_block_size == spu_block_size_type::giga)
 	{
 	}
 
@@ -1340,7 +1996,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 				continue;
 			}
 
-			if (g_cfg.core.spu_block_size == spu_block_size_type::safe)
+			if (m_block_size == spu_block_size_type::safe)
 			{
 				// Stop on special instructions (TODO)
 				m_targets[pos];
@@ -1401,7 +2057,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 
 				m_targets[pos].push_back(target);
 
-				if (g_cfg.core.spu_block_size == spu_block_size_type::giga)
+				if (m_block_size == spu_block_size_type::giga)
 				{
 					if (sync)
 					{
@@ -1423,7 +2079,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 					limit = std::min<u32>(limit, target);
 				}
 
-				if (sl && g_cfg.core.spu_block_size != spu_block_size_type::safe)
+				if (sl && m_block_size != spu_block_size_type::safe)
 				{
 					m_ret_info[pos / 4 + 1] = true;
 					m_entry_info[pos / 4 + 1] = true;
@@ -1431,7 +2087,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 					add_block(pos + 4);
 				}
 			}
-			else if (type == spu_itype::BI && g_cfg.core.spu_block_size != spu_block_size_type::safe && !op.d && !op.e && !sync)
+			else if (type == spu_itype::BI && m_block_size != spu_block_size_type::safe && !op.d && !op.e && !sync)
 			{
 				// Analyse jump table (TODO)
 				std::basic_string<u32> jt_abs;
@@ -1571,7 +2227,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 
 			if (type == spu_itype::BI || sl)
 			{
-				if (type == spu_itype::BI || g_cfg.core.spu_block_size == spu_block_size_type::safe)
+				if (type == spu_itype::BI || m_block_size == spu_block_size_type::safe)
 				{
 					m_targets[pos];
 				}
@@ -1610,7 +2266,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 
 			m_targets[pos].push_back(target);
 
-			if (g_cfg.core.spu_block_size != spu_block_size_type::safe)
+			if (m_block_size != spu_block_size_type::safe)
 			{
 				m_ret_info[pos / 4 + 1] = true;
 				m_entry_info[pos / 4 + 1] = true;
@@ -1618,14 +2274,14 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 				add_block(pos + 4);
 			}
 
-			if (g_cfg.core.spu_block_size == spu_block_size_type::giga && !sync)
+			if (m_block_size == spu_block_size_type::giga && !sync)
 			{
 				m_entry_info[target / 4] = true;
 				add_block(target);
 			}
 			else
 			{
-				if (g_cfg.core.spu_block_size == spu_block_size_type::giga)
+				if (m_block_size == spu_block_size_type::giga)
 				{
 					spu_log.notice("[0x%x] At 0x%x: ignoring fixed call to 0x%x (SYNC)", entry_point, pos, target);
 				}
@@ -1644,14 +2300,14 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 		{
 			const u32 target = spu_branch_target(0, op.i16);
 
-			if (g_cfg.core.spu_block_size == spu_block_size_type::giga && !sync)
+			if (m_block_size == spu_block_size_type::giga && !sync)
 			{
 				m_entry_info[target / 4] = true;
 				add_block(target);
 			}
 			else
 			{
-				if (g_cfg.core.spu_block_size == spu_block_size_type::giga)
+				if (m_block_size == spu_block_size_type::giga)
 				{
 					spu_log.notice("[0x%x] At 0x%x: ignoring fixed tail call to 0x%x (SYNC)", entry_point, pos, target);
 				}
@@ -2035,7 +2691,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 					continue;
 				}
 
-				if (g_cfg.core.spu_block_size != spu_block_size_type::giga)
+				if (m_block_size != spu_block_size_type::giga)
 				{
 					result.data.resize(valid_size);
 					break;
@@ -2290,7 +2946,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 			pred = std::prev(m_bbs.upper_bound(pred))->first;
 		}
 
-		if (m_entry_info[addr / 4] && g_cfg.core.spu_block_size == spu_block_size_type::giga)
+		if (m_entry_info[addr / 4] && m_block_size == spu_block_size_type::giga)
 		{
 			// Register empty chunk
 			m_chunks.push_back(addr);
@@ -2304,7 +2960,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 	}
 
 	// Ensure there is a function at the lowest address
-	if (g_cfg.core.spu_block_size == spu_block_size_type::giga)
+	if (m_block_size == spu_block_size_type::giga)
 	{
 		if (auto emp = m_funcs.try_emplace(m_bbs.begin()->first); emp.second)
 		{
@@ -2316,7 +2972,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 	}
 
 	// Split functions
-	while (g_cfg.core.spu_block_size == spu_block_size_type::giga)
+	while (m_block_size == spu_block_size_type::giga)
 	{
 		bool need_repeat = false;
 
@@ -2517,7 +3173,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 				}
 			}
 
-			if (g_cfg.core.spu_block_size == spu_block_size_type::giga && m_entry_info[addr / 4] && !m_ret_info[addr / 4])
+			if (m_block_size == spu_block_size_type::giga && m_entry_info[addr / 4] && !m_ret_info[addr / 4])
 			{
 				for (u32 i = 0; i < s_reg_max; i++)
 				{
@@ -2558,7 +3214,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 						}
 					}
 
-					if (g_cfg.core.spu_block_size == spu_block_size_type::giga && tb.func == block.func && tb.reg_origin_abs[i] + 2)
+					if (m_block_size == spu_block_size_type::giga && tb.func == block.func && tb.reg_origin_abs[i] + 2)
 					{
 						const u32 expected = block.reg_mod[i] ? addr : block.reg_origin_abs[i];
 
@@ -2611,7 +3267,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 	// Fill more block info
 	for (u32 wi = 0; wi < workload.size(); wi++)
 	{
-		if (g_cfg.core.spu_block_size != spu_block_size_type::giga)
+		if (m_block_size != spu_block_size_type::giga)
 		{
 			break;
 		}
@@ -2945,7 +3601,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 	// Check function blocks, verify and print some reasons
 	for (auto& f : m_funcs)
 	{
-		if (g_cfg.core.spu_block_size != spu_block_size_type::giga)
+		if (m_block_size != spu_block_size_type::giga)
 		{
 			break;
 		}
@@ -3082,7 +3738,7 @@ spu_program spu_recompiler_base::analyse(const be_t<u32>* ls, u32 entry_point)
 	}
 
 	// Check function call graph
-	while (g_cfg.core.spu_block_size == spu_block_size_type::giga)
+	while (m_block_size == spu_block_size_type::giga)
 	{
 		bool need_repeat = false;
 
@@ -3217,11 +3873,24 @@ void spu_recompiler_base::dump(const spu_program& result, std::string& out)
 #pragma GCC diagnostic pop
 #endif
 
+// Host functions called from SPU LLVM code (name -> address), used to link persistent objects
+static shared_mutex s_spu_llvm_link_mutex;
+static std::unordered_map<std::string, u64> s_spu_llvm_link;
+
+// Increment when changing code generation to invalidate persistent objects
+static constexpr u32 s_spu_llvm_version = 1;
+
 class spu_llvm_recompiler : public spu_recompiler_base, public cpu_translator
 {
 	// JIT Instance
 	jit_compiler m_jit{{}, jit_compiler::cpu(g_cfg.core.llvm_cpu)};
 
+	// Persistent object name suffix (recompiler version and settings), empty if disabled
+	std::string m_obj_suffix;
+
+	// External symbols referenced by the current module
+	std::set<std::string> m_link_names;
+
 	// Interpreter table size power
 	const u8 m_interp_magn;
 
@@ -3368,7 +4037,7 @@ class spu_llvm_recompiler : public spu_recompiler_base, public cpu_translator
 
 		empl.first->second.chunk = result;
 
-		if (g_cfg.core.spu_block_size == spu_block_size_type::giga)
+		if (m_block_size == spu_block_size_type::giga)
 		{
 			// Find good real function
 			const auto ffound = m_funcs.find(addr);
@@ -3415,6 +4084,7 @@ class spu_llvm_recompiler : public spu_recompiler_base, public cpu_translator
 			// Register under a unique linkable name
 			const std::string ppname = fmt::format("%s-pp-%u", m_hash, m_pp_id++);
 			m_engine->updateGlobalMapping(ppname, reinterpret_cast<u64>(m_spurt->make_branch_patchpoint()));
+			m_link_names.emplace(ppname);
 
 			// Create function with not exactly correct type
 			const auto ppfunc = llvm::cast<llvm::Function>(m_module->getOrInsertFunction(ppname, m_finfo->chunk->getFunctionType()).getCallee());
@@ -4143,6 +4813,126 @@ class spu_llvm_recompiler : public spu_recompiler_base, public cpu_translator
 		m_ir->SetInsertPoint(_body);
 	}
 
+	// Register host symbol for the current module
+	void link_host(const std::string& name, u64 addr)
+	{
+		m_engine->updateGlobalMapping(name, addr);
+		m_link_names.emplace(name);
+
+		std::lock_guard lock(s_spu_llvm_link_mutex);
+		s_spu_llvm_link.emplace(name, addr);
+	}
+
+	// Call host function (hides cpu_translator::call to register the symbol)
+	template <typename RT, typename... FArgs, typename... Args>
+	llvm::CallInst* call(std::string_view lame, RT(*_func)(FArgs...), Args... args)
+	{
+		const auto inst = cpu_translator::call(lame, _func, args...);
+		link_host(std::string(lame), reinterpret_cast<u64>(_func));
+		return inst;
+	}
+
+	// Register every host function which can be referenced by persistent objects
+	static void register_host_symbols()
+	{
+		const std::pair<const char*, u64> symbols[]
+		{
+			{"spu_dispatcher", reinterpret_cast<u64>(spu_runtime::tr_all)},
+			{"spu_dispatch", reinterpret_cast<u64>(spu_runtime::tr_dispatch)},
+			{"spu_escape", reinterpret_cast<u64>(spu_runtime::g_escape)},
+			{"spu_exec_check_state", reinterpret_cast<u64>(&exec_check_state)},
+			{"spu_interp_check", reinterpret_cast<u64>(&interp_check)},
+			{"spu_unknown", reinterpret_cast<u64>(&exec_unk)},
+			{"spu_syscall", reinterpret_cast<u64>(&exec_stop)},
+			{"spu_read_channel", reinterpret_cast<u64>(&exec_rdch)},
+			{"spu_read_in_mbox", reinterpret_cast<u64>(&exec_read_in_mbox)},
+			{"spu_read_decrementer", reinterpret_cast<u64>(&exec_read_dec)},
+			{"spu_read_events", reinterpret_cast<u64>(&exec_read_events)},
+			{"spu_read_channel_count", reinterpret_cast<u64>(&exec_rchcnt)},
+			{"spu_get_events", reinterpret_cast<u64>(&exec_get_events)},
+			{"spu_write_channel", reinterpret_cast<u64>(&exec_wrch)},
+			{"spu_list_unstall", reinterpret_cast<u64>(&exec_list_unstall)},
+			{"spu_memcpy", reinterpret_cast<u64>(&exec_memcpy)},
+			{"spu_exec_mfc_cmd", reinterpret_cast<u64>(&exec_mfc_cmd)},
+			{"spu_check_interrupts", reinterpret_cast<u64>(&exec_check_interrupts)},
+			{"get_timebased_time", reinterpret_cast<u64>(&get_timebased_time)},
+		};
+
+		std::lock_guard lock(s_spu_llvm_link_mutex);
+
+		for (const auto& [name, addr] : symbols)
+		{
+			s_spu_llvm_link.emplace(name, addr);
+		}
+	}
+
+	// Try to load persistent object, returns main function on success
+	spu_function_t load_object(const std::string& path)
+	{
+		const fs::file sym(path + ".sym");
+
+		if (!sym)
+		{
+			return nullptr;
+		}
+
+		for (const std::string& name : fmt::split(sym.to_string(), {"\n"}))
+		{
+			if (name.compare(0, m_hash.size() + 4, m_hash + "-pp-") == 0)
+			{
+				// Generate new patchpoint
+				m_engine->updateGlobalMapping(name, reinterpret_cast<u64>(m_spurt->make_branch_patchpoint()));
+				continue;
+			}
+
+			reader_lock lock(s_spu_llvm_link_mutex);
+
+			const auto found = s_spu_llvm_link.find(name);
+
+			if (found == s_spu_llvm_link.end())
+			{
+				// Unknown in this session yet, need to compile
+				spu_log.notice("LLVM: Host symbol '%s' is not available for %s", name, path);
+				return nullptr;
+			}
+
+			m_engine->updateGlobalMapping(name, found->second);
+		}
+
+		if (!m_jit.add(path))
+		{
+			return nullptr;
+		}
+
+		m_jit.fin();
+		return reinterpret_cast<spu_function_t>(m_jit.get(m_hash));
+	}
+
+	// Save the list of external symbols of the persistent object
+	void save_object_symbols(const std::string& path)
+	{
+		std::string list;
+
+		for (const std::string& name : m_link_names)
+		{
+			list += name;
+			list += '\n';
+		}
+
+		const std::string tmp = fmt::format("%s.%x.tmp", path, std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+		fs::file file(tmp, fs::rewrite);
+
+		const bool ok = file && file.write(list.data(), list.size()) == list.size();
+
+		file.close();
+
+		if (!ok || !fs::rename(tmp, path + ".sym", true))
+		{
+			fs::remove_file(tmp);
+		}
+	}
+
 public:
 	spu_llvm_recompiler(u8 interp_magn = 0)
 		: spu_recompiler_base()
@@ -4166,6 +4956,19 @@ public:
 			// Metadata for branch weights
 			m_md_likely = llvm::MDTuple::get(m_context, {md_name, md_high, md_low});
 			m_md_unlikely = llvm::MDTuple::get(m_context, {md_name, md_low, md_high});
+
+			if (g_cfg.core.spu_cache && !g_cfg.core.spu_debug && !m_interp_magn)
+			{
+				// Everything affecting code generation
+				const std::string settings = fmt::format("%u|%s|%s|%s|%s|%s|%s", s_spu_llvm_version, jit_compiler::cpu(g_cfg.core.llvm_cpu),
+					g_cfg.core.spu_accurate_xfloat.to_string(), g_cfg.core.spu_approx_xfloat.to_string(),
+					g_cfg.core.spu_verification.to_string(), g_cfg.core.spu_prof.to_string(), g_cfg.core.spu_loop_detection.to_string());
+
+				m_obj_suffix = fmt::format("-%016llx.obj", XXH64(settings.data(), settings.size(), 0));
+
+				// Objects may be loaded before anything is compiled in this session
+				register_host_symbols();
+			}
 		}
 	}
 
@@ -4205,6 +5008,8 @@ public:
 			cache->add(func);
 		}
 
+		m_block_size = func.block_size;
+
 		{
 			sha1_context ctx;
 			u8 output[20];
@@ -4221,6 +5026,32 @@ public:
 			m_hash_start = hash_start;
 		}
 
+		m_engine->clearAllGlobalMappings();
+		m_link_names.clear();
+
+		// Persistent object location (in the shared program store)
+		std::string obj_name;
+
+		if (!m_obj_suffix.empty())
+		{
+			obj_name = fmt::format("%05x-%016llx-%u%s", func.entry_point, XXH64(func.data.data(), func.data.size() * 4, 0), static_cast<u32>(func.block_size), m_obj_suffix);
+
+			if (const spu_function_t fn = load_object(fs::get_cache_dir() + "cache/spu/" + obj_name))
+			{
+				spu_log.notice("Loaded function 0x%x (size %u, %s)", func.entry_point, func.data.size(), m_hash);
+
+				add_loc->compiled = fn;
+
+				if (!m_spurt->rebuild_ubertrampoline(func.data[0]))
+				{
+					return nullptr;
+				}
+
+				add_loc->compiled.notify_all();
+				return fn;
+			}
+		}
+
 		spu_log.notice("Building function 0x%x... (size %u, %s)", func.entry_point, func.data.size(), m_hash);
 
 		m_pos = func.lower_bound;
@@ -4239,10 +5070,8 @@ public:
 
 		using namespace llvm;
 
-		m_engine->clearAllGlobalMappings();
-
 		// Create LLVM module
-		std::unique_ptr<Module> module = std::make_unique<Module>(m_hash + ".obj", m_context);
+		std::unique_ptr<Module> module = std::make_unique<Module>(obj_name.empty() ? m_hash + ".obj" : obj_name, m_context);
 		module->setTargetTriple(Triple::normalize("x86_64-unknown-linux-gnu"));
 		module->setDataLayout(m_jit.get_engine().getTargetMachine()->createDataLayout());
 		m_module = module.get();
@@ -4395,7 +5224,7 @@ public:
 		entry_call->setCallingConv(entry_chunk->chunk->getCallingConv());
 
 		const auto dispatcher = llvm::cast<llvm::Function>(m_module->getOrInsertFunction("spu_dispatcher", main_func->getType()).getCallee());
-		m_engine->updateGlobalMapping("spu_dispatcher", reinterpret_cast<u64>(spu_runtime::tr_all));
+		link_host("spu_dispatcher", reinterpret_cast<u64>(spu_runtime::tr_all));
 		dispatcher->setCallingConv(main_func->getCallingConv());
 
 		// Proceed to the next code
@@ -4592,7 +5421,7 @@ public:
 				}
 
 				// State check at the beginning of the chunk
-				if (need_check || (bi == 0 && g_cfg.core.spu_block_size != spu_block_size_type::safe))
+				if (need_check || (bi == 0 && m_block_size != spu_block_size_type::safe))
 				{
 					check_state(baddr);
 				}
@@ -4673,6 +5502,7 @@ public:
 					{
 						const std::string ppname = fmt::format("%s-chunkpp-0x%05x", m_hash, i);
 						m_engine->updateGlobalMapping(ppname, reinterpret_cast<u64>(m_spurt->make_branch_patchpoint(i / 4)));
+						m_link_names.emplace(ppname);
 
 						const auto ppfunc = llvm::cast<llvm::Function>(m_module->getOrInsertFunction(ppname, m_finfo->chunk->getFunctionType()).getCallee());
 						ppfunc->setCallingConv(m_finfo->chunk->getCallingConv());
@@ -4774,6 +5604,12 @@ public:
 			// Testing only
 			m_jit.add(std::move(module), m_spurt->get_cache_path() + "llvm/");
 		}
+		else if (!obj_name.empty())
+		{
+			// Write persistent object
+			m_jit.add(std::move(module), fs::get_cache_dir() + "cache/spu/");
+			save_object_symbols(fs::get_cache_dir() + "cache/spu/" + obj_name);
+		}
 		else
 		{
 			m_jit.add(std::move(module));
@@ -5317,7 +6153,7 @@ public:
 		update_pc();
 		call("spu_syscall", &exec_stop, m_thread, m_ir->getInt32(op.opcode & 0x3fff));
 
-		if (g_cfg.core.spu_block_size == spu_block_size_type::safe)
+		if (m_block_size == spu_block_size_type::safe)
 		{
 			m_block->block_end = m_ir->GetInsertBlock();
 			update_pc(m_pos + 4);
@@ -5641,6 +6477,11 @@ public:
 		_spu->do_mfc();
 	}
 
+	static void exec_memcpy(u8* dst, const u8* src, u32 size)
+	{
+		std::memcpy(dst, src, size);
+	}
+
 	static void exec_mfc_cmd(spu_thread* _spu)
 	{
 		if (!_spu->process_mfc_cmd())
@@ -5927,11 +6768,7 @@ public:
 					else
 					{
 						// TODO
-						auto spu_memcpy = [](u8* dst, const u8* src, u32 size)
-						{
-							std::memcpy(dst, src, size);
-						};
-						call("spu_memcpy", +spu_memcpy, dst, src, zext<u32>(size).eval(m_ir));
+						call("spu_memcpy", &exec_memcpy, dst, src, zext<u32>(size).eval(m_ir));
 					}
 
 					m_ir->CreateBr(next);
@@ -6092,7 +6929,7 @@ public:
 		// This instruction must be used following a store instruction that modifies the instruction stream.
 		m_ir->CreateFence(llvm::AtomicOrdering::SequentiallyConsistent);
 
-		if (g_cfg.core.spu_block_size == spu_block_size_type::safe && !m_interp_magn)
+		if (m_block_size == spu_block_size_type::safe && !m_interp_magn)
 		{
 			m_block->block_end = m_ir->GetInsertBlock();
 			update_pc(m_pos + 4);
@@ -7899,7 +8736,7 @@ public:
 		// Load stack addr if necessary
 		value_t<u32> sp;
 
-		if (ret && g_cfg.core.spu_block_size != spu_block_size_type::safe)
+		if (ret && m_block_size != spu_block_size_type::safe)
 		{
 			if (op.opcode)
 			{
@@ -7928,7 +8765,7 @@ public:
 		m_ir->CreateStore(addr.value, spu_ptr<u32>(&spu_thread::pc));
 		const auto type = m_finfo->chunk->getFunctionType()->getPointerTo()->getPointerTo();
 
-		if (ret && g_cfg.core.spu_block_size >= spu_block_size_type::mega)
+		if (ret && m_block_size >= spu_block_size_type::mega)
 		{
 			// Compare address stored in stack mirror with addr
 			const auto stack0 = eval(zext<u64>(sp) + ::offset32(&spu_thread::stack_mirror));
@@ -7946,7 +8783,7 @@ public:
 			m_ir->SetInsertPoint(fail);
 		}
 
-		if (g_cfg.core.spu_block_size >= spu_block_size_type::mega)
+		if (m_block_size >= spu_block_size_type::mega)
 		{
 			// Try to load chunk address from the function table
 			const auto fail = llvm::BasicBlock::Create(m_context, "", m_function);
@@ -8300,7 +9137,7 @@ public:
 			return;
 		}
 
-		if (g_cfg.core.spu_block_size >= spu_block_size_type::mega && m_block_info[m_pos / 4 + 1] && m_entry_info[m_pos / 4 + 1])
+		if (m_block_size >= spu_block_size_type::mega && m_block_info[m_pos / 4 + 1] && m_entry_info[m_pos / 4 + 1])
 		{
 			// Store the return function chunk address at the stack mirror
 			const auto pfunc = add_function(m_pos + 4);
@@ -8336,21 +9173,28 @@ std::unique_ptr<spu_recompiler_base> spu_recompiler_base::make_llvm_recompiler(u
 
 #endif
 
+// SPU LLVM recompiler worker (background)
+struct spu_llvm_worker
+{
+	// Workload
+	lf_queue<spu_item*> registered;
+
+	// Number of items sent to this worker and not yet compiled
+	atomic_t<u32> pending = 0;
+
+	void operator()();
+
+	static constexpr auto thread_name = "SPU LLVM Worker"sv;
+};
+
 // SPU LLVM recompiler thread context
 struct spu_llvm
 {
-	// Workload
+	// Workload (nullptr item is sent by a worker which finished its work)
 	lf_queue<std::pair<const u64, spu_item*>> registered;
 
 	void operator()()
 	{
-		// SPU LLVM Recompiler instance
-		const auto compiler = spu_recompiler_base::make_llvm_recompiler();
-		compiler->init();
-
-		// Fake LS
-		std::vector<be_t<u32>> ls(0x10000);
-
 		// To compile (hash -> item)
 		std::unordered_multimap<u64, spu_item*, value_hash<u64>> enqueued;
 
@@ -8397,10 +9241,25 @@ struct spu_llvm
 			}
 		});
 
+		// Initialize worker pool (workers are joined before the profiler is destroyed)
+		const u32 max_threads = static_cast<u32>(g_cfg.core.llvm_threads);
+		const u32 thread_count = max_threads > 0 ? std::min(max_threads, std::thread::hardware_concurrency()) : std::thread::hardware_concurrency();
+		std::vector<std::unique_ptr<named_thread<spu_llvm_worker>>> workers(std::max<u32>(thread_count, 1));
+
+		for (auto& worker : workers)
+		{
+			worker = std::make_unique<named_thread<spu_llvm_worker>>();
+		}
+
 		while (thread_ctrl::state() != thread_state::aborting)
 		{
 			for (const auto& pair : registered.pop_all())
 			{
+				if (!pair.second)
+				{
+					continue;
+				}
+
 				enqueued.emplace(pair);
 
 				// Interrupt and kick profiler thread
@@ -8418,6 +9277,16 @@ struct spu_llvm
 				continue;
 			}
 
+			// Find idle worker
+			const auto worker = std::find_if(workers.begin(), workers.end(), [](const auto& w) { return w->pending == 0; });
+
+			if (worker == workers.end())
+			{
+				// Wait for new items or for a worker to finish
+				registered.wait();
+				continue;
+			}
+
 			// Find the most used enqueued item
 			u64 sample_max = 0;
 			auto found_it  = enqueued.begin();
@@ -8434,13 +9303,39 @@ struct spu_llvm
 			}
 
 			// Start compiling
-			const spu_program& func = found_it->second->data;
-
-			// Old function pointer (pre-recompiled)
-			const spu_function_t _old = found_it->second->compiled;
+			(*worker)->pending++;
+			(*worker)->registered.push(found_it->second);
 
 			// Remove item from the queue
 			enqueued.erase(found_it);
+		}
+	}
+
+	static constexpr auto thread_name = "SPU LLVM"sv;
+};
+
+using spu_llvm_thread = named_thread<spu_llvm>;
+
+void spu_llvm_worker::operator()()
+{
+	// Don't compete with emulation threads
+	thread_ctrl::set_native_priority(-1);
+
+	// SPU LLVM Recompiler instance
+	const auto compiler = spu_recompiler_base::make_llvm_recompiler();
+	compiler->init();
+
+	// Fake LS
+	std::vector<be_t<u32>> ls(0x10000);
+
+	while (thread_ctrl::state() != thread_state::aborting)
+	{
+		for (spu_item* item : registered.pop_all())
+		{
+			const spu_program& func = item->data;
+
+			// Old function pointer (pre-recompiled)
+			const spu_function_t _old = item->compiled;
 
 			// Get data start
 			const u32 start = func.lower_bound;
@@ -8452,8 +9347,8 @@ struct spu_llvm
 				ls[pos / 4] = std::bit_cast<be_t<u32>>(func.data[i]);
 			}
 
-			// Call analyser
-			spu_program func2 = compiler->analyse(ls.data(), func.entry_point);
+			// Call analyser (with the strategy selected by the first tier)
+			spu_program func2 = compiler->analyse(ls.data(), func.entry_point, func.block_size);
 
 			if (func2 != func)
 			{
@@ -8487,13 +9382,20 @@ struct spu_llvm
 
 			// Clear fake LS
 			std::memset(ls.data() + start / 4, 0, 4 * (size0 - 1));
+
+			// Notify the dispatcher
+			pending--;
+			g_fxo->get<spu_llvm_thread>()->registered.push(0, nullptr);
 		}
-	}
 
-	static constexpr auto thread_name = "SPU LLVM"sv;
-};
+		registered.wait();
+	}
+}
 
-using spu_llvm_thread = named_thread<spu_llvm>;
+void spu_recompiler_base::enqueue_llvm(u64 hash, spu_item* item)
+{
+	g_fxo->get<spu_llvm_thread>()->registered.push(hash, item);
+}
 
 struct spu_fast : public spu_recompiler_base
 {
@@ -8828,8 +9730,8 @@ struct spu_fast : public spu_recompiler_base
 
 		if (added)
 		{
-			// Send work to LLVM compiler thread
-			g_fxo->get<spu_llvm_thread>()->registered.push(m_hash_start, add_loc);
+			// Send work to LLVM compiler threads
+			enqueue_llvm(m_hash_start, add_loc);
 		}
 
 		// Rebuild trampoline if necessary
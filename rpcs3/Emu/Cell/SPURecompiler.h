@@ -9,12 +9,24 @@
 #include <memory>
 #include <string>
 #include <deque>
+#include <unordered_map>
+
+enum class spu_block_size_type;
 
 // Helper class
 class spu_cache
 {
 	fs::file m_file;
 
+	// Block size strategy records (sidecar file)
+	fs::file m_prof;
+
+	// File contents (read at once by index())
+	std::vector<u8> m_data;
+
+	// Offsets of the records in m_data
+	std::vector<u64> m_index;
+
 public:
 	spu_cache(const std::string& loc);
 
@@ -29,10 +41,27 @@ public:
 		return m_file.operator bool();
 	}
 
-	std::deque<struct spu_program> get();
+	// Read the file and build the record index, returns number of records
+	std::size_t index();
 
+	// Decode indexed record (thread-safe), returns empty program on checksum mismatch
+	struct spu_program get(std::size_t index) const;
+
+	// Truncate the file after given number of records, release the index
+	void trim(std::size_t count);
+
+	// Import programs from v1 cache file and remove it
+	void migrate(const std::string& old_loc);
+
+	// Add program to the shared store and reference it (or store it in place if that fails)
 	void add(const struct spu_program& func);
 
+	// Open block size strategy file and apply its records to the runtime
+	void load_profile(const std::string& loc, class spu_runtime& rt);
+
+	// Append block size strategy record
+	void add_profile(u32 entry, u32 inst, spu_block_size_type type);
+
 	static void initialize();
 };
 
@@ -47,6 +76,9 @@ struct spu_program
 	// Program data with intentionally wrong endianness (on LE platform opcode values are swapped)
 	std::vector<u32> data;
 
+	// Block size strategy used by the analyser
+	spu_block_size_type block_size{};
+
 	bool operator==(const spu_program& rhs) const noexcept;
 
 	bool operator!=(const spu_program& rhs) const noexcept
@@ -69,6 +101,12 @@ public:
 	// Ubertrampoline generated for this item when it was latest
 	atomic_t<spu_function_t> trampoline = nullptr;
 
+	// Number of guard stubs chained before the last full ubertrampoline
+	atomic_t<u32> depth = 0;
+
+	// Number of functions covered by the ubertrampoline
+	atomic_t<u32> covered = 0;
+
 	atomic_t<u8> cached = false;
 	atomic_t<u8> logged = false;
 
@@ -85,12 +123,19 @@ public:
 // Helper class
 class spu_runtime
 {
-	// All functions (2^20 bunches)
-	std::array<lf_bunch<spu_item>, (1 << 20)> m_stuff;
+	using bunch_page = std::array<lf_bunch<spu_item>, 1024>;
+
+	// All functions (2^20 bunches in 2^10 pages allocated on demand)
+	std::array<atomic_t<bunch_page*>, 1024> m_stuff{};
 
 	// Debug module output location
 	std::string m_cache_path;
 
+	mutable shared_mutex m_prof_mutex;
+
+	// Block size strategy per program entry (entry point << 32 | first instruction)
+	std::unordered_map<u64, spu_block_size_type> m_prof;
+
 public:
 	// Trampoline to spu_recompiler_base::dispatch
 	static const spu_function_t tr_dispatch;
@@ -109,6 +154,8 @@ public:
 
 	spu_runtime(const spu_runtime&) = delete;
 
+	~spu_runtime();
+
 	spu_runtime& operator=(const spu_runtime&) = delete;
 
 	const std::string& get_cache_path() const
@@ -122,6 +169,15 @@ public:
 private:
 	friend class spu_cache;
 
+	// Get bunch for the first instruction (allocated if necessary)
+	lf_bunch<spu_item>& get_bunch(u32 id_inst);
+
+	// Get bunch for the first instruction (nullptr if it's never been allocated)
+	const lf_bunch<spu_item>* find_bunch(u32 id_inst) const;
+
+	// Generate a stub which selects new function or jumps to the previous ubertrampoline
+	spu_function_t make_guard_stub(const spu_item& top, const lf_bunch<spu_item>& bunch, spu_function_t prev) const;
+
 public:
 	// Return new pointer for add()
 	spu_item* add_empty(spu_program&&);
@@ -129,11 +185,31 @@ public:
 	// Find existing function
 	spu_function_t find(const u32* ls, u32 addr) const;
 
+	// Get block size strategy for the program entry (configured one if not profiled)
+	spu_block_size_type get_block_size(u32 entry, u32 inst) const;
+
+	// Set block size strategy for the program entry, returns false if it's not lower than current
+	bool set_block_size(u32 entry, u32 inst, spu_block_size_type type);
+
+	// Count different variants of the program entry, lower its strategy if there are too many
+	void add_miss(const spu_program& data);
+
 	// Generate a patchable trampoline to spu_recompiler_base::branch
 	spu_function_t make_branch_patchpoint(u16 data = 0) const;
 
-	// All dispatchers (array allocated in jit memory)
-	static std::array<atomic_t<spu_function_t>, (1 << 20)>* const g_dispatcher;
+	using dispatcher_page = std::array<atomic_t<spu_function_t>, 1024>;
+
+	// All dispatchers (2^10 pages in jit memory, unused ranges share the default page)
+	static std::array<atomic_t<dispatcher_page*>, 1024>* const g_dispatcher;
+
+	// Default dispatcher page (must not be modified after the runtime is initialized)
+	static dispatcher_page* const g_dispatcher_default;
+
+	// Get dispatcher for the first instruction
+	static spu_function_t get_dispatcher(u32 id_inst)
+	{
+		return (*(*g_dispatcher)[id_inst >> 22].load())[(id_inst >> 12) % 1024].load();
+	}
 
 	// Recompiler entry point
 	static const spu_function_t g_gateway;
@@ -189,6 +265,9 @@ protected:
 	u32 m_size;
 	u64 m_hash_start;
 
+	// Block size strategy of the current program
+	spu_block_size_type m_block_size{};
+
 	// Bit indicating start of the block
 	std::bitset<0x10000> m_block_info;
 
@@ -318,7 +397,13 @@ public:
 	// Legacy interpreter loop
 	static void old_interpreter(spu_thread&, void* ls, u8*);
 
-	// Get the function data at specified address
+	// Send function built by the first tier to background LLVM compilation (first 8 bytes must be patchable)
+	static void enqueue_llvm(u64 hash, spu_item* item);
+
+	// Get the function data at specified address (using given block size strategy)
+	spu_program analyse(const be_t<u32>* ls, u32 lsa, spu_block_size_type type);
+
+	// Get the function data at specified address (using the strategy selected by the runtime)
 	spu_program analyse(const be_t<u32>* ls, u32 lsa);
 
 	// Print analyser internal state
@@ -68,6 +68,52 @@ static FORCE_INLINE void mov_rdata(decltype(spu_thread::rdata)& dst, const declt
 	}
 }
 
+// Replace data if it's equal to the old data (using 16-byte CAS, not atomic for plain loads and stores)
+static bool cas_rdata(decltype(spu_thread::rdata)& dst, const decltype(spu_thread::rdata)& old, const decltype(spu_thread::rdata)& _new)
+{
+	for (u32 i = 0; i < 8; i++)
+	{
+		if (!reinterpret_cast<atomic_t<v128>&>(dst[i]).compare_and_swap_test(old[i], _new[i]))
+		{
+			// Roll back (fails only for parts overwritten by plain stores meanwhile)
+			while (i--)
+			{
+				reinterpret_cast<atomic_t<v128>&>(dst[i]).compare_and_swap_test(_new[i], old[i]);
+			}
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Optimistic seqlock read of the reservation data, returns 1 if the line is busy
+static u64 spu_getll_seqlock(u32 addr, decltype(spu_thread::rdata)& dst)
+{
+	const auto& res = vm::reservation_acquire(addr, 128);
+	const auto& data = vm::_ref<decltype(spu_thread::rdata)>(addr);
+
+	for (u32 i = 0; i < 16; i++)
+	{
+		const u64 time0 = res;
+
+		if ((time0 & 127) == 0) [[likely]]
+		{
+			mov_rdata(dst, data);
+
+			if (res == time0) [[likely]]
+			{
+				return time0;
+			}
+		}
+
+		_mm_pause();
+	}
+
+	return 1;
+}
+
 extern u64 get_timebased_time();
 extern u64 get_system_time();
 
@@ -1224,7 +1270,7 @@ spu_thread::spu_thread(vm::addr_t ls, lv2_spu_group* group, u32 index, std::stri
 
 	if (g_cfg.core.spu_decoder == spu_decoder_type::llvm)
 	{
-		jit = spu_recompiler_base::make_fast_llvm_recompiler();
+		jit = g_cfg.core.spu_asmjit_tier ? spu_recompiler_base::make_asmjit_recompiler() : spu_recompiler_base::make_fast_llvm_recompiler();
 	}
 
 	if (g_cfg.core.spu_decoder != spu_decoder_type::fast && g_cfg.core.spu_decoder != spu_decoder_type::precise)
@@ -1610,6 +1656,8 @@ void spu_thread::do_putlluc(const spu_mfc_cmd& args)
 {
 	const u32 addr = args.eal & -128;
 
+	vm::reservation_prof_op(addr, true);
+
 	if (raddr && addr == raddr)
 	{
 		// Last check for event before we clear the reservation
@@ -1806,6 +1854,8 @@ bool spu_thread::process_mfc_cmd()
 		auto& dst = _ref<decltype(rdata)>(ch_mfc_cmd.lsa & 0x3ff80);
 		u64 ntime;
 
+		vm::reservation_prof_op(addr, true);
+
 		const bool is_polling = false; // TODO
 
 		if (is_polling)
@@ -1859,8 +1909,14 @@ bool spu_thread::process_mfc_cmd()
 				}
 			}
 		}
+		else if (!g_cfg.core.spu_accurate_getllar && (ntime = spu_getll_seqlock(addr, dst)) != 1) [[likely]]
+		{
+			vm::g_tls_reservation_stats.fast_load++;
+		}
 		else
 		{
+			vm::g_tls_reservation_stats.slow_load++;
+
 			auto& res = vm::reservation_lock(addr, 128);
 			const u64 old_time = res.load() & -128;
 
@@ -1959,8 +2015,30 @@ bool spu_thread::process_mfc_cmd()
 					// Writeback of unchanged data. Only check memory change
 					result = cmp_rdata(rdata, data) && vm::reservation_acquire(raddr, 128).compare_and_swap_test(rtime, rtime + 128);
 				}
+				else if (g_cfg.core.spu_relaxed_putllc && vm::reservation_acquire(raddr, 128).compare_and_swap_test(rtime, rtime | 1))
+				{
+					// Line is locked for other atomics, plain stores are detected by CAS
+					// Plain loads may observe a partially written (or rolled back) line, and a failed store may leave parts written by plain stores in between
+					auto& res = vm::reservation_acquire(raddr, 128);
+
+					*reinterpret_cast<atomic_t<u32>*>(&data) += 0;
+
+					if (cas_rdata(*vm::get_super_ptr<decltype(rdata)>(addr), rdata, to_write))
+					{
+						res += 127;
+						result = 1;
+						vm::g_tls_reservation_stats.fast_store++;
+					}
+					else
+					{
+						res -= 1;
+						vm::g_tls_reservation_stats.store_fail++;
+					}
+				}
 				else
 				{
+					vm::g_tls_reservation_stats.slow_store++;
+
 					auto& res = vm::reservation_lock(raddr, 128);
 					const u64 old_time = res.load() & -128;
 
@@ -1993,6 +2071,8 @@ bool spu_thread::process_mfc_cmd()
 			}
 		}
 
+		vm::reservation_prof_op(addr, result != 0);
+
 		if (result)
 		{
 			vm::reservation_notifier(addr, 128).notify_all();
@@ -1000,14 +1000,124 @@ extern ppu_function_t ppu_get_syscall(u64 code)
 }
 
 extern u64 get_guest_system_time();
+extern u64 get_system_time();
 
 DECLARE(lv2_obj::g_mutex);
 DECLARE(lv2_obj::g_ppu);
+DECLARE(lv2_obj::g_active);
 DECLARE(lv2_obj::g_pending);
 DECLARE(lv2_obj::g_waiting);
+DECLARE(lv2_obj::g_sched_stats){};
 
 thread_local DECLARE(lv2_obj::g_to_awake);
 
+u32 lv2_ppu_queue::find_bucket(u32 index) const
+{
+	if (index >= prio_count)
+	{
+		return prio_count;
+	}
+
+	const u32 word = index / 64;
+
+	// Check the rest of the current word
+	if (const u64 bits = m_mask[word] & (~0ull << (index % 64)))
+	{
+		return word * 64 + utils::cnttz64(bits, false);
+	}
+
+	// Find next non-empty word
+	if (const u64 words = word + 1 < 64 ? m_summary & (~0ull << (word + 1)) : 0)
+	{
+		const u32 next = utils::cnttz64(words, false);
+		return next * 64 + utils::cnttz64(m_mask[next], false);
+	}
+
+	return prio_count;
+}
+
+bool lv2_ppu_queue::push(ppu_thread* thread)
+{
+	if (thread->sched_queued)
+	{
+		return false;
+	}
+
+	const u32 index = std::clamp<s32>(thread->prio, min_prio, min_prio + prio_count - 1) - min_prio;
+	auto& list = m_buckets[index];
+
+	thread->sched_prio = index;
+	thread->sched_prev = list.last;
+	thread->sched_next = nullptr;
+	thread->sched_queued = true;
+
+	if (list.last)
+	{
+		list.last->sched_next = thread;
+	}
+	else
+	{
+		list.first = thread;
+		m_mask[index / 64] |= 1ull << (index % 64);
+		m_summary |= 1ull << (index / 64);
+	}
+
+	list.last = thread;
+	m_size++;
+	return true;
+}
+
+bool lv2_ppu_queue::remove(ppu_thread* thread)
+{
+	if (!thread->sched_queued)
+	{
+		return false;
+	}
+
+	const u32 index = thread->sched_prio;
+	auto& list = m_buckets[index];
+
+	(thread->sched_prev ? thread->sched_prev->sched_next : list.first) = thread->sched_next;
+	(thread->sched_next ? thread->sched_next->sched_prev : list.last) = thread->sched_prev;
+
+	if (!list.first && !(m_mask[index / 64] &= ~(1ull << (index % 64))))
+	{
+		m_summary &= ~(1ull << (index / 64));
+	}
+
+	thread->sched_prev = nullptr;
+	thread->sched_next = nullptr;
+	thread->sched_queued = false;
+	m_size--;
+	return true;
+}
+
+ppu_thread* lv2_ppu_queue::front() const
+{
+	const u32 index = find_bucket(0);
+	return index < prio_count ? m_buckets[index].first : nullptr;
+}
+
+ppu_thread* lv2_ppu_queue::next(ppu_thread* thread) const
+{
+	if (thread->sched_next)
+	{
+		return thread->sched_next;
+	}
+
+	const u32 index = find_bucket(thread->sched_prio + 1);
+	return index < prio_count ? m_buckets[index].first : nullptr;
+}
+
+void lv2_ppu_queue::clear()
+{
+	// Threads are not accessed (they are about to be destroyed)
+	m_buckets = {};
+	m_mask = {};
+	m_summary = 0;
+	m_size = 0;
+}
+
 void lv2_obj::sleep_unlocked(cpu_thread& thread, u64 timeout)
 {
 	const u64 start_time = get_guest_system_time();
@@ -1034,10 +1144,12 @@ void lv2_obj::sleep_unlocked(cpu_thread& thread, u64 timeout)
 		}
 
 		// Find and remove the thread
-		unqueue(g_ppu, ppu);
+		g_ppu.remove(ppu);
+		unqueue(g_active, ppu);
 		unqueue(g_pending, ppu);
 
 		ppu->start_time = start_time;
+		g_sched_stats.sleep_count++;
 	}
 
 	if (timeout)
@@ -1076,35 +1188,39 @@ void lv2_obj::awake_unlocked(cpu_thread* cpu, s32 prio)
 	default:
 	{
 		// Priority set
-		if (static_cast<ppu_thread*>(cpu)->prio.exchange(prio) == prio || !unqueue(g_ppu, cpu))
+		if (static_cast<ppu_thread*>(cpu)->prio.exchange(prio) == prio || !g_ppu.remove(static_cast<ppu_thread*>(cpu)))
 		{
 			return;
 		}
 
+		unqueue(g_active, cpu);
 		break;
 	}
 	case yield_cmd:
 	{
 		// Yield command
 		const u64 start_time = get_guest_system_time();
+		const auto ppu = static_cast<ppu_thread*>(cpu);
 
-		for (std::size_t i = 0, pos = -1; i < g_ppu.size(); i++)
+		if (ppu->sched_queued)
 		{
-			if (g_ppu[i] == cpu)
-			{
-				pos = i;
-				prio = g_ppu[i]->prio;
-			}
-			else if (i == pos + 1 && prio != -4 && g_ppu[i]->prio != prio)
+			// Nothing to do if the thread is the last one of its priority and not the last one in the queue
+			if (!ppu->sched_next && ppu->prio != -4 && g_ppu.next(ppu))
 			{
 				return;
 			}
 		}
+		else if (!g_ppu.empty())
+		{
+			return;
+		}
 
-		unqueue(g_ppu, cpu);
+		g_ppu.remove(ppu);
+		unqueue(g_active, ppu);
 		unqueue(g_pending, cpu);
 
-		static_cast<ppu_thread*>(cpu)->start_time = start_time;
+		ppu->start_time = start_time;
+		g_sched_stats.yield_count++;
 	}
 	case enqueue_cmd:
 	{
@@ -1114,22 +1230,26 @@ void lv2_obj::awake_unlocked(cpu_thread* cpu, s32 prio)
 
 	const auto emplace_thread = [](cpu_thread* const cpu)
 	{
-		for (auto it = g_ppu.cbegin(), end = g_ppu.cend();; it++)
+		const auto ppu = static_cast<ppu_thread*>(cpu);
+
+		// Use priority, also preserve FIFO order
+		if (!g_ppu.push(ppu))
 		{
-			if (it != end && *it == cpu)
-			{
-				ppu_log.trace("sleep() - suspended (p=%zu)", g_pending.size());
-				return;
-			}
+			ppu_log.trace("sleep() - suspended (p=%zu)", g_pending.size());
+			return;
+		}
 
-			// Use priority, also preserve FIFO order
-			if (it == end || (*it)->prio > static_cast<ppu_thread*>(cpu)->prio)
-			{
-				g_ppu.insert(it, static_cast<ppu_thread*>(cpu));
-				break;
-			}
+		// May be running (checked below)
+		g_active.emplace_back(ppu);
+
+		if (ppu->state & cpu_flag::suspend)
+		{
+			ppu->sched_ready_time = get_system_time();
 		}
 
+		g_sched_stats.awake_count++;
+		g_sched_stats.max_queue = std::max<u64>(g_sched_stats.max_queue, g_ppu.size());
+
 		// Unregister timeout if necessary
 		for (auto it = g_waiting.cbegin(), end = g_waiting.cend(); it != end; it++)
 		{
@@ -1160,16 +1280,39 @@ void lv2_obj::awake_unlocked(cpu_thread* cpu, s32 prio)
 		unqueue(g_pending, cpu);
 	}
 
-	// Suspend threads if necessary
-	for (std::size_t i = g_cfg.core.ppu_threads; i < g_ppu.size(); i++)
+	// Threads allowed to run
+	std::array<ppu_thread*, 8> running{};
+	const std::size_t count = std::min<std::size_t>(g_cfg.core.ppu_threads, running.size());
+
+	for (std::size_t i = 0; i < count; i++)
 	{
-		const auto target = g_ppu[i];
+		running[i] = i ? g_ppu.next(running[i - 1]) : g_ppu.front();
+
+		if (!running[i])
+		{
+			break;
+		}
+	}
+
+	// Suspend threads if necessary (only the threads which may be running are checked)
+	for (auto it = g_active.begin(); it != g_active.end();)
+	{
+		const auto target = *it;
+
+		if (std::find(running.begin(), running.begin() + count, target) != running.begin() + count)
+		{
+			it++;
+			continue;
+		}
 
 		if (!target->state.test_and_set(cpu_flag::suspend))
 		{
 			ppu_log.trace("suspend(): %s", target->id);
 			g_pending.emplace_back(target);
+			g_sched_stats.suspend_count++;
 		}
+
+		it = g_active.erase(it);
 	}
 
 	schedule_all();
@@ -1177,9 +1320,18 @@ void lv2_obj::awake_unlocked(cpu_thread* cpu, s32 prio)
 
 void lv2_obj::cleanup()
 {
+	if (const auto& stats = g_sched_stats; stats.awake_count)
+	{
+		ppu_log.notice("Scheduler: awake=%llu, sleep=%llu, yield=%llu, suspend=%llu, max queue=%llu, wake latency: avg=%lluus, max=%lluus",
+			stats.awake_count, stats.sleep_count, stats.yield_count, stats.suspend_count, stats.max_queue,
+			stats.wake_count ? stats.wake_latency / stats.wake_count : 0, stats.max_wake_latency);
+	}
+
 	g_ppu.clear();
+	g_active.clear();
 	g_pending.clear();
 	g_waiting.clear();
+	g_sched_stats = {};
 }
 
 void lv2_obj::schedule_all()
@@ -1187,16 +1339,30 @@ void lv2_obj::schedule_all()
 	if (g_pending.empty())
 	{
 		// Wake up threads
-		for (std::size_t i = 0, x = std::min<std::size_t>(g_cfg.core.ppu_threads, g_ppu.size()); i < x; i++)
-		{
-			const auto target = g_ppu[i];
+		auto target = g_ppu.front();
 
+		for (std::size_t i = 0, x = g_cfg.core.ppu_threads; target && i < x; i++, target = g_ppu.next(target))
+		{
 			if (target->state & cpu_flag::suspend)
 			{
 				ppu_log.trace("schedule(): %s", target->id);
 				target->state ^= (cpu_flag::signal + cpu_flag::suspend);
 				target->start_time = 0;
 
+				if (std::find(g_active.begin(), g_active.end(), target) == g_active.end())
+				{
+					g_active.emplace_back(target);
+				}
+
+				if (target->sched_ready_time)
+				{
+					const u64 latency = get_system_time() - target->sched_ready_time;
+					target->sched_ready_time = 0;
+					g_sched_stats.wake_count++;
+					g_sched_stats.wake_latency += latency;
+					g_sched_stats.max_wake_latency = std::max(g_sched_stats.max_wake_latency, latency);
+				}
+
 				if (target != get_current_cpu_thread())
 				{
 					target->notify();
@@ -3,6 +3,7 @@
 
 #include "Emu/Cell/ErrorCodes.h"
 #include "Emu/Cell/Modules/sys_lv2dbg.h"
+#include "Emu/RSX/rsx_vertex_cache.h"
 
 LOG_CHANNEL(sys_dbg);
 
@@ -65,5 +66,7 @@ error_code sys_dbg_write_process_memory(s32 pid, u32 address, u32 size, vm::cptr
 
 	std::memcpy(vm::get_super_ptr(address), data.get_ptr(), size);
 
+	rsx::vertex_cache::g_page_tracker.on_sudo_write(utils::address_range::start_length(address, size));
+
 	return CELL_OK;
 }
@@ -10,15 +10,6 @@
 
 LOG_CHANNEL(sys_fs);
 
-struct lv2_fs_mount_point
-{
-	const u64 sector_size = 512;
-	const u64 block_size = 4096;
-	const bs_t<lv2_mp_flag> flags{};
-
-	shared_mutex mutex;
-};
-
 lv2_fs_mount_point g_mp_sys_dev_hdd0;
 lv2_fs_mount_point g_mp_sys_dev_hdd1{512, 32768, lv2_mp_flag::no_uid_gid};
 lv2_fs_mount_point g_mp_sys_dev_usb{512, 4096, lv2_mp_flag::no_uid_gid};
@@ -86,7 +77,7 @@ lv2_fs_mount_point* lv2_fs_object::get_mp(std::string_view filename)
 	return &g_mp_sys_dev_hdd0;
 }
 
-std::pair<u64, CellError> lv2_file::op_read(vm::ptr<void> buf, u64 size)
+std::pair<u64, CellError> lv2_file::op_read(vm::ptr<void> buf, u64 size, u64 opt_pos)
 {
 	// Copy data from intermediate buffer (avoid passing vm pointer to a native API)
 	uchar local_buf[65536];
@@ -97,7 +88,7 @@ std::pair<u64, CellError> lv2_file::op_read(vm::ptr<void> buf, u64 size)
 	{
 		// TODO: Changes with cellFsSetIoBuffer
 		const u64 block = std::min<u64>(size - result, sizeof(local_buf));
-		const u64 nread = file.read(+local_buf, block);
+		const u64 nread = opt_pos != -1 ? file.read_at(opt_pos + result, +local_buf, block) : file.read(+local_buf, block);
 
 		if (!vm::try_access(static_cast<u32>(buf.addr() + result), local_buf, nread, true))
 		{
@@ -105,7 +96,10 @@ std::pair<u64, CellError> lv2_file::op_read(vm::ptr<void> buf, u64 size)
 				buf, result, size, block);
 
 			// Fix position and abort
-			file.seek(-::narrow<s64>(nread), fs::seek_cur);
+			if (opt_pos == -1)
+			{
+				file.seek(-::narrow<s64>(nread), fs::seek_cur);
+			}
 
 			if (result == 0)
 			{
@@ -197,10 +191,9 @@ struct lv2_file::file_view : fs::file_base
 
 	u64 read(void* buffer, u64 size) override
 	{
-		const u64 old_pos = m_file->file.pos();
-		const u64 new_pos = m_file->file.seek(m_off + m_pos);
-		const u64 result = m_file->file.read(buffer, size);
-		verify(HERE), old_pos == m_file->file.seek(old_pos);
+		std::lock_guard lock(m_file->mutex);
+
+		const u64 result = m_file->file.read_at(m_off + m_pos, buffer, size);
 
 		m_pos += result;
 		return result;
@@ -532,7 +525,8 @@ error_code sys_fs_read(ppu_thread& ppu, u32 fd, vm::ptr<void> buf, u64 nbytes, v
 		return CELL_EBADF;
 	}
 
-	std::lock_guard lock(file->mp->mutex);
+	reader_lock mp_lock(file->mp->mutex);
+	std::lock_guard lock(file->mutex);
 
 	if (file->lock == 2)
 	{
@@ -583,7 +577,8 @@ error_code sys_fs_write(ppu_thread& ppu, u32 fd, vm::cptr<void> buf, u64 nbytes,
 		return CELL_EROFS;
 	}
 
-	std::lock_guard lock(file->mp->mutex);
+	reader_lock mp_lock(file->mp->mutex);
+	std::lock_guard lock(file->mutex);
 
 	if (file->lock)
 	{
@@ -898,7 +893,8 @@ error_code sys_fs_fstat(ppu_thread& ppu, u32 fd, vm::ptr<CellFsStat> sb)
 		return CELL_EBADF;
 	}
 
-	std::lock_guard lock(file->mp->mutex);
+	reader_lock mp_lock(file->mp->mutex);
+	std::lock_guard lock(file->mutex);
 
 	if (file->lock == 2)
 	{
@@ -1210,7 +1206,8 @@ error_code sys_fs_fcntl(ppu_thread& ppu, u32 fd, u32 op, vm::ptr<void> _arg, u32
 			return CELL_EROFS;
 		}
 
-		std::lock_guard lock(file->mp->mutex);
+		reader_lock mp_lock(file->mp->mutex);
+		std::lock_guard lock(file->mutex);
 
 		if (file->lock == 2)
 		{
@@ -1222,14 +1219,21 @@ error_code sys_fs_fcntl(ppu_thread& ppu, u32 fd, u32 op, vm::ptr<void> _arg, u32
 			return CELL_EBUSY;
 		}
 
-		const u64 old_pos = file->file.pos();
-		const u64 new_pos = file->file.seek(arg->offset);
+		std::pair<u64, CellError> out;
 
-		const auto [out_size, out_code] = op == 0x8000000a
-			? file->op_read(arg->buf, arg->size)
-			: file->op_write(arg->buf, arg->size);
+		if (op == 0x8000000a)
+		{
+			out = file->op_read(arg->buf, arg->size, arg->offset);
+		}
+		else
+		{
+			const u64 old_pos = file->file.pos();
+			file->file.seek(arg->offset);
+			out = file->op_write(arg->buf, arg->size);
+			verify(HERE), old_pos == file->file.seek(old_pos);
+		}
 
-		verify(HERE), old_pos == file->file.seek(old_pos);
+		const auto [out_size, out_code] = out;
 
 		if (!out_code)
 		{
@@ -1594,7 +1598,8 @@ error_code sys_fs_lseek(ppu_thread& ppu, u32 fd, s64 offset, s32 whence, vm::ptr
 		return {CELL_EINVAL, whence};
 	}
 
-	std::lock_guard lock(file->mp->mutex);
+	reader_lock mp_lock(file->mp->mutex);
+	std::lock_guard lock(file->mutex);
 
 	const u64 result = file->file.seek(offset, static_cast<fs::seek_mode>(whence));
 
@@ -1626,7 +1631,8 @@ error_code sys_fs_fdatasync(ppu_thread& ppu, u32 fd)
 		return CELL_EBADF;
 	}
 
-	std::lock_guard lock(file->mp->mutex);
+	reader_lock mp_lock(file->mp->mutex);
+	std::lock_guard lock(file->mutex);
 	file->file.sync();
 	return CELL_OK;
 }
@@ -1644,7 +1650,8 @@ error_code sys_fs_fsync(ppu_thread& ppu, u32 fd)
 		return CELL_EBADF;
 	}
 
-	std::lock_guard lock(file->mp->mutex);
+	reader_lock mp_lock(file->mp->mutex);
+	std::lock_guard lock(file->mutex);
 	file->file.sync();
 	return CELL_OK;
 }
@@ -1781,7 +1788,8 @@ error_code sys_fs_ftruncate(ppu_thread& ppu, u32 fd, u64 size)
 		return CELL_EROFS;
 	}
 
-	std::lock_guard lock(file->mp->mutex);
+	reader_lock mp_lock(file->mp->mutex);
+	std::lock_guard lock(file->mutex);
 
 	if (file->lock == 2)
 	{
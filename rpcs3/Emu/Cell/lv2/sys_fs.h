@@ -3,6 +3,7 @@
 #include "Emu/Memory/vm_ptr.h"
 #include "Emu/Cell/ErrorCodes.h"
 #include "Utilities/File.h"
+#include "Utilities/mutex.h"
 
 // Open Flags
 enum : s32
@@ -119,8 +120,6 @@ struct FsMselfEntry
 	u8 m_reserve[16];
 };
 
-struct lv2_fs_mount_point;
-
 enum class lv2_mp_flag
 {
 	read_only,
@@ -130,6 +129,16 @@ enum class lv2_mp_flag
 	__bitset_enum_max
 };
 
+struct lv2_fs_mount_point
+{
+	const u64 sector_size = 512;
+	const u64 block_size = 4096;
+	const bs_t<lv2_mp_flag> flags{};
+
+	// Exclusive for path operations, shared for file descriptor operations
+	shared_mutex mutex;
+};
+
 struct lv2_fs_object
 {
 	using id_type = lv2_fs_object;
@@ -176,6 +185,9 @@ struct lv2_file final : lv2_fs_object
 	// Stream lock
 	atomic_t<u32> lock{0};
 
+	// File data and position lock (taken after the mount point lock in shared mode)
+	shared_mutex mutex;
+
 	lv2_file(std::string_view filename, fs::file&& file, s32 mode, s32 flags)
 		: lv2_fs_object(lv2_fs_object::get_mp(filename), filename)
 		, file(std::move(file))
@@ -192,8 +204,8 @@ struct lv2_file final : lv2_fs_object
 	{
 	}
 
-	// File reading with intermediate buffer
-	std::pair<u64, CellError> op_read(vm::ptr<void> buf, u64 size);
+	// File reading with intermediate buffer (at the current position if opt_pos is -1)
+	std::pair<u64, CellError> op_read(vm::ptr<void> buf, u64 size, u64 opt_pos = -1);
 
 	// File writing with intermediate buffer
 	std::pair<u64, CellError> op_write(vm::cptr<void> buf, u64 size);
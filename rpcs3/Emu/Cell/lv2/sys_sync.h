@@ -11,6 +11,7 @@
 #include "Emu/IPC.h"
 #include "Emu/System.h"
 
+#include <array>
 #include <deque>
 #include <thread>
 
@@ -57,6 +58,62 @@ enum
 	SYS_SYNC_ATTR_ADAPTIVE_MASK  = 0xf000,
 };
 
+// PPU scheduler queue: FIFO list for every priority and bitmap of non-empty priorities
+class lv2_ppu_queue
+{
+public:
+	// Priority range (see lv2_obj::set_priority)
+	static constexpr s32 min_prio = -512;
+	static constexpr u32 prio_count = 3712;
+
+private:
+	struct bucket
+	{
+		class ppu_thread* first;
+		class ppu_thread* last;
+	};
+
+	std::array<bucket, prio_count> m_buckets{};
+
+	// Non-empty buckets
+	std::array<u64, (prio_count + 63) / 64> m_mask{};
+
+	// Non-zero m_mask words
+	u64 m_summary = 0;
+
+	std::size_t m_size = 0;
+
+	static_assert((prio_count + 63) / 64 <= 64);
+
+	// Find first non-empty bucket starting from index (prio_count if none)
+	u32 find_bucket(u32 index) const;
+
+public:
+	// Append thread to its priority list (false if already queued)
+	bool push(class ppu_thread* thread);
+
+	// Remove thread (false if not queued)
+	bool remove(class ppu_thread* thread);
+
+	// Get the first thread in scheduling order (or nullptr)
+	class ppu_thread* front() const;
+
+	// Get the next thread in scheduling order (or nullptr)
+	class ppu_thread* next(class ppu_thread* thread) const;
+
+	std::size_t size() const
+	{
+		return m_size;
+	}
+
+	bool empty() const
+	{
+		return m_size == 0;
+	}
+
+	void clear();
+};
+
 // Base class for some kernel objects (shared set of 8192 objects).
 struct lv2_obj
 {
@@ -324,11 +381,27 @@ private:
 	static thread_local std::vector<class cpu_thread*> g_to_awake;
 
 	// Scheduler queue for active PPU threads
-	static std::deque<class ppu_thread*> g_ppu;
+	static lv2_ppu_queue g_ppu;
+
+	// Queued PPU threads which may be running (must be checked when the running set changes)
+	static std::deque<class ppu_thread*> g_active;
 
 	// Waiting for the response from
 	static std::deque<class cpu_thread*> g_pending;
 
+	// Scheduler statistics (reported at cleanup)
+	static struct sched_stats_t
+	{
+		u64 awake_count;
+		u64 sleep_count;
+		u64 yield_count;
+		u64 suspend_count;
+		u64 max_queue;
+		u64 wake_count;
+		u64 wake_latency;
+		u64 max_wake_latency;
+	} g_sched_stats;
+
 	// Scheduler queue for timeouts (wait until -> thread)
 	static std::deque<std::pair<u64, class cpu_thread*>> g_waiting;
 
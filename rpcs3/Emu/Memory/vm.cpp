@@ -11,11 +11,14 @@
 #include "Utilities/VirtualMemory.h"
 #include "Utilities/asm.h"
 #include "Emu/CPU/CPUThread.h"
+#include "Emu/System.h"
 #include "Emu/Cell/lv2/sys_memory.h"
 #include "Emu/RSX/GSRender.h"
+#include "Emu/RSX/rsx_vertex_cache.h"
 #include <atomic>
 #include <thread>
 #include <deque>
+#include <unordered_map>
 
 LOG_CHANNEL(vm_log, "VM");
 
@@ -324,6 +327,8 @@ namespace vm
 
 	void reservation_lock_internal(atomic_t<u64>& res)
 	{
+		const u64 start = reservation_prof_time();
+
 		for (u64 i = 0;; i++)
 		{
 			if (!res.bts(0)) [[likely]]
@@ -340,6 +345,174 @@ namespace vm
 				std::this_thread::yield();
 			}
 		}
+
+		reservation_prof_wait(static_cast<u32>(&res - reinterpret_cast<atomic_t<u64>*>(g_reservations)) * 128, start);
+	}
+
+	thread_local reservation_stats g_tls_reservation_stats{};
+
+	// Global reservation counters (fast_load, slow_load, fast_store, slow_store, store_fail)
+	static std::array<atomic_t<u64>, 5> s_reservation_stats{};
+
+	bool g_reservation_prof = false;
+
+	// Profiler data for a single reservation line
+	struct reservation_prof_line
+	{
+		u64 ops = 0;
+		u64 fails = 0;
+		u64 waits = 0;
+		u64 wait_ns = 0;
+	};
+
+	// Profiler data collected by a thread (merged periodically and on thread exit)
+	struct reservation_prof_tls
+	{
+		std::unordered_map<u32, reservation_prof_line> lines;
+		u64 count = 0;
+		u64 flush_time = 0;
+	};
+
+	static thread_local reservation_prof_tls s_tls_prof;
+
+	static shared_mutex s_prof_mutex;
+
+	// Merged profiler data
+	static std::unordered_map<u32, reservation_prof_line> s_prof_lines;
+
+	// Merged profiler data timeline (time_ms, addr, ops, fails, waits, wait_us)
+	static std::string s_prof_csv;
+
+	// Profiler start time
+	static u64 s_prof_start = 0;
+
+	static void reservation_prof_flush()
+	{
+		auto& tls = s_tls_prof;
+
+		if (tls.lines.empty())
+		{
+			return;
+		}
+
+		const u64 time = reservation_prof_time();
+
+		std::lock_guard lock(s_prof_mutex);
+
+		for (const auto& [addr, line] : tls.lines)
+		{
+			auto& dst = s_prof_lines[addr];
+			dst.ops += line.ops;
+			dst.fails += line.fails;
+			dst.waits += line.waits;
+			dst.wait_ns += line.wait_ns;
+
+			fmt::append(s_prof_csv, "%u,0x%08x,%u,%u,%u,%u\n", (time - s_prof_start) / 1000000, addr, line.ops, line.fails, line.waits, line.wait_ns / 1000);
+		}
+
+		tls.lines.clear();
+		tls.flush_time = time;
+	}
+
+	void reservation_prof_record(u32 addr, u32 ops, u32 fails, u64 wait_ns)
+	{
+		auto& tls = s_tls_prof;
+		auto& line = tls.lines[addr & -128];
+		line.ops += ops;
+		line.fails += fails;
+
+		if (wait_ns)
+		{
+			line.waits++;
+			line.wait_ns += wait_ns;
+		}
+
+		// Merge every 100ms (checked every 4096 records)
+		if (++tls.count % 4096 == 0 && reservation_prof_time() - tls.flush_time >= 100000000)
+		{
+			reservation_prof_flush();
+		}
+	}
+
+	static void reservation_prof_report()
+	{
+		if (!g_reservation_prof)
+		{
+			return;
+		}
+
+		std::lock_guard lock(s_prof_mutex);
+
+		std::vector<std::pair<u32, reservation_prof_line>> sorted(s_prof_lines.begin(), s_prof_lines.end());
+
+		// Sort by wait time, then by the number of failures
+		std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b)
+		{
+			return std::tie(a.second.wait_ns, a.second.fails, a.second.ops) > std::tie(b.second.wait_ns, b.second.fails, b.second.ops);
+		});
+
+		std::string report;
+
+		for (std::size_t i = 0; i < sorted.size() && i < 32; i++)
+		{
+			const auto& [addr, line] = sorted[i];
+			fmt::append(report, "\n0x%08x: ops=%u, fails=%u (%.2f%%), waits=%u, wait=%uus", addr, line.ops, line.fails, line.ops ? line.fails * 100. / line.ops : 0., line.waits, line.wait_ns / 1000);
+		}
+
+		vm_log.notice("Reservation profiler: %u lines%s", sorted.size(), report);
+
+		if (!s_prof_csv.empty())
+		{
+			const std::string dir = fs::get_cache_dir() + "cache/" + (Emu.GetTitleID().empty() ? "" : Emu.GetTitleID() + "/");
+
+			if (!fs::create_path(dir) || !fs::write_file(dir + "reservations.csv", fs::rewrite, "time_ms,addr,ops,fails,waits,wait_us\n" + s_prof_csv))
+			{
+				vm_log.error("Failed to write reservation profiler data to %s (%s)", dir, fs::g_tls_error);
+			}
+		}
+
+		s_prof_lines.clear();
+		s_prof_csv.clear();
+	}
+
+	void reservation_stats_flush()
+	{
+		if (g_reservation_prof)
+		{
+			reservation_prof_flush();
+		}
+
+		auto& stats = g_tls_reservation_stats;
+
+		s_reservation_stats[0] += stats.fast_load;
+		s_reservation_stats[1] += stats.slow_load;
+		s_reservation_stats[2] += stats.fast_store;
+		s_reservation_stats[3] += stats.slow_store;
+		s_reservation_stats[4] += stats.store_fail;
+		stats = {};
+	}
+
+	void reservation_stats_report()
+	{
+		u64 v[5];
+
+		for (u32 i = 0; i < 5; i++)
+		{
+			v[i] = s_reservation_stats[i].exchange(0);
+		}
+
+		if (!(v[0] | v[1] | v[2] | v[3] | v[4]))
+		{
+			return;
+		}
+
+		const auto percent = [](u64 part, u64 total)
+		{
+			return total ? part * 100. / total : 0.;
+		};
+
+		vm_log.notice("Reservation stats: loads %u (%.2f%% slow), stores %u (%.2f%% slow, %u failed)",
+			v[0] + v[1], percent(v[1], v[0] + v[1]), v[2] + v[3] + v[4], percent(v[3], v[2] + v[3] + v[4]), v[4]);
 	}
 
 	// Page information
@@ -1194,24 +1367,28 @@ namespace vm
 				if (is_write)
 					std::swap(src, dst);
 
-				if (size <= 16 && utils::popcnt32(size) == 1 && (addr & (size - 1)) == 0)
+				if (is_write && size <= 16 && utils::popcnt32(size) == 1 && (addr & (size - 1)) == 0)
 				{
-					if (is_write)
+					switch (size)
 					{
-						switch (size)
-						{
-						case 1: atomic_storage<u8>::release(*static_cast<u8*>(dst), *static_cast<u8*>(src)); break;
-						case 2: atomic_storage<u16>::release(*static_cast<u16*>(dst), *static_cast<u16*>(src)); break;
-						case 4: atomic_storage<u32>::release(*static_cast<u32*>(dst), *static_cast<u32*>(src)); break;
-						case 8: atomic_storage<u64>::release(*static_cast<u64*>(dst), *static_cast<u64*>(src)); break;
-						case 16: _mm_store_si128(static_cast<__m128i*>(dst), _mm_loadu_si128(static_cast<__m128i*>(src))); break;
-						}
-
-						return true;
+					case 1: atomic_storage<u8>::release(*static_cast<u8*>(dst), *static_cast<u8*>(src)); break;
+					case 2: atomic_storage<u16>::release(*static_cast<u16*>(dst), *static_cast<u16*>(src)); break;
+					case 4: atomic_storage<u32>::release(*static_cast<u32*>(dst), *static_cast<u32*>(src)); break;
+					case 8: atomic_storage<u64>::release(*static_cast<u64*>(dst), *static_cast<u64*>(src)); break;
+					case 16: _mm_store_si128(static_cast<__m128i*>(dst), _mm_loadu_si128(static_cast<__m128i*>(src))); break;
 					}
 				}
+				else
+				{
+					std::memcpy(dst, src, size);
+				}
+
+				if (is_write)
+				{
+					// Written through the sudo mapping, write protection didn't fault
+					rsx::vertex_cache::g_page_tracker.on_sudo_write(utils::address_range::start_length(addr, size));
+				}
 
-				std::memcpy(dst, src, size);
 				return true;
 			}
 
@@ -1228,6 +1405,13 @@ namespace vm
 	{
 		void init()
 		{
+			g_reservation_prof = g_cfg.core.reservation_prof.get();
+
+			if (g_reservation_prof)
+			{
+				s_prof_start = reservation_prof_time();
+			}
+
 			g_locations =
 			{
 				std::make_shared<block_t>(0x00010000, 0x1FFF0000, 0x200), // main
@@ -1243,6 +1427,9 @@ namespace vm
 
 	void close()
 	{
+		reservation_stats_report();
+		reservation_prof_report();
+
 		g_locations.clear();
 
 		utils::memory_decommit(g_base_addr, 0x100000000);
@@ -4,6 +4,8 @@
 #include "Utilities/cond.h"
 #include "util/atomic.hpp"
 
+#include <chrono>
+
 namespace vm
 {
 	// Get reservation status for further atomic update: last update timestamp
@@ -40,4 +42,57 @@ namespace vm
 		return res;
 	}
 
+	// Reservation fast path counters (collected per thread without atomics)
+	struct reservation_stats
+	{
+		u64 fast_load = 0; // Load completed by optimistic seqlock read
+		u64 slow_load = 0; // Load required unlocking and waiting
+		u64 fast_store = 0; // Store completed by seqlock CAS
+		u64 slow_store = 0; // Store required locking the line (or the whole memory)
+		u64 store_fail = 0; // Store failed because the reservation was lost
+	};
+
+	extern thread_local reservation_stats g_tls_reservation_stats;
+
+	// Add current thread counters to the global counters and reset them
+	void reservation_stats_flush();
+
+	// Log global counters and reset them
+	void reservation_stats_report();
+
+	// Reservation profiler is enabled (set on initialization)
+	extern bool g_reservation_prof;
+
+	// Add profiler data for the line (wait_ns != 0 counts a wait)
+	void reservation_prof_record(u32 addr, u32 ops, u32 fails, u64 wait_ns);
+
+	// Get timestamp for measuring wait time in the profiler (ns)
+	inline u64 reservation_prof_time()
+	{
+		if (g_reservation_prof) [[unlikely]]
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		return 0;
+	}
+
+	// Record atomic operation on the line (failed conditional store if !success)
+	inline void reservation_prof_op(u32 addr, bool success)
+	{
+		if (g_reservation_prof) [[unlikely]]
+		{
+			reservation_prof_record(addr, 1, !success, 0);
+		}
+	}
+
+	// Record time spent waiting for the line since the timestamp
+	inline void reservation_prof_wait(u32 addr, u64 start)
+	{
+		if (g_reservation_prof && start) [[unlikely]]
+		{
+			reservation_prof_record(addr, 0, 0, std::max<u64>(reservation_prof_time() - start, 1));
+		}
+	}
+
 } // namespace vm
@@ -4,6 +4,8 @@
 
 #include <stack>
 
+#include "xxhash.h"
+
 using namespace program_hash_util;
 
 size_t vertex_program_utils::get_vertex_program_ucode_hash(const RSXVertexProgram &program)
@@ -470,3 +472,247 @@ bool fragment_program_compare::operator()(const RSXFragmentProgram& binary1, con
 			return true;
 	}
 }
+
+fs::file program_output_cache::s_pack;
+std::string program_output_cache::s_path;
+shared_mutex program_output_cache::s_mutex;
+std::unordered_map<u64, std::pair<u64, u32>> program_output_cache::s_index;
+
+void program_output_cache::init(const std::string& path)
+{
+	std::lock_guard lock(s_mutex);
+
+	if (path == s_path && (s_pack || path.empty()))
+	{
+		// Same title
+		return;
+	}
+
+	s_pack.close();
+	s_index.clear();
+	s_path = path;
+
+	if (path.empty())
+	{
+		return;
+	}
+
+	if (!fs::create_path(fs::get_parent_dir(path)) || !open_pack(path))
+	{
+		rsx_log.error("program_output_cache: failed to open %s (%s)", path, fs::g_tls_error);
+		s_pack.close();
+		return;
+	}
+
+	scan_pack(path);
+}
+
+bool program_output_cache::open_pack(const std::string& path)
+{
+	if (!s_pack.open(path, fs::read + fs::write + fs::create + fs::append))
+	{
+		return false;
+	}
+
+	rsx::pack_header header{};
+
+	if (s_pack.size() < sizeof(rsx::pack_header) || s_pack.read_at(0, &header, sizeof(rsx::pack_header)) != sizeof(rsx::pack_header) ||
+		header.magic != pack_magic || header.version != version)
+	{
+		if (s_pack.size())
+		{
+			rsx_log.warning("program_output_cache: resetting %s since it's not compatible with the current decompiler", path);
+		}
+
+		header.magic = pack_magic;
+		header.version = version;
+		s_pack.trunc(0);
+
+		if (s_pack.write(&header, sizeof(rsx::pack_header)) != sizeof(rsx::pack_header))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void program_output_cache::scan_pack(const std::string& path)
+{
+	// Read the whole archive at once
+	std::vector<u8> data = s_pack.to_vector<u8>();
+	std::vector<u64> live;
+	u64 wasted = 0;
+
+	u64 pos = sizeof(rsx::pack_header);
+
+	while (pos + sizeof(rsx::pack_record) <= data.size())
+	{
+		rsx::pack_record rec;
+		std::memcpy(&rec, data.data() + pos, sizeof(rsx::pack_record));
+
+		const u64 next = pos + sizeof(rsx::pack_record) + rec.size;
+
+		if (next > data.size())
+		{
+			break;
+		}
+
+		const u8* ptr = data.data() + pos + sizeof(rsx::pack_record);
+
+		if (rec.type == pack_output && XXH64(ptr, rec.size, rec.key[0]) == rec.key[1] && s_index.emplace(rec.key[0], std::make_pair(pos + sizeof(rsx::pack_record), +rec.size)).second)
+		{
+			live.push_back(pos);
+		}
+		else
+		{
+			// Duplicate or damaged entry
+			wasted++;
+		}
+
+		pos = next;
+	}
+
+	if (pos < data.size())
+	{
+		// Drop incomplete record
+		rsx_log.warning("program_output_cache: %s is truncated (0x%llx of 0x%llx bytes)", path, pos, data.size());
+		data.resize(pos);
+		s_pack.trunc(pos);
+	}
+
+	if (!wasted || wasted * 4 < live.size())
+	{
+		return;
+	}
+
+	// Rewrite the archive with only the valid entries
+	std::vector<u8> packed(data.begin(), data.begin() + sizeof(rsx::pack_header));
+
+	s_index.clear();
+
+	for (u64 rec_pos : live)
+	{
+		rsx::pack_record rec;
+		std::memcpy(&rec, data.data() + rec_pos, sizeof(rsx::pack_record));
+
+		s_index.emplace(rec.key[0], std::make_pair(packed.size() + sizeof(rsx::pack_record), +rec.size));
+		packed.insert(packed.end(), data.begin() + rec_pos, data.begin() + rec_pos + sizeof(rsx::pack_record) + rec.size);
+	}
+
+	rsx_log.notice("program_output_cache: compacting %s (%u wasted records, 0x%llx -> 0x%llx bytes)", path, wasted, data.size(), packed.size());
+
+	s_pack.close();
+
+	if (!fs::write_file(path + ".tmp", fs::rewrite, packed) || !fs::rename(path + ".tmp", path, true))
+	{
+		rsx_log.error("program_output_cache: failed to compact %s (%s)", path, fs::g_tls_error);
+		s_index.clear();
+		s_pack.close();
+		return;
+	}
+
+	if (!open_pack(path))
+	{
+		s_index.clear();
+		s_pack.close();
+	}
+}
+
+bool program_output_cache::append(u64 key, const u8* data, u32 size)
+{
+	rsx::pack_record rec{};
+	rec.type = pack_output;
+	rec.size = size;
+	rec.key[0] = key;
+	rec.key[1] = XXH64(data, size, key);
+
+	std::vector<u8> buf(sizeof(rsx::pack_record) + size);
+	std::memcpy(buf.data(), &rec, sizeof(rsx::pack_record));
+	std::memcpy(buf.data() + sizeof(rsx::pack_record), data, size);
+
+	const u64 pos = s_pack.size();
+
+	if (s_pack.write(buf.data(), buf.size()) != buf.size())
+	{
+		rsx_log.error("program_output_cache: failed to write entry %016llx (%s)", key, fs::g_tls_error);
+		return false;
+	}
+
+	s_index.emplace(key, std::make_pair(pos + sizeof(rsx::pack_record), size));
+	return true;
+}
+
+u64 program_output_cache::get_key(const RSXVertexProgram& prog, u64 variant)
+{
+	std::vector<u64> key;
+	key.push_back(version);
+	key.push_back(variant);
+	key.push_back(vertex_program_utils::get_vertex_program_ucode_hash(prog));
+	key.push_back(prog.output_mask);
+	key.push_back(prog.texture_dimensions);
+	key.push_back(u64{prog.base_address} << 32 | prog.entry);
+
+	for (u32 address : prog.jump_table)
+	{
+		key.push_back(address);
+	}
+
+	return XXH64(key.data(), key.size() * sizeof(u64), 0);
+}
+
+u64 program_output_cache::get_key(const RSXFragmentProgram& prog, u64 variant)
+{
+	std::vector<u64> key;
+	key.push_back(version);
+	key.push_back(variant ^ (1ull << 63));
+	key.push_back(fragment_program_utils::get_fragment_program_ucode_hash(prog));
+	key.push_back(u64{prog.ctrl} << 32 | prog.texture_dimensions);
+	key.push_back(u64{prog.texcoord_control_mask} << 32 | prog.two_sided_lighting);
+	key.push_back(u64{prog.unnormalized_coords} << 32 | u64{prog.redirected_textures} << 16 | prog.shadow_textures);
+
+	for (u8 index = 0; index < 16; ++index)
+	{
+		key.push_back(u64{prog.textures_alpha_kill[index]} << 32 | prog.textures_zfunc[index]);
+	}
+
+	return XXH64(key.data(), key.size() * sizeof(u64), 0);
+}
+
+bool program_output_cache::load(u64 key, std::vector<u8>& data)
+{
+	// Positional reads, entries can be loaded in parallel
+	reader_lock lock(s_mutex);
+
+	const auto found = s_index.find(key);
+
+	if (found == s_index.end())
+	{
+		return false;
+	}
+
+	const auto [pos, size] = found->second;
+
+	data.resize(size);
+
+	if (s_pack.read_at(pos, data.data(), size) != size)
+	{
+		rsx_log.error("program_output_cache: failed to read entry %016llx (%s)", key, fs::g_tls_error);
+		data.clear();
+		return false;
+	}
+
+	return true;
+}
+
+void program_output_cache::store(u64 key, const std::vector<u8>& data)
+{
+	std::lock_guard lock(s_mutex);
+
+	if (!s_pack || s_index.count(key))
+	{
+		return;
+	}
+
+	append(key, data.data(), ::size32(data));
+}
@@ -7,8 +7,10 @@
 #include "Utilities/mutex.h"
 #include "Utilities/Log.h"
 #include "Utilities/span.h"
+#include "Utilities/File.h"
 
 #include <deque>
+#include <unordered_map>
 
 enum class SHADER_TYPE
 {
@@ -84,6 +86,145 @@ namespace program_hash_util
 	};
 }
 
+namespace rsx
+{
+	// Packed cache archive header (pipeline cache and decompiler output cache)
+	struct pack_header
+	{
+		le_t<u32> magic;
+		le_t<u32> version;
+	};
+
+	// Packed cache archive record (followed by the data)
+	struct pack_record
+	{
+		le_t<u32> type;
+		le_t<u32> size;
+		le_t<u64> key[4];
+	};
+}
+
+/**
+* Disk cache for the decompiler output (shader source and backend data), shared by all pipeline classes of the backend.
+* Entries are keyed by the program hash, the state used by the decompiler and the backend variant (device properties).
+* They are appended to a packed archive using the pipeline cache archive layout (record key: entry key, checksum).
+*/
+class program_output_cache
+{
+	static constexpr u32 pack_magic = "RSXD"_u32;
+	static constexpr u32 pack_output = 1;
+
+	static fs::file s_pack;
+	static std::string s_path;
+	static shared_mutex s_mutex;
+
+	// Entries in the archive (key -> data offset and size)
+	static std::unordered_map<u64, std::pair<u64, u32>> s_index;
+
+	static bool open_pack(const std::string& path);
+	static void scan_pack(const std::string& path);
+	static bool append(u64 key, const u8* data, u32 size);
+
+public:
+	// Must be changed when the decompiler output changes
+	static constexpr u32 version = 1;
+
+	struct writer
+	{
+		std::vector<u8> data;
+
+		template <typename T>
+		void put(const T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "program_output_cache::writer: invalid type");
+			const auto ptr = reinterpret_cast<const u8*>(&value);
+			data.insert(data.end(), ptr, ptr + sizeof(T));
+		}
+
+		void put(const std::string& str)
+		{
+			put<u32>(::size32(str));
+			data.insert(data.end(), str.begin(), str.end());
+		}
+
+		template <typename T>
+		void put(const std::vector<T>& vec)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "program_output_cache::writer: invalid type");
+			put<u32>(::size32(vec));
+			const auto ptr = reinterpret_cast<const u8*>(vec.data());
+			data.insert(data.end(), ptr, ptr + vec.size() * sizeof(T));
+		}
+	};
+
+	struct reader
+	{
+		const std::vector<u8>& data;
+		std::size_t pos = 0;
+
+		template <typename T>
+		bool get(T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "program_output_cache::reader: invalid type");
+
+			if (data.size() - pos < sizeof(T))
+			{
+				return false;
+			}
+
+			std::memcpy(&value, data.data() + pos, sizeof(T));
+			pos += sizeof(T);
+			return true;
+		}
+
+		bool get(std::string& str)
+		{
+			u32 size;
+
+			if (!get(size) || data.size() - pos < size)
+			{
+				return false;
+			}
+
+			str.assign(reinterpret_cast<const char*>(data.data() + pos), size);
+			pos += size;
+			return true;
+		}
+
+		template <typename T>
+		bool get(std::vector<T>& vec)
+		{
+			u32 size;
+
+			if (!get(size) || (data.size() - pos) / sizeof(T) < size)
+			{
+				return false;
+			}
+
+			vec.resize(size);
+			std::memcpy(vec.data(), data.data() + pos, size * sizeof(T));
+			pos += size * sizeof(T);
+			return true;
+		}
+
+		bool end() const
+		{
+			return pos == data.size();
+		}
+	};
+
+	// Open the archive (empty path disables the cache), does nothing if it's already open
+	static void init(const std::string& path);
+
+	static u64 get_key(const RSXVertexProgram& prog, u64 variant);
+
+	static u64 get_key(const RSXFragmentProgram& prog, u64 variant);
+
+	// Returns false if the entry doesn't exist or is damaged
+	static bool load(u64 key, std::vector<u8>& data);
+
+	static void store(u64 key, const std::vector<u8>& data);
+};
 
 /**
 * Cache for program help structure (blob, string...)
@@ -56,6 +56,7 @@ protected:
 	size_t m_min_guard_size; //If an allocation touches the guard region, reset the heap to avoid going over budget
 	size_t m_current_allocated_size;
 	size_t m_largest_allocated_pool;
+	u64 m_total_put_pos = 0; // Put position including all wrap-arounds (never reset)
 
 	char* m_name;
 public:
@@ -98,16 +99,46 @@ public:
 
 		if (aligned_put_pos + alloc_size < m_size)
 		{
+			m_total_put_pos += block_length;
 			m_put_pos = aligned_put_pos + alloc_size;
 			return aligned_put_pos;
 		}
 		else
 		{
+			m_total_put_pos += (m_size - m_put_pos) + alloc_size;
 			m_put_pos = alloc_size;
 			return 0;
 		}
 	}
 
+	/**
+	* Monotonic position of an allocation still in use (offsets are reused after a wrap-around)
+	*/
+	u64 get_heap_position(size_t offset) const
+	{
+		return m_total_put_pos - ((m_put_pos + m_size - offset) % m_size);
+	}
+
+	/**
+	* Oldest allocation which is still in use and at most max_age bytes behind the put position.
+	* Older allocations may have been overwritten.
+	*/
+	u64 get_min_heap_position(u64 max_age) const
+	{
+		const u64 in_use = (m_put_pos + m_size - m_get_pos - 1) % m_size;
+		return m_total_put_pos - std::min(in_use, max_age);
+	}
+
+	/**
+	* Keep the allocations from position in use (moves the get position back)
+	* Only valid if the position is not older than get_min_heap_position()
+	*/
+	void hold(u64 position)
+	{
+		const size_t offset = (m_put_pos + m_size - (m_total_put_pos - position)) % m_size;
+		m_get_pos = (offset + m_size - 1) % m_size;
+	}
+
 	/**
 	* return current putpos - 1
 	*/
@@ -1466,6 +1466,9 @@ namespace rsx
 					_dst += rsx_pitch;
 				}
 			}
+
+			// Written through the sudo mapping
+			vertex_cache::g_page_tracker.on_sudo_write(valid_range);
 		}
 
 
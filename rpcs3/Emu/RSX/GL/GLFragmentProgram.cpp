@@ -7,6 +7,7 @@
 #include "GLCommonDecompiler.h"
 #include "../GCM.h"
 #include "../Common/GLSLCommon.h"
+#include "../Common/ProgramStateCache.h"
 
 std::string GLFragmentDecompilerThread::getFloatTypeName(size_t elementCount)
 {
@@ -340,15 +341,29 @@ GLFragmentProgram::~GLFragmentProgram()
 
 void GLFragmentProgram::Decompile(const RSXFragmentProgram& prog)
 {
-	u32 size;
-	GLFragmentDecompilerThread decompiler(shader, parr, prog, size);
+	const auto& driver_caps = gl::get_driver_caps();
+	const bool native_half = !g_cfg.video.disable_native_float16 && (driver_caps.NV_gpu_shader5_supported || driver_caps.AMD_gpu_shader_half_float_supported);
+
+	// Output depends on the half float extension used and on the vendor specific shader properties
+	const u64 variant = u64{native_half} | u64{driver_caps.NV_gpu_shader5_supported} << 1 | u64{driver_caps.vendor_NVIDIA} << 2;
+	const u64 key = program_output_cache::get_key(prog, variant);
 
-	if (!g_cfg.video.disable_native_float16)
+	if (std::vector<u8> data; program_output_cache::load(key, data))
 	{
-		const auto driver_caps = gl::get_driver_caps();
-		decompiler.device_props.has_native_half_support = driver_caps.NV_gpu_shader5_supported || driver_caps.AMD_gpu_shader_half_float_supported;
+		program_output_cache::reader in{data};
+
+		if (in.get(shader) && in.get(FragmentConstantOffsetCache) && in.end())
+		{
+			return;
+		}
+
+		shader.clear();
+		FragmentConstantOffsetCache.clear();
 	}
 
+	u32 size;
+	GLFragmentDecompilerThread decompiler(shader, parr, prog, size);
+	decompiler.device_props.has_native_half_support = native_half;
 	decompiler.Task();
 
 	for (const ParamType& PT : decompiler.m_parr.params[PF_PARAM_UNIFORM])
@@ -365,6 +380,11 @@ void GLFragmentProgram::Decompile(const RSXFragmentProgram& prog)
 			FragmentConstantOffsetCache.push_back(offset);
 		}
 	}
+
+	program_output_cache::writer out;
+	out.put(shader);
+	out.put(FragmentConstantOffsetCache);
+	program_output_cache::store(key, out.data);
 }
 
 void GLFragmentProgram::Compile()
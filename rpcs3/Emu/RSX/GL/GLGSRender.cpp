@@ -36,7 +36,7 @@ GLGSRender::GLGSRender() : GSRender()
 	if (g_cfg.video.disable_vertex_cache || g_cfg.video.multithreaded_rsx)
 		m_vertex_cache = std::make_unique<gl::null_vertex_cache>();
 	else
-		m_vertex_cache = std::make_unique<gl::weak_vertex_cache>();
+		m_vertex_cache = std::make_unique<gl::persistent_vertex_cache>();
 
 	backend_config.supports_hw_a2c = false;
 	backend_config.supports_hw_a2one = false;
@@ -952,6 +952,9 @@ namespace gl
 		u32 m_data_loc = 0;
 		void *m_memory_mapping = nullptr;
 
+		// Number of wrap-arounds (contents of previous laps may be overwritten)
+		u64 m_lap = 0;
+
 		fence m_fence;
 
 	public:
@@ -964,6 +967,8 @@ namespace gl
 				remove();
 			}
 
+			m_lap++;
+
 			buffer::create();
 
 			GLbitfield buffer_storage_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
@@ -1003,6 +1008,7 @@ namespace gl
 
 				m_data_loc = 0;
 				offset = 0;
+				m_lap++;
 			}
 
 			//Align data loc to 256; allows some "guard" region so we dont trample our own data inadvertently
@@ -1030,6 +1036,18 @@ namespace gl
 
 		virtual void unmap() {}
 
+		// Monotonic position of an offset allocated in the current lap
+		u64 get_heap_position(u32 offset) const
+		{
+			return m_lap * m_size + offset;
+		}
+
+		// Oldest allocation of the current lap at most max_age bytes behind the put position
+		u64 get_min_heap_position(u64 max_age) const
+		{
+			return m_lap * m_size + (m_data_loc - std::min<u64>(m_data_loc, max_age));
+		}
+
 		//Notification of a draw command
 		virtual void notify()
 		{
@@ -1052,6 +1070,8 @@ namespace gl
 			if (m_id)
 				remove();
 
+			m_lap++;
+
 			buffer::create();
 			buffer::data(size, data, GL_DYNAMIC_DRAW);
 
@@ -1080,6 +1100,7 @@ namespace gl
 			{
 				buffer::data(m_size, nullptr, GL_DYNAMIC_DRAW);
 				m_data_loc = 0;
+				m_lap++;
 			}
 
 			glBindBuffer(static_cast<GLenum>(m_target), m_id);
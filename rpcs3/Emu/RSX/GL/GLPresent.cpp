@@ -276,7 +276,6 @@ void GLGSRender::flip(const rsx::display_flip_info_t& info)
 
 	// Cleanup
 	m_gl_texture_cache.on_frame_end();
-	m_vertex_cache->purge();
 
 	auto removed_textures = m_rtts.free_invalidated();
 	m_framebuffer_cache.remove_if([&](auto& fbo)
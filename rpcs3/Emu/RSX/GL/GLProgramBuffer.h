@@ -12,18 +12,29 @@ struct GLTraits
 	using pipeline_storage_type = std::unique_ptr<gl::glsl::program>;
 	using pipeline_properties = void*;
 
+	// Set on threads without GL context (shaders are only decompiled, see GLProgramBuffer::compile_deferred)
+	static inline thread_local bool defer_compile = false;
+
 	static
 	void recompile_fragment_program(const RSXFragmentProgram &RSXFP, fragment_program_type& fragmentProgramData, size_t /*ID*/)
 	{
 		fragmentProgramData.Decompile(RSXFP);
-		fragmentProgramData.Compile();
+
+		if (!defer_compile)
+		{
+			fragmentProgramData.Compile();
+		}
 	}
 
 	static
 	void recompile_vertex_program(const RSXVertexProgram &RSXVP, vertex_program_type& vertexProgramData, size_t /*ID*/)
 	{
 		vertexProgramData.Decompile(RSXVP);
-		vertexProgramData.Compile();
+
+		if (!defer_compile)
+		{
+			vertexProgramData.Compile();
+		}
 	}
 
 	static
@@ -109,14 +120,40 @@ public:
 	void add_pipeline_entry(RSXVertexProgram &vp, RSXFragmentProgram &fp, void* &props, Args&& ...args)
 	{
 		vp.skip_vertex_input_check = true;
+		compile_deferred(vp, fp);
 		get_graphics_pipeline(vp, fp, props, false, std::forward<Args>(args)...);
 	}
 
-    void preload_programs(RSXVertexProgram &vp, RSXFragmentProgram &fp)
-    {
+	// Called from shader cache workers which have no GL context
+	void preload_programs(RSXVertexProgram &vp, RSXFragmentProgram &fp)
+	{
+		GLTraits::defer_compile = true;
 		search_vertex_program(vp);
 		search_fragment_program(fp);
-    }
+		GLTraits::defer_compile = false;
+	}
+
+	// Compile shaders decompiled by preload_programs (requires GL context)
+	void compile_deferred(const RSXVertexProgram &vp, const RSXFragmentProgram &fp)
+	{
+		{
+			std::lock_guard lock(m_vertex_mutex);
+
+			if (auto found = m_vertex_shader_cache.find(vp); found != m_vertex_shader_cache.end() && !found->second.id)
+			{
+				found->second.Compile();
+			}
+		}
+
+		{
+			std::lock_guard lock(m_fragment_mutex);
+
+			if (auto found = m_fragment_shader_cache.find(fp); found != m_fragment_shader_cache.end() && !found->second.id)
+			{
+				found->second.Compile();
+			}
+		}
+	}
 
 	bool check_cache_missed() const
 	{
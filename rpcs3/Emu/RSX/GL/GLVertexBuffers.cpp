@@ -186,18 +186,21 @@ gl::vertex_upload_info GLGSRender::set_vertex_buffer()
 	{
 		//Check if cacheable
 		//Only data in the 'persistent' block may be cached
-		//TODO: make vertex cache keep local data beyond frame boundaries and hook notify command
 		bool in_cache = false;
 		bool to_store = false;
 		u32  storage_address = UINT32_MAX;
+		u32  storage_stride = 0;
 
 		if (m_vertex_layout.interleaved_blocks.size() == 1 &&
 			rsx::method_registers.current_draw_clause.command != rsx::draw_command::inlined_array)
 		{
-			const auto data_offset = (vertex_base * m_vertex_layout.interleaved_blocks[0].attribute_stride);
-			storage_address = m_vertex_layout.interleaved_blocks[0].real_offset_address + data_offset;
+			storage_stride = m_vertex_layout.interleaved_blocks[0].attribute_stride;
+			storage_address = m_vertex_layout.interleaved_blocks[0].real_offset_address + (vertex_base * storage_stride);
 
-			if (auto cached = m_vertex_cache->find_vertex_range(storage_address, GL_R8UI, required.first))
+			// The ring buffer doesn't track GPU progress, only reuse recent data (overwritten long after its last use)
+			const u64 min_heap_position = m_attrib_ring_buffer->get_min_heap_position(m_attrib_ring_buffer->size() / 4);
+
+			if (auto cached = m_vertex_cache->find_vertex_range(storage_address, required.first, storage_stride, min_heap_position))
 			{
 				verify(HERE), cached->local_address == storage_address;
 
@@ -218,7 +221,8 @@ gl::vertex_upload_info GLGSRender::set_vertex_buffer()
 			if (to_store)
 			{
 				//store ref in vertex cache
-				m_vertex_cache->store_range(storage_address, GL_R8UI, required.first, persistent_mapping.second);
+				m_vertex_cache->store_range(storage_address, required.first, storage_stride, persistent_mapping.second,
+					m_attrib_ring_buffer->get_heap_position(persistent_mapping.second));
 			}
 		}
 
@@ -6,6 +6,7 @@
 #include "GLCommonDecompiler.h"
 #include "GLHelpers.h"
 #include "../Common/GLSLCommon.h"
+#include "../Common/ProgramStateCache.h"
 
 #include <algorithm>
 
@@ -267,8 +268,27 @@ GLVertexProgram::~GLVertexProgram()
 
 void GLVertexProgram::Decompile(const RSXVertexProgram& prog)
 {
+	// Vertex input fetch depends on the driver vendor
+	const u64 key = program_output_cache::get_key(prog, gl::get_driver_caps().vendor_INTEL);
+
+	if (std::vector<u8> data; program_output_cache::load(key, data))
+	{
+		program_output_cache::reader in{data};
+
+		if (in.get(shader) && in.end())
+		{
+			return;
+		}
+
+		shader.clear();
+	}
+
 	GLVertexDecompilerThread decompiler(prog, shader, parr);
 	decompiler.Task();
+
+	program_output_cache::writer out;
+	out.put(shader);
+	program_output_cache::store(key, out.data);
 }
 
 void GLVertexProgram::Compile()
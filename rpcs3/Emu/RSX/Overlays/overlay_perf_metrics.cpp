@@ -1,6 +1,7 @@
 ﻿#include "stdafx.h"
 #include "overlay_perf_metrics.h"
 #include "../GSRender.h"
+#include "../rsx_vertex_cache.h"
 
 #include "Emu/Cell/SPUThread.h"
 #include "Emu/Cell/RawSPUThread.h"
@@ -188,7 +189,7 @@ namespace rsx
 			case detail_level::minimal:
 			case detail_level::low: m_titles.text = ""; break;
 			case detail_level::medium: m_titles.text = fmt::format("\n\n%s", title1_medium); break;
-			case detail_level::high: m_titles.text = fmt::format("\n\n%s\n\n\n\n\n\n%s", title1_high, title2); break;
+			case detail_level::high: m_titles.text = fmt::format("\n\n%s\n\n\n\n\n\n%s\n\n\n%s", title1_high, title2, title3); break;
 			}
 			m_titles.auto_resize();
 			m_titles.refresh();
@@ -390,6 +391,9 @@ namespace rsx
 				f32 rsx_usage{0};
 				u32 rsx_load{0};
 
+				f32 vertex_hit_rate{0};
+				f32 vertex_saved{0}; // MB/s
+
 				const auto rsx_thread = g_fxo->get<rsx::thread>();
 
 				std::string perf_text;
@@ -405,6 +409,18 @@ namespace rsx
 
 					total_threads = CPUStats::get_thread_count();
 
+					const u64 hits = rsx::vertex_cache::g_stats.hits;
+					const u64 misses = rsx::vertex_cache::g_stats.misses;
+					const u64 bytes_saved = rsx::vertex_cache::g_stats.bytes_saved;
+
+					const u64 lookups = (hits - m_vertex_cache_hits) + (misses - m_vertex_cache_misses);
+					vertex_hit_rate = lookups ? (hits - m_vertex_cache_hits) * 100.f / lookups : 0.f;
+					vertex_saved = m_force_update ? 0 : std::max(0.0, (bytes_saved - m_vertex_cache_bytes_saved) / 1048576. / (elapsed_update / 1000));
+
+					m_vertex_cache_hits = hits;
+					m_vertex_cache_misses = misses;
+					m_vertex_cache_bytes_saved = bytes_saved;
+
 					// fallthrough
 				}
 				case detail_level::medium:
@@ -480,8 +496,12 @@ namespace rsx
 					                         " RSX   : %04.1f %% ( 1)\n"
 					                         " Total : %04.1f %% (%2u)\n\n"
 					                         "%s\n"
-					                         " RSX   : %02u %%",
-					    fps, frametime, std::string(title1_high.size(), ' '), ppu_usage, ppus, spu_usage, spus, rsx_usage, cpu_usage, total_threads, std::string(title2.size(), ' '), rsx_load);
+					                         " RSX   : %02u %%\n\n"
+					                         "%s\n"
+					                         " Hits  : %04.1f %%\n"
+					                         " Saved : %.1f MB/s",
+					    fps, frametime, std::string(title1_high.size(), ' '), ppu_usage, ppus, spu_usage, spus, rsx_usage, cpu_usage, total_threads, std::string(title2.size(), ' '), rsx_load,
+					    std::string(title3.size(), ' '), vertex_hit_rate, vertex_saved);
 					break;
 				}
 				}
@@ -12,7 +12,7 @@ namespace rsx
 			// minimal - fps
 			// low - fps, total cpu usage
 			// medium - fps, detailed cpu usage
-			// high - fps, frametime, detailed cpu usage, thread number, rsx load
+			// high - fps, frametime, detailed cpu usage, thread number, rsx load, vertex cache
 			detail_level m_detail{};
 
 			screen_quadrant m_quadrant{};
@@ -31,6 +31,9 @@ namespace rsx
 			Timer m_frametime_timer{};
 			u32 m_update_interval{}; // in ms
 			u32 m_frames{};
+			u64 m_vertex_cache_hits{};
+			u64 m_vertex_cache_misses{};
+			u64 m_vertex_cache_bytes_saved{};
 			std::string m_font{};
 			u16 m_font_size{};
 			u32 m_margin_x{}; // horizontal distance to the screen border relative to the screen_quadrant in px
@@ -53,6 +56,7 @@ namespace rsx
 			const std::string title1_medium{ "CPU Utilization:" };
 			const std::string title1_high{ "Host Utilization (CPU):" };
 			const std::string title2{ "Guest Utilization (PS3):" };
+			const std::string title3{ "Vertex Cache:" };
 
 			void reset_transform(label& elm, u16 bottom_margin = 0) const;
 			void reset_transforms();
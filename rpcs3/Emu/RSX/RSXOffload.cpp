@@ -5,12 +5,18 @@
 #include "RSXOffload.h"
 #include "RSXThread.h"
 #include "rsx_utils.h"
+#include "rsx_write_tracker.h"
 
 #include <thread>
 #include <atomic>
 
+extern u64 get_system_time();
+
 namespace rsx
 {
+	thread_local bool dma_manager::s_is_offloader_thread = false;
+	thread_local const dma_manager::transport_task* dma_manager::s_current_task = nullptr;
+
 	// initialization
 	void dma_manager::init()
 	{
@@ -21,6 +27,24 @@ namespace rsx
 		// Empty work queue in case of stale contents
 		m_work_queue.pop_all();
 
+		m_pending_tasks.clear();
+		m_batch.clear();
+		m_batch_size.release(0);
+		m_batch_done.release(0);
+		m_batch_ctrl.release(UINT32_MAX);
+		m_helper_count = g_cfg.video.multithreaded_rsx ? g_cfg.video.offloader_thread_count - 1 : 0;
+
+		m_start_time = get_system_time();
+		m_busy_time = 0;
+		m_bytes_copied = 0;
+		m_packets_processed = 0;
+		m_packets_coalesced = 0;
+		m_chunks_split = 0;
+		m_batches_run = 0;
+		m_queue_depth_sum = 0;
+		m_queue_depth_max = 0;
+		m_enqueue_events = 0;
+
 		thread_ctrl::spawn("RSX offloader", [this]()
 		{
 			if (!g_cfg.video.multithreaded_rsx)
@@ -30,7 +54,8 @@ namespace rsx
 			}
 
 			// Register thread id
-			m_thread_id = std::this_thread::get_id();
+			s_is_offloader_thread = true;
+			g_write_tracker.register_self_handling_thread();
 
 			if (g_cfg.core.thread_scheduler_enabled)
 			{
@@ -41,33 +66,36 @@ namespace rsx
 			{
 				if (m_enqueued_count.load() != m_processed_count)
 				{
-					for (m_current_job = m_work_queue.pop_all(); m_current_job; m_current_job.pop_front())
+					auto job = m_work_queue.pop_all();
+					u64 count = 0;
+
+					for (const auto& packet : job)
 					{
-						switch (m_current_job->type)
+						if (packet.type == callback)
 						{
-						case raw_copy:
-							memcpy(m_current_job->dst, m_current_job->src, m_current_job->length);
-							break;
-						case vector_copy:
-							memcpy(m_current_job->dst, m_current_job->opt_storage.data(), m_current_job->length);
-							break;
-						case index_emulate:
-							write_index_array_for_non_indexed_non_native_primitive_to_buffer(
-								reinterpret_cast<char*>(m_current_job->dst),
-								static_cast<rsx::primitive_type>(m_current_job->aux_param0),
-								m_current_job->length);
-							break;
-						case callback:
-							rsx::get_current_renderer()->renderctl(m_current_job->aux_param0, m_current_job->src);
-							break;
-						default:
-							ASSUME(0);
-							fmt::throw_exception("Unreachable" HERE);
+							// Completion fence: everything enqueued before the callback must be done
+							run_batch();
+							s_current_task = nullptr;
+
+							rsx::get_current_renderer()->renderctl(packet.aux_param0, packet.src);
+
+							std::atomic_thread_fence(std::memory_order_release);
+							m_processed_count = m_processed_count + count + 1;
+							m_packets_processed += count + 1;
+							count = 0;
+							continue;
 						}
 
-						std::atomic_thread_fence(std::memory_order_release);
-						++m_processed_count;
+						add_task(packet);
+						count++;
 					}
+
+					run_batch();
+					s_current_task = nullptr;
+
+					std::atomic_thread_fence(std::memory_order_release);
+					m_processed_count = m_processed_count + count;
+					m_packets_processed += count;
 				}
 				else
 				{
@@ -78,6 +106,49 @@ namespace rsx
 
 			m_processed_count = m_enqueued_count.load();
 		});
+
+		for (u32 i = 0; i < m_helper_count; i++)
+		{
+			m_helpers_running++;
+
+			thread_ctrl::spawn(fmt::format("RSX offloader %u", i + 1), [this]()
+			{
+				s_is_offloader_thread = true;
+				g_write_tracker.register_self_handling_thread();
+
+				if (g_cfg.core.thread_scheduler_enabled)
+				{
+					thread_ctrl::set_thread_affinity_mask(thread_ctrl::get_affinity_mask(thread_class::rsx));
+				}
+
+				while (m_worker_state != thread_state::finished)
+				{
+					if (execute_next_batch_task())
+					{
+						continue;
+					}
+
+					// Sleep until the next batch is published (the timeout only matters on exit)
+					const u64 ctrl = m_batch_ctrl.load();
+
+					if (static_cast<u32>(ctrl) >= m_batch_size)
+					{
+						m_batch_ctrl.wait(ctrl, atomic_wait_timeout{1'000'000});
+					}
+				}
+
+				m_helpers_running--;
+			});
+		}
+	}
+
+	void dma_manager::on_enqueue()
+	{
+		const u64 depth = ++m_enqueued_count - m_processed_count;
+
+		m_queue_depth_sum += depth;
+		m_queue_depth_max = std::max(m_queue_depth_max, depth);
+		m_enqueue_events++;
 	}
 
 	// General transport
@@ -89,7 +160,7 @@ namespace rsx
 		}
 		else
 		{
-			++m_enqueued_count;
+			on_enqueue();
 			m_work_queue.push(dst, src, length);
 		}
 	}
@@ -102,7 +173,7 @@ namespace rsx
 		}
 		else
 		{
-			++m_enqueued_count;
+			on_enqueue();
 			m_work_queue.push(dst, src, length);
 		}
 	}
@@ -117,7 +188,7 @@ namespace rsx
 		}
 		else
 		{
-			++m_enqueued_count;
+			on_enqueue();
 			m_work_queue.push(dst, primitive, count);
 		}
 	}
@@ -127,14 +198,204 @@ namespace rsx
 	{
 		verify(HERE), g_cfg.video.multithreaded_rsx;
 
-		++m_enqueued_count;
+		on_enqueue();
 		m_work_queue.push(request_code, args);
 	}
 
+	// Batch processing
+	bool dma_manager::has_hazard(const transport_task& task) const
+	{
+		// Bytes written by the task
+		const auto write_size = [](const transport_task& t) -> size_t
+		{
+			return t.type == index_emulate ? get_index_count(static_cast<rsx::primitive_type>(t.aux_param0), t.length) * sizeof(u16) : t.length;
+		};
+
+		const auto overlaps = [](const u8* a, size_t a_size, const u8* b, size_t b_size)
+		{
+			return a && b && a < b + b_size && b < a + a_size;
+		};
+
+		const size_t size = write_size(task);
+
+		for (const auto& prev : m_pending_tasks)
+		{
+			const size_t prev_size = write_size(prev);
+
+			// Write after write, read after write, write after read
+			if (overlaps(task.dst, size, prev.dst, prev_size) ||
+				overlaps(task.src, task.length, prev.dst, prev_size) ||
+				overlaps(task.dst, size, prev.src, prev.length))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void dma_manager::add_task(const transport_packet& packet)
+	{
+		transport_task task{ packet.type, static_cast<u8*>(packet.dst), nullptr, packet.length, packet.aux_param0 };
+
+		switch (packet.type)
+		{
+		case raw_copy:
+		case vector_copy:
+			task.src = packet.type == raw_copy ? static_cast<const u8*>(packet.src) : packet.opt_storage.data();
+			break;
+		case index_emulate:
+			break;
+		default:
+			ASSUME(0);
+			fmt::throw_exception("Unreachable" HERE);
+		}
+
+		// Tasks of a batch run in any order, dependent tasks must go to the next batch
+		if (has_hazard(task))
+		{
+			run_batch();
+		}
+
+		if (packet.type == raw_copy)
+		{
+			if (!m_pending_tasks.empty())
+			{
+				// Coalesce with the previous copy if both ranges are contiguous
+				auto& last = m_pending_tasks.back();
+
+				if (last.type == raw_copy && last.dst + last.length == task.dst && last.src + last.length == task.src)
+				{
+					last.length += task.length;
+					m_packets_coalesced++;
+					return;
+				}
+			}
+		}
+
+		m_pending_tasks.push_back(task);
+	}
+
+	void dma_manager::execute(const transport_task& task)
+	{
+		s_current_task = &task;
+
+		switch (task.type)
+		{
+		case raw_copy:
+		case vector_copy:
+			std::memcpy(task.dst, task.src, task.length);
+			break;
+		case index_emulate:
+			write_index_array_for_non_indexed_non_native_primitive_to_buffer(
+				reinterpret_cast<char*>(task.dst),
+				static_cast<rsx::primitive_type>(task.aux_param0),
+				task.length);
+			break;
+		default:
+			ASSUME(0);
+			fmt::throw_exception("Unreachable" HERE);
+		}
+	}
+
+	bool dma_manager::execute_next_batch_task()
+	{
+		u64 ctrl = m_batch_ctrl.load();
+		u32 index;
+
+		do
+		{
+			index = static_cast<u32>(ctrl);
+
+			if (index >= m_batch_size)
+			{
+				return false;
+			}
+		}
+		while (!m_batch_ctrl.compare_exchange(ctrl, ctrl + 1));
+
+		execute(m_batch[index]);
+		m_batch_done++;
+		return true;
+	}
+
+	void dma_manager::run_batch()
+	{
+		if (m_pending_tasks.empty())
+		{
+			return;
+		}
+
+		const u64 start = get_system_time();
+
+		m_batch.clear();
+
+		for (const auto& task : m_pending_tasks)
+		{
+			if (task.type != index_emulate)
+			{
+				m_bytes_copied += task.length;
+			}
+
+			if (task.type == index_emulate || !m_helper_count || task.length < min_chunk_size * 2)
+			{
+				m_batch.push_back(task);
+				continue;
+			}
+
+			// Split large copies between the offloader threads
+			const u32 parts = std::min(m_helper_count + 1, task.length / min_chunk_size);
+			const u32 part_size = ::align(task.length / parts, 64);
+
+			for (u32 offset = 0; offset < task.length; offset += part_size)
+			{
+				m_batch.push_back({ task.type, task.dst + offset, task.src + offset, std::min(part_size, task.length - offset), 0 });
+				m_chunks_split++;
+			}
+		}
+
+		m_pending_tasks.clear();
+		m_batches_run++;
+
+		if (!m_helper_count || m_batch.size() == 1)
+		{
+			// Nothing to share
+			for (const auto& task : m_batch)
+			{
+				execute(task);
+			}
+		}
+		else
+		{
+			const u64 batch_id = (m_batch_ctrl.load() >> 32) + 1;
+
+			// Publish the batch (the task index is reset)
+			m_batch_size.release(::size32(m_batch));
+			m_batch_done.release(0);
+			m_batch_ctrl.release(batch_id << 32);
+			m_batch_ctrl.notify_all();
+
+			while (execute_next_batch_task())
+			{
+			}
+
+			// Wait for the tasks taken by the helper threads
+			while (m_batch_done != m_batch.size())
+			{
+				_mm_pause();
+			}
+
+			// Close the batch before its storage is reused
+			m_batch_ctrl.release(batch_id << 32 | UINT32_MAX);
+		}
+
+		m_busy_time += get_system_time() - start;
+	}
+
 	// Synchronization
 	bool dma_manager::is_current_thread() const
 	{
-		return (std::this_thread::get_id() == m_thread_id);
+		return s_is_offloader_thread;
 	}
 
 	bool dma_manager::sync()
@@ -171,13 +432,39 @@ namespace rsx
 	void dma_manager::join()
 	{
 		m_worker_state = thread_state::finished;
+
+		// Wake up the helper threads (the batch id is changed so a helper about to sleep doesn't wait for the timeout)
+		m_batch_ctrl += 1ull << 32;
+		m_batch_ctrl.notify_all();
+
 		sync();
+
+		// Wait for the helper threads to exit
+		while (m_helpers_running)
+		{
+			std::this_thread::yield();
+		}
+
+		if (m_packets_processed)
+		{
+			const u64 time = std::max<u64>(get_system_time() - m_start_time, 1);
+			const u64 busy_time = std::max<u64>(m_busy_time, 1);
+
+			rsx_log.notice("RSX offloader (%u threads): %llu packets (%llu coalesced, %llu chunks split) in %llu batches, %.1f MB copied at %.1f MB/s (busy %.1f%%), queue depth avg %.1f max %llu",
+				m_helper_count + 1, m_packets_processed, m_packets_coalesced, m_chunks_split, m_batches_run, m_bytes_copied / 1048576., m_bytes_copied / 1.048576 / busy_time,
+				m_busy_time * 100. / time, m_enqueue_events ? static_cast<double>(m_queue_depth_sum) / m_enqueue_events : 0., m_queue_depth_max);
+		}
 	}
 
 	void dma_manager::set_mem_fault_flag()
 	{
 		verify("Access denied" HERE), is_current_thread();
-		m_mem_fault_flag.release(true);
+
+		// Several offloader threads may fault at the same time, they are recovered one at a time
+		while (!m_mem_fault_flag.compare_and_swap_test(false, true))
+		{
+			_mm_pause();
+		}
 	}
 
 	void dma_manager::clear_mem_fault_flag()
@@ -189,24 +476,25 @@ namespace rsx
 	// Fault recovery
 	utils::address_range dma_manager::get_fault_range(bool writing) const
 	{
-		verify(HERE), m_current_job;
+		const auto task = s_current_task;
+		verify(HERE), task;
 
-		void *address = nullptr;
-		u32 range = m_current_job->length;
+		const void *address = nullptr;
+		u32 range = task->length;
 
-		switch (m_current_job->type)
+		switch (task->type)
 		{
 		case raw_copy:
-			address = (writing) ? m_current_job->dst : m_current_job->src;
+			address = (writing) ? task->dst : task->src;
 			break;
 		case vector_copy:
 			verify(HERE), writing;
-			address = m_current_job->dst;
+			address = task->dst;
 			break;
 		case index_emulate:
 			verify(HERE), writing;
-			address = m_current_job->dst;
-			range = get_index_count(static_cast<rsx::primitive_type>(m_current_job->aux_param0), m_current_job->length);
+			address = task->dst;
+			range = get_index_count(static_cast<rsx::primitive_type>(task->aux_param0), task->length);
 			break;
 		default:
 			ASSUME(0);
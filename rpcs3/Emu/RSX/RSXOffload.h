@@ -48,17 +48,61 @@ namespace rsx
 			{}
 		};
 
+		// Unit of work executed by the offloader threads (a whole packet, several coalesced copies or a part of a large copy)
+		struct transport_task
+		{
+			op type;
+			u8 *dst;
+			const u8 *src;
+			u32 length;
+			u32 aux_param0;
+		};
+
 		lf_queue<transport_packet> m_work_queue;
-		lf_queue_slice<transport_packet> m_current_job;
 		atomic_t<u64> m_enqueued_count{ 0 };
 		volatile u64 m_processed_count = 0;
-		thread_state m_worker_state = thread_state::detached;
-		std::thread::id m_thread_id;
+		atomic_t<thread_state> m_worker_state{ thread_state::detached };
 		atomic_t<bool> m_mem_fault_flag{ false };
 
+		// Tasks waiting for the next ordering fence (callback or end of the work queue)
+		std::vector<transport_task> m_pending_tasks;
+
+		// Current batch, shared with the helper threads
+		std::vector<transport_task> m_batch;
+		atomic_t<u32> m_batch_size{ 0 };
+		atomic_t<u32> m_batch_done{ 0 };
+		atomic_t<u64> m_batch_ctrl{ 0 }; // Batch id (high), next task index (low)
+		u32 m_helper_count = 0;
+		atomic_t<u32> m_helpers_running{ 0 };
+
+		// Statistics, reported on exit
+		u64 m_start_time = 0;
+		u64 m_busy_time = 0;
+		u64 m_bytes_copied = 0;
+		u64 m_packets_processed = 0;
+		u64 m_packets_coalesced = 0;
+		u64 m_chunks_split = 0;
+		u64 m_batches_run = 0;
+		u64 m_queue_depth_sum = 0;
+		u64 m_queue_depth_max = 0;
+		u64 m_enqueue_events = 0;
+
+		static thread_local bool s_is_offloader_thread;
+		static thread_local const transport_task* s_current_task;
+
 		// TODO: Improved benchmarks here; value determined by profiling on a Ryzen CPU, rounded to the nearest 512 bytes
 		const u32 max_immediate_transfer_size = 3584;
 
+		// Copies larger than twice this are split between the offloader threads
+		const u32 min_chunk_size = 64 * 1024;
+
+		void on_enqueue();
+		bool has_hazard(const transport_task& task) const;
+		void add_task(const transport_packet& packet);
+		void execute(const transport_task& task);
+		bool execute_next_batch_task();
+		void run_batch();
+
 	public:
 		dma_manager() = default;
 
@@ -12,6 +12,8 @@
 #include "Capture/rsx_capture.h"
 #include "rsx_methods.h"
 #include "rsx_utils.h"
+#include "rsx_write_tracker.h"
+#include "rsx_vertex_cache.h"
 #include "Emu/Cell/lv2/sys_event.h"
 #include "Emu/Cell/Modules/cellGcmSys.h"
 #include "Overlays/overlay_perf_metrics.h"
@@ -295,7 +297,16 @@ namespace rsx
 	{
 		g_access_violation_handler = [this](u32 address, bool is_writing)
 		{
-			return on_access_violation(address, is_writing);
+			// Cached vertex data pages are only write protected
+			const bool vertex_data = is_writing && vertex_cache::g_page_tracker.on_write(address);
+
+			if (!on_access_violation(address, is_writing) && !vertex_data)
+			{
+				return false;
+			}
+
+			g_write_tracker.on_fault();
+			return true;
 		};
 
 		m_rtts_dirty = true;
@@ -473,6 +484,14 @@ namespace rsx
 
 		rsx::overlays::reset_performance_overlay();
 
+		vertex_cache::g_page_tracker.reset();
+		vertex_cache::g_stats.hits.release(0);
+		vertex_cache::g_stats.misses.release(0);
+		vertex_cache::g_stats.bytes_saved.release(0);
+
+		g_write_tracker.start();
+		g_write_tracker.register_self_handling_thread();
+
 		g_dma_manager.init();
 		on_init_thread();
 
@@ -654,6 +673,9 @@ namespace rsx
 		std::this_thread::sleep_for(10ms);
 		do_local_task(rsx::FIFO_state::lock_wait);
 
+		// Release the memory write protected by userfaultfd
+		g_write_tracker.stop();
+
 		user_asked_for_frame_capture = false;
 		capture_current_frame = false;
 
@@ -2451,6 +2473,7 @@ namespace rsx
 			return;
 
 		on_invalidate_memory_range(m_invalidated_memory_range, rsx::invalidation_cause::unmap);
+		vertex_cache::g_page_tracker.on_unmap(m_invalidated_memory_range.to_page_range());
 		m_invalidated_memory_range.invalidate();
 	}
 
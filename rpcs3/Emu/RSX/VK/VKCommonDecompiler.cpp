@@ -1,5 +1,6 @@
 ﻿#include "stdafx.h"
 #include "VKCommonDecompiler.h"
+#include "VKHelpers.h"
 
 #ifdef _MSC_VER
 #pragma warning(push, 0)
@@ -191,6 +192,43 @@ namespace vk
 		return success;
 	}
 
+	void save_program_inputs(program_output_cache::writer& out, const std::vector<glsl::program_input>& inputs)
+	{
+		out.put<u32>(::size32(inputs));
+
+		for (const auto& input : inputs)
+		{
+			out.put(input.domain);
+			out.put(input.type);
+			out.put(input.location);
+			out.put(input.name);
+		}
+	}
+
+	bool load_program_inputs(program_output_cache::reader& in, std::vector<glsl::program_input>& inputs)
+	{
+		u32 count;
+
+		if (!in.get(count))
+		{
+			return false;
+		}
+
+		for (u32 i = 0; i < count; i++)
+		{
+			glsl::program_input input{};
+
+			if (!in.get(input.domain) || !in.get(input.type) || !in.get(input.location) || !in.get(input.name))
+			{
+				return false;
+			}
+
+			inputs.push_back(std::move(input));
+		}
+
+		return true;
+	}
+
 	void initialize_compiler_context()
 	{
 		glslang::InitializeProcess();
@@ -1,13 +1,23 @@
 #pragma once
 #include "../Common/GLSLTypes.h"
+#include "../Common/ProgramStateCache.h"
 
 namespace vk
 {
 	using namespace ::glsl;
 
+	namespace glsl
+	{
+		struct program_input;
+	}
+
 	int get_varying_register_location(std::string_view varying_register_name);
 	bool compile_glsl_to_spv(std::string& shader, program_domain domain, std::vector<u32> &spv);
 
+	// Decompiler output cache helpers (binding state of the inputs is not stored)
+	void save_program_inputs(program_output_cache::writer& out, const std::vector<glsl::program_input>& inputs);
+	bool load_program_inputs(program_output_cache::reader& in, std::vector<glsl::program_input>& inputs);
+
 	void initialize_compiler_context();
 	void finalize_compiler_context();
 }
@@ -2,6 +2,7 @@
 #include "VKHelpers.h"
 #include "VKResourceManager.h"
 #include "VKDMA.h"
+#include "../rsx_vertex_cache.h"
 
 namespace vk
 {
@@ -128,6 +129,8 @@ namespace vk
 		auto dst = vm::get_super_ptr(range.start);
 		std::memcpy(dst, src, range.length());
 
+		rsx::vertex_cache::g_page_tracker.on_sudo_write(range);
+
 		// TODO: Clear page bits
 		unmap();
 	}
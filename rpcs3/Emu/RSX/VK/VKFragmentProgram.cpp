@@ -376,20 +376,44 @@ VKFragmentProgram::~VKFragmentProgram()
 
 void VKFragmentProgram::Decompile(const RSXFragmentProgram& prog)
 {
-	u32 size;
-	std::string source;
-	VKFragmentDecompilerThread decompiler(source, parr, prog, size, *this);
-
 	const auto pdev = vk::get_current_renderer();
-	if (!g_cfg.video.disable_native_float16)
+	const bool native_half = !g_cfg.video.disable_native_float16 && pdev->get_shader_types_support().allow_float16;
+	const bool emulate_depth_compare = !pdev->get_formats_support().d24_unorm_s8;
+
+	// Output depends on the device properties and on the vendor specific shader properties
+	const u64 variant = u64{native_half} | u64{emulate_depth_compare} << 1 |
+		u64{g_cfg.video.antialiasing_level == msaa_level::none} << 2 |
+		u64{vk::get_driver_vendor() == vk::driver_vendor::NVIDIA} << 3 |
+		u64{pdev->get_pipeline_binding_table().vertex_textures_first_bind_slot} << 8;
+	const u64 key = program_output_cache::get_key(prog, variant);
+
+	if (std::vector<u8> data; program_output_cache::load(key, data))
 	{
-		decompiler.device_props.has_native_half_support = pdev->get_shader_types_support().allow_float16;
+		program_output_cache::reader in{data};
+		std::string source;
+		std::vector<u32> spv;
+
+		if (in.get(source) && in.get(spv) && vk::load_program_inputs(in, uniforms) &&
+			in.get(FragmentConstantOffsetCache) && in.get(output_color_masks) && in.end())
+		{
+			shader.create(::glsl::program_domain::glsl_fragment_program, source, std::move(spv));
+			return;
+		}
+
+		uniforms.clear();
+		FragmentConstantOffsetCache.clear();
+		output_color_masks = {};
 	}
 
-	decompiler.device_props.emulate_depth_compare = !pdev->get_formats_support().d24_unorm_s8;
+	u32 size;
+	std::string source;
+	VKFragmentDecompilerThread decompiler(source, parr, prog, size, *this);
+	decompiler.device_props.has_native_half_support = native_half;
+	decompiler.device_props.emulate_depth_compare = emulate_depth_compare;
 	decompiler.Task();
 
 	shader.create(::glsl::program_domain::glsl_fragment_program, source);
+	cache_key = key;
 
 	for (const ParamType& PT : decompiler.m_parr.params[PF_PARAM_UNIFORM])
 	{
@@ -412,6 +436,17 @@ void VKFragmentProgram::Compile()
 	if (g_cfg.video.log_programs)
 		fs::file(fs::get_cache_dir() + "shaderlog/FragmentProgram" + std::to_string(id) + ".spirv", fs::rewrite).write(shader.get_source());
 	handle = shader.compile();
+
+	if (cache_key)
+	{
+		program_output_cache::writer out;
+		out.put(shader.get_source());
+		out.put(shader.get_compiled());
+		vk::save_program_inputs(out, uniforms);
+		out.put(FragmentConstantOffsetCache);
+		out.put(output_color_masks);
+		program_output_cache::store(std::exchange(cache_key, 0), out.data);
+	}
 }
 
 void VKFragmentProgram::Delete()
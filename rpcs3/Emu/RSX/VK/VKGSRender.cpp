@@ -524,7 +524,7 @@ VKGSRender::VKGSRender() : GSRender()
 	if (g_cfg.video.disable_vertex_cache || g_cfg.video.multithreaded_rsx)
 		m_vertex_cache = std::make_unique<vk::null_vertex_cache>();
 	else
-		m_vertex_cache = std::make_unique<vk::weak_vertex_cache>();
+		m_vertex_cache = std::make_unique<vk::persistent_vertex_cache>();
 
 	m_shaders_cache = std::make_unique<vk::shader_cache>(*m_prog_buffer, "vulkan", "v1.91");
 
@@ -708,13 +708,13 @@ bool VKGSRender::on_access_violation(u32 address, bool is_writing)
 	{
 		if (rsx::g_dma_manager.is_current_thread())
 		{
-			// The offloader thread cannot handle flush requests
+			// The offloader threads cannot handle flush requests, wait for any other offloader thread to be recovered first
+			rsx::g_dma_manager.set_mem_fault_flag();
 			verify(HERE), m_queue_status.load() == flush_queue_state::ok;
 
 			m_offloader_fault_range = rsx::g_dma_manager.get_fault_range(is_writing);
 			m_offloader_fault_cause = (is_writing) ? rsx::invalidation_cause::write : rsx::invalidation_cause::read;
 
-			rsx::g_dma_manager.set_mem_fault_flag();
 			m_queue_status |= flush_queue_state::deadlock;
 
 			// Wait for deadlock to clear
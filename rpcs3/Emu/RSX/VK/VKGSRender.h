@@ -16,8 +16,8 @@
 
 namespace vk
 {
-	using vertex_cache = rsx::vertex_cache::default_vertex_cache<rsx::vertex_cache::uploaded_range<VkFormat>, VkFormat>;
-	using weak_vertex_cache = rsx::vertex_cache::weak_vertex_cache<VkFormat>;
+	using vertex_cache = rsx::vertex_cache::default_vertex_cache;
+	using persistent_vertex_cache = rsx::vertex_cache::persistent_vertex_cache;
 	using null_vertex_cache = vertex_cache;
 
 	using shader_cache = rsx::shaders_cache<vk::pipeline_props, VKProgramBuffer>;
@@ -208,6 +208,9 @@ namespace vk
 		s64 index_heap_ptr = 0;
 		s64 texture_upload_heap_ptr = 0;
 
+		// Oldest attrib heap position referenced by the vertex cache in this frame
+		u64 attrib_heap_hold = UINT64_MAX;
+
 		u64 last_frame_sync_time = 0;
 
 		//Copy shareable information
@@ -229,6 +232,7 @@ namespace vk
 			vtx_const_heap_ptr = other.vtx_const_heap_ptr;
 			index_heap_ptr = other.index_heap_ptr;
 			texture_upload_heap_ptr = other.texture_upload_heap_ptr;
+			attrib_heap_hold = other.attrib_heap_hold;
 		}
 
 		//Exchange storage (non-copyable)
@@ -3464,11 +3464,19 @@ public:
 				m_source = source;
 			}
 
+			// Reuse previously compiled SPIR-V (the source is only kept for logging)
+			void create(::glsl::program_domain domain, const std::string& source, std::vector<u32>&& compiled)
+			{
+				type = domain;
+				m_source = source;
+				m_compiled = std::move(compiled);
+			}
+
 			VkShaderModule compile()
 			{
 				verify(HERE), m_handle == VK_NULL_HANDLE;
 
-				if (!vk::compile_glsl_to_spv(m_source, type, m_compiled))
+				if (m_compiled.empty() && !vk::compile_glsl_to_spv(m_source, type, m_compiled))
 				{
 					std::string shader_type = type == ::glsl::program_domain::glsl_vertex_program ? "vertex" :
 						type == ::glsl::program_domain::glsl_fragment_program ? "fragment" : "compute";
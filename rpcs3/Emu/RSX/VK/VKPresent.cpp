@@ -113,7 +113,6 @@ void VKGSRender::advance_queued_frames()
 
 	vk::remove_unused_framebuffers();
 
-	m_vertex_cache->purge();
 	m_current_frame->tag_frame_end(m_attrib_ring_info.get_current_put_pos_minus_one(),
 		m_vertex_env_ring_info.get_current_put_pos_minus_one(),
 		m_fragment_env_ring_info.get_current_put_pos_minus_one(),
@@ -130,6 +129,7 @@ void VKGSRender::advance_queued_frames()
 	m_current_queue_index = (m_current_queue_index + 1) % VK_MAX_ASYNC_FRAMES;
 	m_current_frame = &frame_context_storage[m_current_queue_index];
 	m_current_frame->flags |= frame_context_state::dirty;
+	m_current_frame->attrib_heap_hold = UINT64_MAX;
 
 	vk::advance_frame_counter();
 }
@@ -216,12 +216,14 @@ void VKGSRender::frame_context_cleanup(vk::frame_context_t *ctx, bool free_resou
 		m_video_output_pass->free_resources();
 
 		ctx->buffer_views_to_clean.clear();
+		ctx->attrib_heap_hold = UINT64_MAX;
 
 		if (ctx->last_frame_sync_time > m_last_heap_sync_time)
 		{
 			m_last_heap_sync_time = ctx->last_frame_sync_time;
 
 			// Heap cleanup; deallocates memory consumed by the frame if it is still held
+			const u64 attrib_in_use = m_attrib_ring_info.get_min_heap_position(UINT64_MAX);
 			m_attrib_ring_info.m_get_pos = ctx->attrib_heap_ptr;
 			m_vertex_env_ring_info.m_get_pos = ctx->vtx_env_heap_ptr;
 			m_fragment_env_ring_info.m_get_pos = ctx->frag_env_heap_ptr;
@@ -232,6 +234,30 @@ void VKGSRender::frame_context_cleanup(vk::frame_context_t *ctx, bool free_resou
 			m_index_buffer_ring_info.m_get_pos = ctx->index_heap_ptr;
 			m_texture_upload_buffer_ring_info.m_get_pos = ctx->texture_upload_heap_ptr;
 
+			// Vertex data reused from older frames must be kept until the frames referencing it are done
+			u64 attrib_hold = UINT64_MAX;
+			bool in_flight = false;
+
+			for (const auto frame : m_queued_frames)
+			{
+				if (in_flight && frame->attrib_heap_hold >= attrib_in_use)
+				{
+					attrib_hold = std::min(attrib_hold, frame->attrib_heap_hold);
+				}
+
+				in_flight |= frame == ctx;
+			}
+
+			if (m_current_frame->attrib_heap_hold >= attrib_in_use)
+			{
+				attrib_hold = std::min(attrib_hold, m_current_frame->attrib_heap_hold);
+			}
+
+			if (attrib_hold < m_attrib_ring_info.get_min_heap_position(UINT64_MAX))
+			{
+				m_attrib_ring_info.hold(attrib_hold);
+			}
+
 			m_attrib_ring_info.notify();
 			m_vertex_env_ring_info.notify();
 			m_fragment_env_ring_info.notify();
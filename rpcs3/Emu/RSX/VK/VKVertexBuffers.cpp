@@ -246,23 +246,29 @@ vk::vertex_upload_info VKGSRender::upload_vertex_data()
 	{
 		//Check if cacheable
 		//Only data in the 'persistent' block may be cached
-		//TODO: make vertex cache keep local data beyond frame boundaries and hook notify command
 		bool in_cache = false;
 		bool to_store = false;
 		u32  storage_address = UINT32_MAX;
+		u32  storage_stride = 0;
 
 		if (m_vertex_layout.interleaved_blocks.size() == 1 &&
 			rsx::method_registers.current_draw_clause.command != rsx::draw_command::inlined_array)
 		{
-			const auto data_offset = (vertex_base * m_vertex_layout.interleaved_blocks[0].attribute_stride);
-			storage_address = m_vertex_layout.interleaved_blocks[0].real_offset_address + data_offset;
+			storage_stride = m_vertex_layout.interleaved_blocks[0].attribute_stride;
+			storage_address = m_vertex_layout.interleaved_blocks[0].real_offset_address + (vertex_base * storage_stride);
 
-			if (auto cached = m_vertex_cache->find_vertex_range(storage_address, VK_FORMAT_R8_UINT, required.first))
+			// Reuse data at most a quarter of the heap behind so holding it back doesn't starve the allocator
+			const u64 min_heap_position = m_attrib_ring_info.get_min_heap_position(m_attrib_ring_info.size() / 4);
+
+			if (auto cached = m_vertex_cache->find_vertex_range(storage_address, required.first, storage_stride, min_heap_position))
 			{
 				verify(HERE), cached->local_address == storage_address;
 
 				in_cache = true;
 				persistent_range_base = cached->offset_in_heap;
+
+				// Keep the data alive until this frame is done
+				m_current_frame->attrib_heap_hold = std::min(m_current_frame->attrib_heap_hold, cached->heap_position);
 			}
 			else
 			{
@@ -278,7 +284,8 @@ vk::vertex_upload_info VKGSRender::upload_vertex_data()
 			if (to_store)
 			{
 				//store ref in vertex cache
-				m_vertex_cache->store_range(storage_address, VK_FORMAT_R8_UINT, required.first, static_cast<u32>(persistent_offset));
+				m_vertex_cache->store_range(storage_address, required.first, storage_stride, static_cast<u32>(persistent_offset),
+					m_attrib_ring_info.get_heap_position(persistent_offset));
 			}
 		}
 	}
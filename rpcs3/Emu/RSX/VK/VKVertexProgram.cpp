@@ -325,11 +325,31 @@ VKVertexProgram::~VKVertexProgram()
 
 void VKVertexProgram::Decompile(const RSXVertexProgram& prog)
 {
+	const auto pdev = vk::get_current_renderer();
+	const u64 variant = u64{vk::emulate_conditional_rendering()} | u64{pdev->get_pipeline_binding_table().vertex_textures_first_bind_slot} << 8;
+	const u64 key = program_output_cache::get_key(prog, variant);
+
+	if (std::vector<u8> data; program_output_cache::load(key, data))
+	{
+		program_output_cache::reader in{data};
+		std::string source;
+		std::vector<u32> spv;
+
+		if (in.get(source) && in.get(spv) && vk::load_program_inputs(in, uniforms) && in.end())
+		{
+			shader.create(::glsl::program_domain::glsl_vertex_program, source, std::move(spv));
+			return;
+		}
+
+		uniforms.clear();
+	}
+
 	std::string source;
 	VKVertexDecompilerThread decompiler(prog, source, parr, *this);
 	decompiler.Task();
 
 	shader.create(::glsl::program_domain::glsl_vertex_program, source);
+	cache_key = key;
 }
 
 void VKVertexProgram::Compile()
@@ -337,6 +357,15 @@ void VKVertexProgram::Compile()
 	if (g_cfg.video.log_programs)
 		fs::file(fs::get_cache_dir() + "shaderlog/VertexProgram" + std::to_string(id) + ".spirv", fs::rewrite).write(shader.get_source());
 	handle = shader.compile();
+
+	if (cache_key)
+	{
+		program_output_cache::writer out;
+		out.put(shader.get_source());
+		out.put(shader.get_compiled());
+		vk::save_program_inputs(out, uniforms);
+		program_output_cache::store(std::exchange(cache_key, 0), out.data);
+	}
 }
 
 void VKVertexProgram::Delete()
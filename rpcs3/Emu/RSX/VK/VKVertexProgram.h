@@ -55,6 +55,9 @@ public:
 	VkShaderModule handle = nullptr;
 	u32 id;
 	vk::glsl::shader shader;
+
+	// Decompiler output cache key of the program, set if the output must be stored after compilation
+	u64 cache_key = 0;
 	std::vector<vk::glsl::program_input> uniforms;
 
 	void Decompile(const RSXVertexProgram& prog);
@@ -11,8 +11,11 @@
 #include "Overlays/Shaders/shader_loading_dialog.h"
 
 #include "rsx_utils.h"
+#include "rsx_vertex_cache.h"
 #include <thread>
 #include <chrono>
+#include <set>
+#include <unordered_set>
 
 namespace rsx
 {
@@ -35,7 +38,7 @@ namespace rsx
 		verify(HERE), range.is_page_range();
 
 		//rsx_log.error("memory_protect(0x%x, 0x%x, %x)", static_cast<u32>(range.start), static_cast<u32>(range.length()), static_cast<u32>(prot));
-		utils::memory_protect(vm::base(range.start), range.length(), prot);
+		vertex_cache::g_page_tracker.protect(range, prot);
 
 #ifdef TEXTURE_CACHE_DEBUG
 		tex_cache_checker.set_protection(range, prot);
@@ -353,6 +356,10 @@ namespace rsx
 
 			*first = range.start;
 			*last = range.end;
+
+			// Written through the sudo mapping
+			vertex_cache::g_page_tracker.on_sudo_write(address_range::start_length(range.start, 4));
+			vertex_cache::g_page_tracker.on_sudo_write(address_range::start_length(range.end - 3, 4));
 		}
 
 	public:
@@ -417,12 +424,40 @@ namespace rsx
 			pipeline_storage_type pipeline_properties;
 		};
 
+		// Packed pipeline archive record types
+		enum pack_record_type : u32
+		{
+			pack_vp = 1,
+			pack_fp = 2,
+			pack_pipeline = 3,
+		};
+
+		// Record keys: program hash (vp, fp) or pipeline key (vp, fp, storage and state hashes)
+		static constexpr u32 pack_magic = "RSXP"_u32;
+		static constexpr u32 pack_version = 1;
+
+		using pipeline_key = std::array<u64, 4>;
+
 		std::string version_prefix;
 		std::string root_path;
 		std::string pipeline_class_name;
 		std::mutex fpd_mutex;
 		std::unordered_map<u64, std::vector<u8>> fragment_program_data;
 
+		// Packed pipeline archive (append-only, compacted on load if necessary)
+		fs::file m_pack;
+		std::mutex m_pack_mutex;
+
+		// Archive contents (only kept while loading)
+		std::vector<u8> m_pack_data;
+
+		// Program records in the archive (hash -> record offset)
+		std::unordered_map<u64, u64> m_pack_vp;
+		std::unordered_map<u64, u64> m_pack_fp;
+
+		// Pipelines in the archive
+		std::set<pipeline_key> m_pack_pipelines;
+
 		backend_storage& m_storage;
 
 		std::string get_message(u32 index, u32 processed, u32 entry_count)
@@ -430,8 +465,7 @@ namespace rsx
 			return fmt::format("%s pipeline object %u of %u", index == 0 ? "Loading" : "Compiling", processed, entry_count);
 		};
 
-		void load_shaders(uint nb_workers, unpacked_type& unpacked, std::string& directory_path, std::vector<fs::dir_entry>& entries, u32 entry_count,
-		    shader_loading_dialog* dlg)
+		void load_shaders(uint nb_workers, unpacked_type& unpacked, const std::vector<u64>& entries, u32 entry_count, shader_loading_dialog* dlg)
 		{
 			atomic_t<u32> processed(0);
 
@@ -440,20 +474,10 @@ namespace rsx
 				u32 pos;
 				while (((pos = processed++) < stop_at) && !Emu.IsStopped())
 				{
-					fs::dir_entry tmp = entries[pos];
+					pipeline_data data;
+					std::memcpy(&data, m_pack_data.data() + entries[pos] + sizeof(pack_record), sizeof(pipeline_data));
 
-					const auto filename = directory_path + "/" + tmp.name;
-					std::vector<u8> bytes;
-					fs::file f(filename);
-					if (f.size() != sizeof(pipeline_data))
-					{
-						rsx_log.error("Removing cached pipeline object %s since it's not binary compatible with the current shader cache", tmp.name.c_str());
-						fs::remove_file(filename);
-						continue;
-					}
-					f.read<u8>(bytes, f.size());
-
-					auto entry = unpack(*reinterpret_cast<pipeline_data*>(bytes.data()));
+					auto entry = unpack(data);
 					m_storage.preload_programs(std::get<1>(entry), std::get<2>(entry));
 
 					unpacked[unpacked.push_begin()] = entry;
@@ -544,6 +568,289 @@ namespace rsx
 			}
 		}
 
+		static u64 get_state_hash(const pipeline_data& data)
+		{
+			u64 state_hash = 0;
+			state_hash ^= rpcs3::hash_base<u32>(data.vp_ctrl);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_ctrl);
+			state_hash ^= rpcs3::hash_base<u32>(data.vp_texture_dimensions);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_texture_dimensions);
+			state_hash ^= rpcs3::hash_base<u32>(data.fp_texcoord_control);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_unnormalized_coords);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_height);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_pixel_layout);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_lighting_flags);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_shadow_textures);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_redirected_textures);
+			state_hash ^= rpcs3::hash_base<u16>(data.fp_alphakill_mask);
+			state_hash ^= rpcs3::hash_base<u64>(data.fp_zfunc_mask);
+			return state_hash;
+		}
+
+		static pipeline_key get_pipeline_key(const pipeline_data& data)
+		{
+			return {data.vertex_program_hash, data.fragment_program_hash, data.pipeline_storage_hash, get_state_hash(data)};
+		}
+
+		pack_record get_pack_record(u64 pos) const
+		{
+			pack_record rec;
+			std::memcpy(&rec, m_pack_data.data() + pos, sizeof(pack_record));
+			return rec;
+		}
+
+		// Open the archive (reset if it's incompatible)
+		bool open_pack(const std::string& path)
+		{
+			m_pack.open(path, fs::read + fs::write + fs::create + fs::append);
+
+			if (!m_pack)
+			{
+				rsx_log.error("shaders_cache: failed to open %s (%s)", path, fs::g_tls_error);
+				return false;
+			}
+
+			pack_header header{};
+
+			if (m_pack.size() < sizeof(pack_header) || (m_pack.seek(0), m_pack.read(&header, sizeof(pack_header)) != sizeof(pack_header)) ||
+				header.magic != pack_magic || header.version != pack_version)
+			{
+				if (m_pack.size())
+				{
+					rsx_log.error("shaders_cache: resetting pipeline archive %s since it's not compatible with the current shader cache", path);
+				}
+
+				header.magic = pack_magic;
+				header.version = pack_version;
+				m_pack.trunc(0);
+				m_pack.write(&header, sizeof(pack_header));
+			}
+
+			return true;
+		}
+
+		// Append record to the archive, returns its offset
+		u64 append_pack(u32 type, const pipeline_key& key, const void* data, u32 size)
+		{
+			pack_record rec{};
+			rec.type = type;
+			rec.size = size;
+
+			for (u32 i = 0; i < 4; i++)
+			{
+				rec.key[i] = key[i];
+			}
+
+			std::vector<u8> buf(sizeof(pack_record) + size);
+			std::memcpy(buf.data(), &rec, sizeof(pack_record));
+			std::memcpy(buf.data() + sizeof(pack_record), data, size);
+
+			const u64 pos = m_pack.size();
+
+			if (m_pack.write(buf.data(), buf.size()) != buf.size())
+			{
+				rsx_log.error("shaders_cache: failed to write pipeline archive (%s)", fs::g_tls_error);
+			}
+
+			return pos;
+		}
+
+		// Build the archive index, returns offsets of valid pipeline records
+		std::vector<u64> scan_pack(u64& wasted)
+		{
+			std::vector<u64> result;
+
+			m_pack_vp.clear();
+			m_pack_fp.clear();
+			m_pack_pipelines.clear();
+			wasted = 0;
+
+			u64 pos = sizeof(pack_header);
+
+			while (pos + sizeof(pack_record) <= m_pack_data.size())
+			{
+				const pack_record rec = get_pack_record(pos);
+				const u64 next = pos + sizeof(pack_record) + rec.size;
+
+				if (next > m_pack_data.size())
+				{
+					break;
+				}
+
+				switch (rec.type)
+				{
+				case pack_vp:
+				{
+					wasted += !m_pack_vp.emplace(rec.key[0], pos).second;
+					break;
+				}
+				case pack_fp:
+				{
+					wasted += !m_pack_fp.emplace(rec.key[0], pos).second;
+					break;
+				}
+				case pack_pipeline:
+				{
+					if (rec.size == sizeof(pipeline_data) && m_pack_pipelines.emplace(pipeline_key{rec.key[0], rec.key[1], rec.key[2], rec.key[3]}).second)
+					{
+						result.push_back(pos);
+					}
+					else
+					{
+						wasted++;
+					}
+
+					break;
+				}
+				default:
+				{
+					wasted++;
+					break;
+				}
+				}
+
+				pos = next;
+			}
+
+			if (pos < m_pack_data.size())
+			{
+				// Drop incomplete record
+				rsx_log.warning("shaders_cache: pipeline archive is truncated (0x%llx of 0x%llx bytes)", pos, m_pack_data.size());
+				m_pack_data.resize(pos);
+				m_pack.trunc(pos);
+			}
+
+			// Drop pipelines referencing missing programs
+			result.erase(std::remove_if(result.begin(), result.end(), [&](u64 pos)
+			{
+				const pack_record rec = get_pack_record(pos);
+
+				if (m_pack_vp.count(rec.key[0]) && m_pack_fp.count(rec.key[1]))
+				{
+					return false;
+				}
+
+				m_pack_pipelines.erase(pipeline_key{rec.key[0], rec.key[1], rec.key[2], rec.key[3]});
+				wasted++;
+				return true;
+			}), result.end());
+
+			return result;
+		}
+
+		// Rewrite the archive with only the records used by the pipelines
+		void compact_pack(const std::string& path, std::vector<u64>& entries, u64& wasted)
+		{
+			std::vector<u8> data(m_pack_data.begin(), m_pack_data.begin() + sizeof(pack_header));
+			std::unordered_set<u64> copied;
+
+			const auto copy = [&](u64 pos)
+			{
+				if (copied.emplace(pos).second)
+				{
+					data.insert(data.end(), m_pack_data.begin() + pos, m_pack_data.begin() + pos + sizeof(pack_record) + get_pack_record(pos).size);
+				}
+			};
+
+			for (u64 pos : entries)
+			{
+				const pack_record rec = get_pack_record(pos);
+				copy(m_pack_vp.at(rec.key[0]));
+				copy(m_pack_fp.at(rec.key[1]));
+				copy(pos);
+			}
+
+			rsx_log.notice("shaders_cache: compacting pipeline archive (%u wasted records, 0x%llx -> 0x%llx bytes)", wasted, m_pack_data.size(), data.size());
+
+			m_pack.close();
+
+			if (!fs::write_file(path + ".tmp", fs::rewrite, data) || !fs::rename(path + ".tmp", path, true))
+			{
+				rsx_log.error("shaders_cache: failed to compact %s (%s)", path, fs::g_tls_error);
+			}
+			else
+			{
+				m_pack_data = std::move(data);
+			}
+
+			if (open_pack(path))
+			{
+				entries = scan_pack(wasted);
+			}
+			else
+			{
+				entries.clear();
+			}
+		}
+
+		// Move pipelines from the loose file layout into the archive, returns number of imported pipelines
+		u32 import_loose(const std::string& directory_path)
+		{
+			std::vector<std::string> names;
+
+			for (auto&& entry : fs::dir(directory_path))
+			{
+				if (!entry.is_directory && entry.name.size() > 4 && entry.name.compare(entry.name.size() - 4, 4, ".bin") == 0)
+				{
+					names.emplace_back(std::move(entry.name));
+				}
+			}
+
+			u32 count = 0;
+
+			for (const auto& name : names)
+			{
+				const std::string filename = directory_path + "/" + name;
+				pipeline_data data;
+
+				if (fs::file f{filename}; f && f.size() == sizeof(pipeline_data) && f.read(&data, sizeof(pipeline_data)) == sizeof(pipeline_data))
+				{
+					const fs::file vp(root_path + "/raw/" + fmt::format("%llX.vp", data.vertex_program_hash));
+					const fs::file fp(root_path + "/raw/" + fmt::format("%llX.fp", data.fragment_program_hash));
+
+					if (vp && fp)
+					{
+						const pipeline_key key = get_pipeline_key(data);
+
+						if (!m_pack_vp.count(key[0]))
+						{
+							const auto bytes = vp.to_vector<u8>();
+							m_pack_vp.emplace(key[0], append_pack(pack_vp, {key[0]}, bytes.data(), ::size32(bytes)));
+						}
+
+						if (!m_pack_fp.count(key[1]))
+						{
+							const auto bytes = fp.to_vector<u8>();
+							m_pack_fp.emplace(key[1], append_pack(pack_fp, {key[1]}, bytes.data(), ::size32(bytes)));
+						}
+
+						if (m_pack_pipelines.emplace(key).second)
+						{
+							append_pack(pack_pipeline, key, &data, sizeof(pipeline_data));
+							count++;
+						}
+					}
+				}
+				else
+				{
+					rsx_log.error("Removing cached pipeline object %s since it's not binary compatible with the current shader cache", name);
+				}
+
+				fs::remove_file(filename);
+			}
+
+			// Raw programs are left in place since they may be shared with other pipeline classes
+			fs::remove_dir(directory_path);
+			return count;
+		}
+
+		// Get program data from the archive
+		std::pair<const u8*, u32> get_pack_blob(const std::unordered_map<u64, u64>& map, u64 program_hash) const
+		{
+			const u64 pos = map.at(program_hash);
+			return {m_pack_data.data() + pos + sizeof(pack_record), get_pack_record(pos).size};
+		}
+
 	public:
 
 		shaders_cache(backend_storage& storage, std::string pipeline_class, std::string version_prefix_str = "v1")
@@ -555,6 +862,8 @@ namespace rsx
 			{
 				root_path = Emu.PPUCache() + "shaders_cache";
 			}
+
+			program_output_cache::init(root_path.empty() ? "" : root_path + "/decompiled/" + pipeline_class_name + ".pack");
 		}
 
 		template <typename... Args>
@@ -565,34 +874,51 @@ namespace rsx
 				return;
 			}
 
-			std::string directory_path = root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix;
+			const std::string directory_path = root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix;
+			const std::string pack_path = directory_path + ".pack";
+
+			fs::create_path(root_path + "/pipelines/" + pipeline_class_name);
+
+			std::vector<u64> entries;
 
-			if (!fs::is_dir(directory_path))
 			{
-				fs::create_path(directory_path);
-				fs::create_path(root_path + "/raw");
+				std::lock_guard lock(m_pack_mutex);
 
-				return;
-			}
+				if (!open_pack(pack_path))
+				{
+					return;
+				}
 
-			fs::dir root = fs::dir(directory_path);
+				// Read the whole archive at once
+				m_pack_data = m_pack.to_vector<u8>();
 
-			u32 entry_count = 0;
-			std::vector<fs::dir_entry> entries;
-			for (auto It = root.begin(); It != root.end(); ++It, entry_count++)
-			{
-				fs::dir_entry tmp = *It;
+				u64 wasted = 0;
+				entries = scan_pack(wasted);
+
+				if (fs::is_dir(directory_path))
+				{
+					if (const u32 count = import_loose(directory_path))
+					{
+						rsx_log.notice("shaders_cache: imported %u pipeline objects into %s", count, pack_path);
+					}
 
-				if (tmp.name == "." || tmp.name == "..")
-					continue;
+					m_pack_data = m_pack.to_vector<u8>();
+					entries = scan_pack(wasted);
+				}
 
-				entries.push_back(tmp);
+				if (wasted && wasted * 4 >= entries.size())
+				{
+					compact_pack(pack_path, entries, wasted);
+				}
 			}
 
-			if ((entry_count = ::size32(entries)) <= 2)
-				return;
+			u32 entry_count = ::size32(entries);
 
-			root.rewind();
+			if (!entry_count)
+			{
+				m_pack_data = {};
+				return;
+			}
 
 			// Progress dialog
 			std::unique_ptr<shader_loading_dialog> fallback_dlg;
@@ -608,16 +934,20 @@ namespace rsx
 			dlg->update_msg(0, get_message(0, 0, entry_count));
 			dlg->update_msg(1, get_message(1, 0, entry_count));
 
-			// Preload everything needed to compile the shaders
+			// Preload everything needed to compile the shaders (decoding and decompilation run on all cores)
 			unpacked_type unpacked;
-			uint nb_workers = g_cfg.video.renderer == video_renderer::vulkan ? std::thread::hardware_concurrency() : 1;
+			const uint nb_workers = std::max(std::thread::hardware_concurrency(), 1u);
+
+			load_shaders(nb_workers, unpacked, entries, entry_count, dlg);
 
-			load_shaders(nb_workers, unpacked, directory_path, entries, entry_count, dlg);
+			// Release the archive contents
+			m_pack_data = {};
 
 			// Account for any invalid entries
 			entry_count = unpacked.size();
 
-			compile_shaders(nb_workers, unpacked, entry_count, dlg, std::forward<Args>(args)...);
+			// Only Vulkan can build pipelines from multiple threads, others need the thread owning the context
+			compile_shaders(g_cfg.video.renderer == video_renderer::vulkan ? nb_workers : 1, unpacked, entry_count, dlg, std::forward<Args>(args)...);
 
 			dlg->refresh();
 			dlg->close();
@@ -637,46 +967,34 @@ namespace rsx
 			}
 
 			pipeline_data data = pack(pipeline, vp, fp);
-			std::string fp_name = root_path + "/raw/" + fmt::format("%llX.fp", data.fragment_program_hash);
-			std::string vp_name = root_path + "/raw/" + fmt::format("%llX.vp", data.vertex_program_hash);
+			const pipeline_key key = get_pipeline_key(data);
 
-			if (!fs::is_file(fp_name))
+			std::lock_guard lock(m_pack_mutex);
+
+			if (!m_pack || !m_pack_pipelines.emplace(key).second)
 			{
-				fs::file(fp_name, fs::rewrite).write(fp.addr, fp.ucode_length);
+				return;
 			}
 
-			if (!fs::is_file(vp_name))
+			if (!m_pack_vp.count(key[0]))
 			{
-				fs::file(vp_name, fs::rewrite).write<u32>(vp.data);
+				m_pack_vp.emplace(key[0], append_pack(pack_vp, {key[0]}, vp.data.data(), ::size32(vp.data) * sizeof(u32)));
 			}
 
-			u64 state_hash = 0;
-			state_hash ^= rpcs3::hash_base<u32>(data.vp_ctrl);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_ctrl);
-			state_hash ^= rpcs3::hash_base<u32>(data.vp_texture_dimensions);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_texture_dimensions);
-			state_hash ^= rpcs3::hash_base<u32>(data.fp_texcoord_control);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_unnormalized_coords);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_height);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_pixel_layout);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_lighting_flags);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_shadow_textures);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_redirected_textures);
-			state_hash ^= rpcs3::hash_base<u16>(data.fp_alphakill_mask);
-			state_hash ^= rpcs3::hash_base<u64>(data.fp_zfunc_mask);
+			if (!m_pack_fp.count(key[1]))
+			{
+				m_pack_fp.emplace(key[1], append_pack(pack_fp, {key[1]}, fp.addr, fp.ucode_length));
+			}
 
-			std::string pipeline_file_name = fmt::format("%llX+%llX+%llX+%llX.bin", data.vertex_program_hash, data.fragment_program_hash, data.pipeline_storage_hash, state_hash);
-			std::string pipeline_path = root_path + "/pipelines/" + pipeline_class_name + "/" + version_prefix + "/" + pipeline_file_name;
-			fs::file(pipeline_path, fs::rewrite).write(&data, sizeof(pipeline_data));
+			append_pack(pack_pipeline, key, &data, sizeof(pipeline_data));
 		}
 
 		RSXVertexProgram load_vp_raw(u64 program_hash)
 		{
-			std::vector<u32> data;
-			std::string filename = fmt::format("%llX.vp", program_hash);
+			const auto [ptr, size] = get_pack_blob(m_pack_vp, program_hash);
 
-			fs::file f(root_path + "/raw/" + filename);
-			f.read<u32>(data, f.size() / sizeof(u32));
+			std::vector<u32> data(size / sizeof(u32));
+			std::memcpy(data.data(), ptr, data.size() * sizeof(u32));
 
 			RSXVertexProgram vp = {};
 			vp.data = data;
@@ -687,11 +1005,9 @@ namespace rsx
 
 		RSXFragmentProgram load_fp_raw(u64 program_hash)
 		{
-			std::vector<u8> data;
-			std::string filename = fmt::format("%llX.fp", program_hash);
+			const auto [ptr, size] = get_pack_blob(m_pack_fp, program_hash);
 
-			fs::file f(root_path + "/raw/" + filename);
-			f.read<u8>(data, f.size());
+			std::vector<u8> data(ptr, ptr + size);
 
 			RSXFragmentProgram fp = {};
 			{
@@ -796,71 +1112,4 @@ namespace rsx
 			return data_block;
 		}
 	};
-
-	namespace vertex_cache
-	{
-		// A null vertex cache
-		template <typename storage_type, typename upload_format>
-		class default_vertex_cache
-		{
-		public:
-			virtual ~default_vertex_cache() = default;
-			virtual storage_type* find_vertex_range(uintptr_t /*local_addr*/, upload_format, u32 /*data_length*/) { return nullptr; }
-			virtual void store_range(uintptr_t /*local_addr*/, upload_format, u32 /*data_length*/, u32 /*offset_in_heap*/) {}
-			virtual void purge() {}
-		};
-
-		// A weak vertex cache with no data checks or memory range locks
-		// Of limited use since contents are only guaranteed to be valid once per frame
-		// TODO: Strict vertex cache with range locks
-		template <typename upload_format>
-		struct uploaded_range
-		{
-			uintptr_t local_address;
-			upload_format buffer_format;
-			u32 offset_in_heap;
-			u32 data_length;
-		};
-
-		template <typename upload_format>
-		class weak_vertex_cache : public default_vertex_cache<uploaded_range<upload_format>, upload_format>
-		{
-			using storage_type = uploaded_range<upload_format>;
-
-		private:
-			std::unordered_map<uintptr_t, std::vector<storage_type>> vertex_ranges;
-
-		public:
-
-			storage_type* find_vertex_range(uintptr_t local_addr, upload_format fmt, u32 data_length) override
-			{
-				const auto data_end = local_addr + data_length;
-
-				for (auto &v : vertex_ranges[local_addr])
-				{
-					// NOTE: This has to match exactly. Using sized shortcuts such as >= comparison causes artifacting in some applications (UC1)
-					if (v.buffer_format == fmt && v.data_length == data_length)
-						return &v;
-				}
-
-				return nullptr;
-			}
-
-			void store_range(uintptr_t local_addr, upload_format fmt, u32 data_length, u32 offset_in_heap) override
-			{
-				storage_type v = {};
-				v.buffer_format = fmt;
-				v.data_length = data_length;
-				v.local_address = local_addr;
-				v.offset_in_heap = offset_in_heap;
-
-				vertex_ranges[local_addr].push_back(v);
-			}
-
-			void purge() override
-			{
-				vertex_ranges.clear();
-			}
-		};
-	}
 }
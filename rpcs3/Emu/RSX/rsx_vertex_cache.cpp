@@ -0,0 +1,335 @@
+#include "stdafx.h"
+#include "rsx_vertex_cache.h"
+#include "rsx_write_tracker.h"
+#include "Emu/Memory/vm.h"
+
+namespace rsx
+{
+	namespace vertex_cache
+	{
+		// Page state flag (the other bits hold the texture cache protection)
+		constexpr u8 page_vertex_data = 0x80;
+
+		page_tracker g_page_tracker;
+		cache_stats g_stats;
+
+		void page_tracker::apply(u32 first_page, u32 count, utils::protection prot)
+		{
+			const auto range = address_range::start_length(first_page * 4096, count * 4096);
+
+			if (!g_write_tracker.protect(range, prot))
+			{
+				utils::memory_protect(vm::base(range.start), range.length(), prot);
+			}
+		}
+
+		void page_tracker::enable()
+		{
+			std::lock_guard lock(m_mutex);
+
+			if (!m_state)
+			{
+				m_state = std::make_unique<u8[]>(page_count);
+				m_write_tick = std::make_unique<atomic_t<u32>[]>(page_count);
+				m_tick = 0;
+			}
+		}
+
+		void page_tracker::disable()
+		{
+			std::lock_guard lock(m_mutex);
+
+			if (!m_state)
+			{
+				return;
+			}
+
+			// Release the pages only protected for vertex data
+			for (u32 page = 0; page < page_count; page++)
+			{
+				if (m_state[page] == (page_vertex_data | static_cast<u8>(utils::protection::rw)))
+				{
+					apply(page, 1, utils::protection::rw);
+				}
+			}
+
+			m_state.reset();
+			m_write_tick.reset();
+		}
+
+		void page_tracker::protect(const address_range& range, utils::protection prot)
+		{
+			std::lock_guard lock(m_mutex);
+
+			if (!m_state)
+			{
+				apply(range.start / 4096, range.length() / 4096, prot);
+				return;
+			}
+
+			u32 tick = 0;
+
+			for (u32 page = range.start / 4096; page <= range.end / 4096; page++)
+			{
+				u8 state = static_cast<u8>(prot);
+
+				if (m_state[page] & page_vertex_data)
+				{
+					if (prot == utils::protection::rw)
+					{
+						// The texture cache is about to write to (or stopped watching) the page
+						if (!tick)
+						{
+							tick = ++m_tick;
+						}
+
+						m_write_tick[page].release(tick);
+					}
+					else
+					{
+						state |= page_vertex_data;
+					}
+				}
+
+				m_state[page] = state;
+			}
+
+			apply(range.start / 4096, range.length() / 4096, prot);
+		}
+
+		u32 page_tracker::watch(const address_range& range)
+		{
+			std::lock_guard lock(m_mutex);
+
+			const u32 tick = ++m_tick;
+			const u32 last = range.end / 4096;
+
+			// First page of the current run of pages to protect
+			u32 run = UINT32_MAX;
+
+			for (u32 page = range.start / 4096; page <= last; page++)
+			{
+				const u8 state = m_state[page];
+				m_state[page] = state | page_vertex_data;
+
+				// Only unprotected pages need to be write protected
+				if (state == static_cast<u8>(utils::protection::rw))
+				{
+					if (run == UINT32_MAX)
+					{
+						run = page;
+					}
+				}
+				else if (run != UINT32_MAX)
+				{
+					apply(run, page - run, utils::protection::ro);
+					run = UINT32_MAX;
+				}
+			}
+
+			if (run != UINT32_MAX)
+			{
+				apply(run, last + 1 - run, utils::protection::ro);
+			}
+
+			return tick;
+		}
+
+		bool page_tracker::is_unchanged(const address_range& range, u32 tick) const
+		{
+			for (u32 page = range.start / 4096; page <= range.end / 4096; page++)
+			{
+				if (m_write_tick[page] >= tick)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		bool page_tracker::on_write(u32 address)
+		{
+			const u32 page = address / 4096;
+
+			std::lock_guard lock(m_mutex);
+
+			if (!m_state || !(m_state[page] & page_vertex_data))
+			{
+				return false;
+			}
+
+			const u8 state = m_state[page];
+
+			m_write_tick[page].release(++m_tick);
+			m_state[page] = state & ~page_vertex_data;
+
+			if (state == (page_vertex_data | static_cast<u8>(utils::protection::rw)))
+			{
+				// Otherwise the page is still protected by the texture cache
+				apply(page, 1, utils::protection::rw);
+			}
+
+			return true;
+		}
+
+		void page_tracker::on_sudo_write(const address_range& range)
+		{
+			const u32 first = range.start / 4096;
+			const u32 last = range.end / 4096;
+
+			const auto holds_vertex_data = [&]()
+			{
+				for (u32 page = first; page <= last; page++)
+				{
+					if (m_state[page] & page_vertex_data)
+					{
+						return true;
+					}
+				}
+
+				return false;
+			};
+
+			{
+				reader_lock lock(m_mutex);
+
+				if (!m_state || !holds_vertex_data())
+				{
+					return;
+				}
+			}
+
+			std::lock_guard lock(m_mutex);
+
+			if (!m_state)
+			{
+				return;
+			}
+
+			const u32 tick = ++m_tick;
+
+			// The pages stay protected, the next guest write releases them
+			for (u32 page = first; page <= last; page++)
+			{
+				if (m_state[page] & page_vertex_data)
+				{
+					m_write_tick[page].release(tick);
+				}
+			}
+		}
+
+		void page_tracker::on_unmap(const address_range& range)
+		{
+			std::lock_guard lock(m_mutex);
+
+			if (!m_state)
+			{
+				return;
+			}
+
+			u32 tick = 0;
+
+			for (u32 page = range.start / 4096; page <= range.end / 4096; page++)
+			{
+				if (m_state[page] & page_vertex_data)
+				{
+					if (!tick)
+					{
+						tick = ++m_tick;
+					}
+
+					m_write_tick[page].release(tick);
+				}
+
+				m_state[page] = 0;
+			}
+		}
+
+		void page_tracker::reset()
+		{
+			std::lock_guard lock(m_mutex);
+
+			if (!m_state)
+			{
+				return;
+			}
+
+			std::memset(m_state.get(), 0, page_count);
+
+			for (u32 page = 0; page < page_count; page++)
+			{
+				m_write_tick[page].release(0);
+			}
+
+			m_tick = 0;
+		}
+
+		persistent_vertex_cache::persistent_vertex_cache()
+		{
+			g_page_tracker.enable();
+		}
+
+		persistent_vertex_cache::~persistent_vertex_cache()
+		{
+			g_page_tracker.disable();
+		}
+
+		const uploaded_range* persistent_vertex_cache::find_vertex_range(u32 local_addr, u32 data_length, u32 stride, u64 min_heap_position)
+		{
+			const auto found = m_ranges.find(u64{local_addr} | u64{data_length} << 32);
+
+			if (found != m_ranges.end())
+			{
+				auto& v = found->second;
+
+				// NOTE: This has to match exactly. Using sized shortcuts such as >= comparison causes artifacting in some applications (UC1)
+				if (v.tick && v.stride == stride && v.heap_position >= min_heap_position)
+				{
+					if (g_page_tracker.is_unchanged(address_range::start_length(local_addr, data_length), v.tick))
+					{
+						g_stats.hits++;
+						g_stats.bytes_saved += data_length;
+						return &v;
+					}
+
+					v.writes++;
+					v.tick = 0;
+				}
+			}
+
+			g_stats.misses++;
+			return nullptr;
+		}
+
+		void persistent_vertex_cache::store_range(u32 local_addr, u32 data_length, u32 stride, u32 offset_in_heap, u64 heap_position)
+		{
+			if (m_ranges.size() >= max_entries)
+			{
+				m_ranges.clear();
+			}
+
+			auto& v = m_ranges[u64{local_addr} | u64{data_length} << 32];
+
+			if (v.writes >= max_writes)
+			{
+				// Frequently written, not worth the write faults
+				return;
+			}
+
+			v.local_address = local_addr;
+			v.data_length = data_length;
+			v.stride = stride;
+			v.offset_in_heap = offset_in_heap;
+			v.heap_position = heap_position;
+
+			// Protect before the caller copies the data so no write in between is missed
+			v.tick = g_page_tracker.watch(address_range::start_length(local_addr, data_length));
+		}
+
+		void persistent_vertex_cache::purge()
+		{
+			m_ranges.clear();
+		}
+	}
+}
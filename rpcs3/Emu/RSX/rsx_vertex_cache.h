@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Utilities/types.h"
+#include "Utilities/mutex.h"
+#include "util/atomic.hpp"
+#include "Utilities/VirtualMemory.h"
+#include "Utilities/address_range.h"
+
+#include <memory>
+#include <unordered_map>
+
+namespace rsx
+{
+	using utils::address_range;
+
+	namespace vertex_cache
+	{
+		// Page protection shared by the texture cache and the vertex cache.
+		// The protection requested by the texture cache is recorded per page so that vertex data can be write protected
+		// without weakening it. Vertex data pages lose their protection once written or unprotected by the texture cache.
+		class page_tracker
+		{
+			static constexpr u32 page_count = 0x100000;
+
+			// Texture cache protection (utils::protection) and vertex data flag (only allocated while the vertex cache is used)
+			std::unique_ptr<u8[]> m_state;
+
+			// Tick of the last write to a page holding vertex data
+			std::unique_ptr<atomic_t<u32>[]> m_write_tick;
+
+			u32 m_tick = 0;
+
+			shared_mutex m_mutex;
+
+			void apply(u32 first_page, u32 count, utils::protection prot);
+
+		public:
+			// Allocate the page state, must be called before any texture cache protection is applied
+			void enable();
+
+			// Free the page state, the texture cache protection is then applied directly
+			void disable();
+
+			// Apply the texture cache protection to a page range
+			void protect(const address_range& range, utils::protection prot);
+
+			// Write protect the pages holding vertex data, returns the tick to validate it with
+			u32 watch(const address_range& range);
+
+			// Check that the pages haven't been written since the tick
+			bool is_unchanged(const address_range& range, u32 tick) const;
+
+			// Write fault handler, false if the page doesn't hold vertex data
+			bool on_write(u32 address);
+
+			// Invalidate vertex data written without faulting (through the sudo mapping), must be called after the write
+			void on_sudo_write(const address_range& range);
+
+			// Forget the state of unmapped pages (protection is not touched)
+			void on_unmap(const address_range& range);
+
+			void reset();
+		};
+
+		extern page_tracker g_page_tracker;
+
+		// Counters shown in the performance overlay
+		struct cache_stats
+		{
+			atomic_t<u64> hits{0};
+			atomic_t<u64> misses{0};
+			atomic_t<u64> bytes_saved{0};
+		};
+
+		extern cache_stats g_stats;
+
+		struct uploaded_range
+		{
+			u32 local_address;
+			u32 data_length;
+			u32 stride;
+			u32 offset_in_heap;
+			u64 heap_position; // Monotonic position of the upload in the backend heap
+			u32 tick;          // Page tracker tick (0 if the data is not valid)
+			u32 writes;        // Number of times the source memory was written
+		};
+
+		// A null vertex cache
+		class default_vertex_cache
+		{
+		public:
+			virtual ~default_vertex_cache() = default;
+			virtual const uploaded_range* find_vertex_range(u32 /*local_addr*/, u32 /*data_length*/, u32 /*stride*/, u64 /*min_heap_position*/) { return nullptr; }
+			// Must be called before the data is copied, writes during the upload then invalidate the entry
+			virtual void store_range(u32 /*local_addr*/, u32 /*data_length*/, u32 /*stride*/, u32 /*offset_in_heap*/, u64 /*heap_position*/) {}
+			virtual void purge() {}
+		};
+
+		// A vertex cache which keeps uploaded data beyond frame boundaries.
+		// Entries stay valid until the source memory is written (the pages are write protected) or the uploaded
+		// data falls behind min_heap_position, the oldest heap position the backend guarantees not to overwrite.
+		class persistent_vertex_cache : public default_vertex_cache
+		{
+			// Ranges written this many times are not cached anymore
+			static constexpr u32 max_writes = 4;
+
+			// Drop everything when the map grows larger than this
+			static constexpr size_t max_entries = 0x10000;
+
+			std::unordered_map<u64, uploaded_range> m_ranges;
+
+		public:
+			persistent_vertex_cache();
+			~persistent_vertex_cache() override;
+
+			const uploaded_range* find_vertex_range(u32 local_addr, u32 data_length, u32 stride, u64 min_heap_position) override;
+			void store_range(u32 local_addr, u32 data_length, u32 stride, u32 offset_in_heap, u64 heap_position) override;
+			void purge() override;
+		};
+	}
+}
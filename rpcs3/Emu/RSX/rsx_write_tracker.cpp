@@ -0,0 +1,371 @@
+#include "stdafx.h"
+#include "rsx_write_tracker.h"
+#include "Emu/Memory/vm.h"
+#include "Emu/System.h"
+#include "Utilities/Thread.h"
+
+#ifdef __linux__
+#include <linux/userfaultfd.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+
+// Write-protect faults on shared memory (Linux 5.19 headers)
+#ifdef UFFD_FEATURE_WP_HUGETLBFS_SHMEM
+#define RSX_UFFD_WP
+#endif
+#endif
+
+extern u64 get_system_time();
+
+namespace rsx
+{
+	extern std::function<bool(u32 addr, bool is_writing)> g_access_violation_handler;
+
+	write_tracker g_write_tracker;
+
+	static u32 get_thread_tid()
+	{
+#ifdef __linux__
+		return static_cast<u32>(::syscall(SYS_gettid));
+#else
+		return 0;
+#endif
+	}
+
+	write_tracker::write_tracker() = default;
+
+	write_tracker::~write_tracker()
+	{
+		stop();
+	}
+
+	void write_tracker::start()
+	{
+		stop();
+
+		for (auto& tid : m_self_handling_tids)
+		{
+			tid.release(0);
+		}
+
+		m_faults.release(0);
+		m_uffd_faults.release(0);
+		m_start_time = get_system_time();
+
+		if (!g_cfg.video.userfaultfd_write_tracking)
+		{
+			return;
+		}
+
+#ifdef RSX_UFFD_WP
+		// Try without kernel mode faults first (doesn't require vm.unprivileged_userfaultfd)
+		int fd = ::syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+
+		if (fd < 0)
+		{
+			fd = ::syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+		}
+
+		if (fd < 0)
+		{
+			rsx_log.error("Write tracking: userfaultfd is not available (errno=%d), using mprotect", errno);
+			return;
+		}
+
+		// Write-protect faults on shared memory are required (Linux 5.19)
+		uffdio_api api{};
+		api.api = UFFD_API;
+		api.features = UFFD_FEATURE_PAGEFAULT_FLAG_WP | UFFD_FEATURE_WP_HUGETLBFS_SHMEM | UFFD_FEATURE_THREAD_ID;
+
+		if (::ioctl(fd, UFFDIO_API, &api) != 0)
+		{
+			rsx_log.error("Write tracking: userfaultfd write-protect is not supported (errno=%d), using mprotect", errno);
+			::close(fd);
+			return;
+		}
+
+		m_registered.assign(0x100000 / 64, 0);
+		m_fd.release(fd);
+
+		m_thread = std::make_unique<named_thread<std::function<void()>>>("RSX Write Tracker", [this]
+		{
+			handle_faults();
+		});
+
+		rsx_log.notice("Write tracking: using userfaultfd");
+#else
+		rsx_log.error("Write tracking: userfaultfd write-protect is not supported on this platform, using mprotect");
+#endif
+	}
+
+	void write_tracker::stop()
+	{
+		if (!m_start_time)
+		{
+			return;
+		}
+
+		int fd;
+		{
+			std::lock_guard lock(m_mutex);
+			fd = m_fd.exchange(-1);
+
+#ifdef RSX_UFFD_WP
+			if (fd >= 0)
+			{
+				// Release all remaining write protection (wakes up the blocked threads) and registrations
+				unregister_pages(fd, 0, 0xfffff);
+			}
+#endif
+			m_registered.clear();
+		}
+
+		// Join the fault handler thread
+		m_thread.reset();
+
+#ifdef RSX_UFFD_WP
+		if (fd >= 0)
+		{
+			::close(fd);
+		}
+#endif
+
+		const u64 time = std::max<u64>(get_system_time() - m_start_time, 1);
+
+		rsx_log.notice("Write tracking (%s): %llu faults handled in %.3fs (%.1f/s), %llu userfaultfd faults",
+			fd >= 0 ? "userfaultfd" : "mprotect", m_faults.load(), time / 1000000., m_faults.load() * 1000000. / time, m_uffd_faults.load());
+
+		m_start_time = 0;
+	}
+
+	void write_tracker::register_self_handling_thread()
+	{
+#ifdef __linux__
+		const u32 tid = get_thread_tid();
+
+		for (auto& slot : m_self_handling_tids)
+		{
+			if (slot.compare_and_swap_test(0, tid))
+			{
+				return;
+			}
+		}
+
+		rsx_log.error("Write tracking: too many self-handling threads");
+#endif
+	}
+
+	void write_tracker::register_guest_thread()
+	{
+#ifdef __linux__
+		std::lock_guard lock(m_guest_mutex);
+		m_guest_tids.emplace(get_thread_tid());
+#endif
+	}
+
+	void write_tracker::unregister_guest_thread()
+	{
+#ifdef __linux__
+		std::lock_guard lock(m_guest_mutex);
+		m_guest_tids.erase(get_thread_tid());
+#endif
+	}
+
+	bool write_tracker::is_self_handling(u32 tid)
+	{
+		for (auto& slot : m_self_handling_tids)
+		{
+			if (slot == tid)
+			{
+				return true;
+			}
+		}
+
+		reader_lock lock(m_guest_mutex);
+		return m_guest_tids.count(tid) != 0;
+	}
+
+	void write_tracker::unregister_pages(int fd, u32 first, u32 last)
+	{
+#ifdef RSX_UFFD_WP
+		for (u32 page = first; page <= last;)
+		{
+			if (!(m_registered[page / 64] & (1ull << (page % 64))))
+			{
+				// Skip to the next word if there are no more registered pages in this one
+				page = m_registered[page / 64] >> (page % 64) ? page + 1 : (page / 64 + 1) * 64;
+				continue;
+			}
+
+			// Find a run of registered pages
+			u32 end = page;
+
+			while (end + 1 <= last && m_registered[(end + 1) / 64] & (1ull << ((end + 1) % 64)))
+			{
+				end++;
+			}
+
+			uffdio_range range{};
+			range.start = reinterpret_cast<u64>(vm::base(page * 4096));
+			range.len = u64{end - page + 1} * 4096;
+
+			// Remove write protection first (wakes up the threads waiting on these pages)
+			uffdio_writeprotect wp{};
+			wp.range = range;
+			::ioctl(fd, UFFDIO_WRITEPROTECT, &wp);
+
+			if (::ioctl(fd, UFFDIO_UNREGISTER, &range) != 0)
+			{
+				rsx_log.error("Write tracking: failed to unregister 0x%x..0x%x (errno=%d)", page * 4096, end * 4096 + 4095, errno);
+			}
+
+			for (u32 i = page; i <= end; i++)
+			{
+				m_registered[i / 64] &= ~(1ull << (i % 64));
+			}
+
+			page = end + 1;
+		}
+#endif
+	}
+
+	bool write_tracker::protect(const address_range& range, utils::protection prot)
+	{
+#ifdef RSX_UFFD_WP
+		if (m_fd < 0)
+		{
+			return false;
+		}
+
+		std::lock_guard lock(m_mutex);
+
+		const int fd = m_fd;
+
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		const u32 first = range.start / 4096;
+		const u32 last = range.end / 4096;
+
+		// Unregister the range if it's not write-protected anymore, memory protection is applied by the caller
+		unregister_pages(fd, first, last);
+
+		if (prot != utils::protection::ro)
+		{
+			return false;
+		}
+
+		uffdio_register reg{};
+		reg.range.start = reinterpret_cast<u64>(vm::base(first * 4096));
+		reg.range.len = u64{last - first + 1} * 4096;
+		reg.mode = UFFDIO_REGISTER_MODE_WP;
+
+		if (::ioctl(fd, UFFDIO_REGISTER, &reg) != 0)
+		{
+			return false;
+		}
+
+		for (u32 i = first; i <= last; i++)
+		{
+			m_registered[i / 64] |= 1ull << (i % 64);
+		}
+
+		uffdio_writeprotect wp{};
+		wp.range = reg.range;
+		wp.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+
+		if (::ioctl(fd, UFFDIO_WRITEPROTECT, &wp) != 0)
+		{
+			unregister_pages(fd, first, last);
+			return false;
+		}
+
+		// Undo protection::no if necessary (only after write protection is applied, so no write is missed)
+		utils::memory_protect(vm::base(range.start), range.length(), utils::protection::rw);
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void write_tracker::handle_faults()
+	{
+#ifdef RSX_UFFD_WP
+		const int fd = m_fd;
+
+		while (thread_ctrl::state() != thread_state::aborting)
+		{
+			pollfd pfd{fd, POLLIN, 0};
+
+			if (::poll(&pfd, 1, 100) <= 0)
+			{
+				continue;
+			}
+
+			uffd_msg msg;
+
+			if (::read(fd, &msg, sizeof(msg)) != sizeof(msg) || msg.event != UFFD_EVENT_PAGEFAULT || !(msg.arg.pagefault.flags & UFFD_PAGEFAULT_FLAG_WP))
+			{
+				continue;
+			}
+
+			m_uffd_faults++;
+
+			uffdio_writeprotect wp{};
+			wp.range.start = msg.arg.pagefault.address & -4096;
+			wp.range.len = 4096;
+
+			const u32 addr = static_cast<u32>(wp.range.start - reinterpret_cast<u64>(vm::g_base_addr));
+
+			if (is_self_handling(msg.arg.pagefault.feat.ptid))
+			{
+				std::lock_guard lock(m_mutex);
+
+				const u32 page = addr / 4096;
+
+				// The message may be stale, the page may have been unregistered (which also woke up the thread)
+				if (m_fd >= 0 && m_registered[page / 64] & (1ull << (page % 64)))
+				{
+					// Let the thread take the fault with mprotect so the handler runs on it
+					// (guest CPU threads must release the vm passive lock first, which is only possible on the thread itself)
+					utils::memory_protect(vm::base(addr), 4096, utils::protection::ro);
+					::ioctl(fd, UFFDIO_WRITEPROTECT, &wp);
+				}
+
+				continue;
+			}
+
+			bool handled = false;
+
+			try
+			{
+				if (const auto handler = g_access_violation_handler)
+				{
+					handled = handler(addr, true);
+				}
+			}
+			catch (const std::exception& e)
+			{
+				rsx_log.fatal("g_access_violation_handler(0x%x, 1): %s", addr, e.what());
+			}
+
+			if (handled)
+			{
+				// The page was unprotected by the handler (or protected again, the thread will fault again then)
+				::ioctl(fd, UFFDIO_WAKE, &wp.range);
+			}
+			else
+			{
+				// Not tracked anymore, remove write protection (also wakes up the thread)
+				::ioctl(fd, UFFDIO_WRITEPROTECT, &wp);
+			}
+		}
+#endif
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Utilities/types.h"
+#include "util/atomic.hpp"
+#include "Utilities/VirtualMemory.h"
+#include "Utilities/address_range.h"
+#include "Utilities/mutex.h"
+
+#include <memory>
+#include <functional>
+#include <vector>
+#include <unordered_set>
+
+template <class Context>
+class named_thread;
+
+namespace rsx
+{
+	using utils::address_range;
+
+	// Write tracking for the memory protected by the texture cache.
+	// Read-only protection can be implemented with userfaultfd write-protect (Linux only) instead of mprotect,
+	// the faults are then handled by a separate thread while the writing thread is blocked.
+	// Faults of guest CPU threads are still handled by the signal handler on the faulting thread.
+	class write_tracker
+	{
+		// userfaultfd descriptor (-1 if the backend is not active)
+		atomic_t<int> m_fd{-1};
+
+		// Threads which must handle their own faults (the fault handler may need to wait for them)
+		atomic_t<u32> m_self_handling_tids[16]{};
+
+		// Guest CPU threads, they may hold the vm passive lock while writing so their faults must go through the signal handler
+		shared_mutex m_guest_mutex;
+		std::unordered_set<u32> m_guest_tids;
+
+		// Pages registered with the userfaultfd (1 bit per page)
+		shared_mutex m_mutex;
+		std::vector<u64> m_registered;
+
+		std::unique_ptr<named_thread<std::function<void()>>> m_thread;
+
+		// Fault counters
+		atomic_t<u64> m_faults{0};
+		atomic_t<u64> m_uffd_faults{0};
+		u64 m_start_time = 0;
+
+		void handle_faults();
+
+		bool is_self_handling(u32 tid);
+
+		// Remove write protection and unregister the registered pages in [first, last] (m_mutex must be locked)
+		void unregister_pages(int fd, u32 first, u32 last);
+
+	public:
+		write_tracker();
+		~write_tracker();
+
+		// Start the backend selected in the config (falls back to mprotect if not available)
+		void start();
+
+		// Stop the backend and report the fault counters
+		void stop();
+
+		// Mark the current thread as one which must handle its own faults (RSX thread, offloader threads)
+		void register_self_handling_thread();
+
+		// Guest CPU thread entry and exit (faults of these threads are always handled by themselves)
+		void register_guest_thread();
+		void unregister_guest_thread();
+
+		// Apply the protection if it's implemented by the backend, false if it must be applied with mprotect
+		bool protect(const address_range& range, utils::protection prot);
+
+		// Count a fault handled by the texture cache
+		void on_fault()
+		{
+			m_faults++;
+		}
+
+		bool is_active() const
+		{
+			return m_fd >= 0;
+		}
+	};
+
+	extern write_tracker g_write_tracker;
+}
@@ -22,6 +22,7 @@
 
 #include "Loader/PSF.h"
 #include "Loader/ELF.h"
+#include "Loader/ISO.h"
 
 #include "Utilities/StrUtil.h"
 #include "Utilities/sysinfo.h"
@@ -736,6 +737,20 @@ bool Emulator::BootGame(const std::string& path, const std::string& title_id, bo
 
 	m_path_old = m_path;
 
+	if (iso_is_image(path))
+	{
+		// Mount disc image as a virtual device and boot from its root
+		const std::string iso_root = iso_mount(path);
+
+		if (iso_root.empty())
+		{
+			sys_log.error("Failed to mount disc image: %s", path);
+			return false;
+		}
+
+		return BootGame(iso_root, title_id, false, add_only, force_global_config);
+	}
+
 	if (direct && fs::exists(path))
 	{
 		m_path = path;
@@ -1094,6 +1109,13 @@ void Emulator::Load(const std::string& title_id, bool add_only, bool force_globa
 				std::vector<std::string> dir_queue;
 				dir_queue.emplace_back(m_path + '/');
 
+				// Precompiling the whole firmware: also process libraries of installed games (PPU cache is shared)
+				if (fs::is_dir(m_path + "/sys/external/") && fs::is_file(m_path + "/vsh/etc/version.txt"))
+				{
+					dir_queue.emplace_back(vfs::get("/dev_hdd0/game/"));
+					dir_queue.emplace_back(vfs::get("/dev_hdd0/disc/"));
+				}
+
 				std::vector<std::pair<std::string, u64>> file_queue;
 				file_queue.reserve(2000);
 
@@ -1251,6 +1273,17 @@ void Emulator::Load(const std::string& title_id, bool add_only, bool force_globa
 			if (auto node = games[m_title_id])
 			{
 				bdvd_dir = node.Scalar();
+
+				if (iso_is_image(bdvd_dir))
+				{
+					// Disc image location
+					bdvd_dir = iso_mount(bdvd_dir);
+
+					if (!bdvd_dir.empty())
+					{
+						bdvd_dir += '/';
+					}
+				}
 			}
 			else
 			{
@@ -1284,7 +1317,16 @@ void Emulator::Load(const std::string& title_id, bool add_only, bool force_globa
 			}
 
 			// Store /dev_bdvd/ location
-			games[m_title_id] = bdvd_dir;
+			if (bdvd_dir.compare(0, std::strlen(iso_bdvd_root), iso_bdvd_root) != 0)
+			{
+				games[m_title_id] = bdvd_dir;
+			}
+			else if (!games[m_title_id])
+			{
+				// Disc image path, only used to find the disc when booting patch data (the game list can't read disc images)
+				games[m_title_id] = iso_get_image_path();
+			}
+
 			YAML::Emitter out;
 			out << games;
 			fs::file(fs::get_config_dir() + "/games.yml", fs::rewrite).write(out.c_str(), out.size());
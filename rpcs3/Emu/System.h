@@ -402,6 +402,7 @@ struct cfg_root : cfg::node
 		cfg::_bool thread_scheduler_enabled{this, "Enable thread scheduler", thread_scheduler_enabled_def};
 		cfg::_bool set_daz_and_ftz{this, "Set DAZ and FTZ", false};
 		cfg::_enum<spu_decoder_type> spu_decoder{this, "SPU Decoder", spu_decoder_type::llvm};
+		cfg::_bool spu_asmjit_tier{this, "SPU LLVM ASMJIT First Tier", false}; // Use ASMJIT instead of the LLVM interpreter before LLVM compilation is done
 		cfg::_bool lower_spu_priority{this, "Lower SPU thread priority"};
 		cfg::_bool spu_debug{this, "SPU Debug"};
 		cfg::_int<0, 6> preferred_spu_threads{this, "Preferred SPU Threads", 0, true}; //Numnber of hardware threads dedicated to heavy simultaneous spu tasks
@@ -412,9 +413,11 @@ struct cfg_root : cfg::node
 		cfg::_enum<spu_block_size_type> spu_block_size{this, "SPU Block Size", spu_block_size_type::safe};
 		cfg::_bool spu_accurate_getllar{this, "Accurate GETLLAR", false};
 		cfg::_bool spu_accurate_putlluc{this, "Accurate PUTLLUC", false};
+		cfg::_bool spu_relaxed_putllc{this, "Relaxed PUTLLC", false}; // Use 16-byte CAS instead of full memory lock if TSX is not available (not 128-byte atomic for plain accesses)
 		cfg::_bool spu_verification{this, "SPU Verification", true}; // Should be enabled
 		cfg::_bool spu_cache{this, "SPU Cache", true};
 		cfg::_bool spu_prof{this, "SPU Profiler", false};
+		cfg::_bool reservation_prof{this, "Reservation Profiler", false}; // Collect per-line statistics of guest atomics
 		cfg::_enum<tsx_usage> enable_TSX{this, "Enable TSX", tsx_usage::enabled}; // Enable TSX. Forcing this on Haswell/Broadwell CPUs should be used carefully
 		cfg::_bool spu_accurate_xfloat{this, "Accurate xfloat", false};
 		cfg::_bool spu_approx_xfloat{this, "Approximate xfloat", true};
@@ -498,6 +501,8 @@ struct cfg_root : cfg::node
 		cfg::_bool disable_native_float16{this, "Disable native float16 support", false};
 		cfg::_bool multithreaded_rsx{this, "Multithreaded RSX", false};
 		cfg::_bool relaxed_zcull_sync{this, "Relaxed ZCULL Sync", false};
+		cfg::_bool userfaultfd_write_tracking{this, "Use userfaultfd Write Tracking", false}; // Linux only
+		cfg::_int<1, 8> offloader_thread_count{this, "Offloader Thread Count", 1}; // With Multithreaded RSX
 		cfg::_int<1, 8> consequtive_frames_to_draw{this, "Consecutive Frames To Draw", 1};
 		cfg::_int<1, 8> consequtive_frames_to_skip{this, "Consecutive Frames To Skip", 1};
 		cfg::_int<50, 800> resolution_scale_percent{this, "Resolution Scale", 100};
@@ -578,6 +583,7 @@ struct cfg_root : cfg::node
 		cfg::_int<1, 1000> sampling_period_multiplier{this, "Sampling Period Multiplier", 100};
 		cfg::_bool enable_time_stretching{this, "Enable Time Stretching", false};
 		cfg::_int<0, 100> time_stretching_threshold{this, "Time Stretching Threshold", 75};
+		cfg::_bool mixer_self_test{this, "Mixer Self-Test", false}; // Compare vectorized and scalar mixing at startup (debug)
 		cfg::_enum<microphone_handler> microphone_type{ this, "Microphone Type", microphone_handler::null };
 		cfg::string microphone_devices{ this, "Microphone Devices", ";;;;" };
 	} audio{this};
@@ -0,0 +1,680 @@
+#include "stdafx.h"
+
+#include "ISO.h"
+
+#include "Utilities/StrUtil.h"
+
+#include <unordered_set>
+
+LOG_CHANNEL(iso_log, "ISO");
+
+namespace
+{
+	// ISO 9660 directory record (variable length, little-endian fields used)
+	struct iso_dir_record
+	{
+		u8 length;
+		u8 ext_length;
+		le_t<u32, 1> lba;
+		be_t<u32, 1> lba_be;
+		le_t<u32, 1> size;
+		be_t<u32, 1> size_be;
+		u8 time[7];
+		u8 flags;
+		u8 unit_size;
+		u8 gap_size;
+		le_t<u16, 1> volume;
+		be_t<u16, 1> volume_be;
+		u8 name_length;
+	};
+
+	static_assert(sizeof(iso_dir_record) == 33);
+
+	enum : u8
+	{
+		iso_flag_dir = 0x2,
+		iso_flag_multi_extent = 0x80,
+	};
+
+	// Directory record timestamp (years since 1900, month, day, hour, minute, second, GMT offset in 15 min units)
+	s64 iso_get_time(const u8 (&t)[7])
+	{
+		if (!t[1] || !t[2])
+		{
+			return 0;
+		}
+
+		// Days from civil (proleptic Gregorian calendar)
+		const s64 y = t[0] + 1900 - (t[1] <= 2);
+		const s64 era = y / 400;
+		const s64 yoe = y - era * 400;
+		const s64 doy = (153 * (t[1] + (t[1] > 2 ? -3 : 9)) + 2) / 5 + t[2] - 1;
+		const s64 doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+		const s64 days = era * 146097 + doe - 719468;
+
+		return days * 86400 + t[3] * 3600 + t[4] * 60 + t[5] - static_cast<s8>(t[6]) * 900;
+	}
+
+	std::string iso_get_name(const u8* name, u32 length, bool joliet)
+	{
+		std::string result;
+
+		if (joliet)
+		{
+			// UCS-2 (big-endian) to UTF-8
+			for (u32 i = 0; i + 1 < length; i += 2)
+			{
+				u32 c = name[i] << 8 | name[i + 1];
+
+				if (c >= 0xd800 && c < 0xdc00 && i + 3 < length)
+				{
+					const u32 c2 = name[i + 2] << 8 | name[i + 3];
+
+					if (c2 >= 0xdc00 && c2 < 0xe000)
+					{
+						c = 0x10000 + ((c - 0xd800) << 10) + (c2 - 0xdc00);
+						i += 2;
+					}
+				}
+
+				if (c < 0x80)
+				{
+					result += static_cast<char>(c);
+				}
+				else if (c < 0x800)
+				{
+					result += static_cast<char>(0xc0 | c >> 6);
+					result += static_cast<char>(0x80 | (c & 0x3f));
+				}
+				else if (c < 0x10000)
+				{
+					result += static_cast<char>(0xe0 | c >> 12);
+					result += static_cast<char>(0x80 | (c >> 6 & 0x3f));
+					result += static_cast<char>(0x80 | (c & 0x3f));
+				}
+				else
+				{
+					result += static_cast<char>(0xf0 | c >> 18);
+					result += static_cast<char>(0x80 | (c >> 12 & 0x3f));
+					result += static_cast<char>(0x80 | (c >> 6 & 0x3f));
+					result += static_cast<char>(0x80 | (c & 0x3f));
+				}
+			}
+		}
+		else
+		{
+			result.assign(reinterpret_cast<const char*>(name), length);
+		}
+
+		// Remove file version and empty extension
+		if (const auto pos = result.rfind(';'); pos != -1)
+		{
+			result.resize(pos);
+		}
+
+		if (!result.empty() && result.back() == '.')
+		{
+			result.pop_back();
+		}
+
+		return result;
+	}
+
+	class iso_file final : public fs::file_base
+	{
+		const std::shared_ptr<fs::file> m_image;
+		const fs::stat_t m_info;
+		const std::vector<iso_device::extent> m_extents;
+
+		u64 m_pos = 0;
+
+	public:
+		iso_file(const std::shared_ptr<fs::file>& image, const iso_device::entry& entry)
+			: m_image(image)
+			, m_info(entry.info)
+			, m_extents(entry.extents)
+		{
+		}
+
+		fs::stat_t stat() override
+		{
+			return m_info;
+		}
+
+		bool trunc(u64 length) override
+		{
+			fs::g_tls_error = fs::error::readonly;
+			return false;
+		}
+
+		u64 read(void* buffer, u64 size) override
+		{
+			const u64 result = read_at(m_pos, buffer, size);
+			m_pos += result;
+			return result;
+		}
+
+		u64 read_at(u64 offset, void* buffer, u64 size) override
+		{
+			u64 result = 0;
+
+			for (const auto& [start, length] : m_extents)
+			{
+				if (!size)
+				{
+					break;
+				}
+
+				if (offset >= length)
+				{
+					offset -= length;
+					continue;
+				}
+
+				// Read the whole range within the extent at once
+				const u64 count = std::min<u64>(length - offset, size);
+				const u64 nread = m_image->read_at(start + offset, static_cast<u8*>(buffer) + result, count);
+
+				result += nread;
+
+				if (nread < count)
+				{
+					break;
+				}
+
+				size -= count;
+				offset = 0;
+			}
+
+			return result;
+		}
+
+		u64 write(const void* buffer, u64 size) override
+		{
+			fs::g_tls_error = fs::error::readonly;
+			return 0;
+		}
+
+		u64 seek(s64 offset, fs::seek_mode whence) override
+		{
+			const s64 new_pos =
+				whence == fs::seek_set ? offset :
+				whence == fs::seek_cur ? offset + m_pos :
+				whence == fs::seek_end ? offset + m_info.size :
+				(fmt::raw_error("iso_file::seek(): invalid whence"), 0);
+
+			if (new_pos < 0)
+			{
+				fs::g_tls_error = fs::error::inval;
+				return -1;
+			}
+
+			m_pos = new_pos;
+			return m_pos;
+		}
+
+		u64 size() override
+		{
+			return m_info.size;
+		}
+	};
+
+	class iso_dir final : public fs::dir_base
+	{
+		std::vector<fs::dir_entry> m_entries;
+		std::size_t m_pos = 0;
+
+	public:
+		iso_dir(std::vector<fs::dir_entry>&& entries)
+			: m_entries(std::move(entries))
+		{
+		}
+
+		bool read(fs::dir_entry& out) override
+		{
+			if (m_pos < m_entries.size())
+			{
+				out = m_entries[m_pos++];
+				return true;
+			}
+
+			return false;
+		}
+
+		void rewind() override
+		{
+			m_pos = 0;
+		}
+	};
+}
+
+iso_device::iso_device(const std::string& root, const std::string& image_path)
+	: m_image_path(image_path)
+	, m_root(root)
+{
+}
+
+iso_device::~iso_device()
+{
+}
+
+bool iso_device::init()
+{
+	fs::file image(m_image_path);
+
+	if (!image)
+	{
+		iso_log.error("Failed to open disc image '%s' (%s)", m_image_path, fs::g_tls_error);
+		return false;
+	}
+
+	m_image = std::make_shared<fs::file>(std::move(image));
+
+	// Volume descriptors start at sector 16
+	u32 root_lba = 0, root_size = 0;
+	bool joliet = false;
+
+	for (u64 sector = 16;; sector++)
+	{
+		std::array<u8, 2048> desc;
+
+		if (m_image->read_at(sector * 2048, desc.data(), desc.size()) != desc.size() || std::memcmp(desc.data() + 1, "CD001", 5) != 0)
+		{
+			break;
+		}
+
+		const u8 type = desc[0];
+
+		if (type == 255)
+		{
+			// Terminator
+			break;
+		}
+
+		// Root directory record is located at offset 156
+		iso_dir_record root;
+		std::memcpy(&root, desc.data() + 156, sizeof(root));
+
+		if (type == 1 && !joliet)
+		{
+			// Primary volume descriptor
+			m_block_size = reinterpret_cast<const le_t<u16, 1>&>(desc[128]);
+			root_lba = root.lba;
+			root_size = root.size;
+		}
+		else if (type == 2 && desc[88] == '%' && desc[89] == '/' && (desc[90] == '@' || desc[90] == 'C' || desc[90] == 'E'))
+		{
+			// Joliet supplementary volume descriptor (preferred)
+			root_lba = root.lba;
+			root_size = root.size;
+			joliet = true;
+		}
+	}
+
+	if (!root_lba || m_block_size != 2048)
+	{
+		iso_log.error("Invalid disc image '%s'", m_image_path);
+		return false;
+	}
+
+	if (!build_index(root_lba, root_size, joliet))
+	{
+		iso_log.error("Failed to read directories of disc image '%s'", m_image_path);
+		return false;
+	}
+
+	iso_log.notice("Mounted disc image '%s' (%u entries, joliet=%d)", m_image_path, m_index.size(), joliet);
+	return true;
+}
+
+bool iso_device::build_index(u32 root_lba, u32 root_size, bool joliet)
+{
+	m_index.clear();
+
+	auto& root = m_index[""];
+	root.info.is_directory = true;
+	root.info.size = root_size;
+
+	// Directories to scan (path, lba, size)
+	std::vector<std::tuple<std::string, u32, u32>> queue{{"", root_lba, root_size}};
+
+	// Protection against directory loops
+	std::unordered_set<u32> visited{root_lba};
+
+	std::vector<u8> data;
+
+	while (!queue.empty())
+	{
+		const auto [dir_path, lba, size] = std::move(queue.back());
+		queue.pop_back();
+
+		// Read the whole directory at once
+		data.resize(size);
+
+		if (m_image->read_at(u64{lba} * m_block_size, data.data(), size) != size)
+		{
+			return false;
+		}
+
+		// File whose previous record had the multi-extent flag set (continued by the next record)
+		std::string continued;
+
+		for (u32 pos = 0; pos + sizeof(iso_dir_record) <= size;)
+		{
+			iso_dir_record rec;
+			std::memcpy(&rec, data.data() + pos, sizeof(rec));
+
+			if (!rec.length)
+			{
+				// Records don't cross sector boundaries, padding till the next one
+				pos = ::align<u32>(pos + 1, static_cast<u32>(m_block_size));
+				continue;
+			}
+
+			if (rec.length < sizeof(rec) + rec.name_length || pos + rec.length > size)
+			{
+				return false;
+			}
+
+			const u8* name_ptr = data.data() + pos + sizeof(rec);
+			pos += rec.length;
+
+			if (rec.name_length == 1 && name_ptr[0] <= 1)
+			{
+				// Skip . and ..
+				continue;
+			}
+
+			const std::string name = iso_get_name(name_ptr, rec.name_length, joliet);
+
+			if (name.empty() || name == "." || name == ".." || name.find('/') != -1)
+			{
+				continue;
+			}
+
+			const std::string path = dir_path.empty() ? name : dir_path + '/' + name;
+			const bool is_dir = (rec.flags & iso_flag_dir) != 0;
+			const u64 offset = u64{rec.lba + rec.ext_length} * m_block_size;
+
+			auto [found, inserted] = m_index.try_emplace(path);
+			entry& ent = found->second;
+
+			const bool is_continued = !is_dir && (rec.flags & iso_flag_multi_extent) != 0;
+
+			if (!inserted)
+			{
+				if (is_dir || ent.info.is_directory || path != continued)
+				{
+					iso_log.error("Duplicate directory record '%s' ignored", path);
+					continued.clear();
+					continue;
+				}
+
+				// Continuation of the multi-extent file
+				ent.extents.emplace_back(offset, rec.size);
+				ent.info.size += rec.size;
+
+				if (!is_continued)
+				{
+					continued.clear();
+				}
+
+				continue;
+			}
+
+			if (is_continued)
+			{
+				continued = path;
+			}
+			else
+			{
+				continued.clear();
+			}
+
+			ent.info.is_directory = is_dir;
+			ent.info.is_writable = false;
+			ent.info.size = rec.size;
+			ent.info.mtime = iso_get_time(rec.time);
+			ent.info.atime = ent.info.mtime;
+			ent.info.ctime = ent.info.mtime;
+
+			m_index[dir_path].children.emplace_back(name);
+
+			if (is_dir)
+			{
+				if (visited.emplace(rec.lba).second)
+				{
+					queue.emplace_back(path, rec.lba, rec.size);
+				}
+			}
+			else
+			{
+				ent.extents.emplace_back(offset, rec.size);
+			}
+		}
+	}
+
+	return true;
+}
+
+bool iso_device::get_local(const std::string& path, std::string& local) const
+{
+	if (path.compare(0, m_root.size(), m_root) != 0)
+	{
+		return false;
+	}
+
+	local.clear();
+
+	for (std::size_t pos = m_root.size(); pos < path.size();)
+	{
+		const std::size_t end = std::min(path.find('/', pos), path.size());
+		const std::string_view name(path.data() + pos, end - pos);
+		pos = end + 1;
+
+		if (name.empty() || name == ".")
+		{
+			continue;
+		}
+
+		if (name == "..")
+		{
+			if (local.empty())
+			{
+				return false;
+			}
+
+			const auto last = local.rfind('/');
+			local.resize(last == -1 ? 0 : last);
+			continue;
+		}
+
+		if (!local.empty())
+		{
+			local += '/';
+		}
+
+		local += name;
+	}
+
+	return true;
+}
+
+const iso_device::entry* iso_device::find(const std::string& path) const
+{
+	std::string local;
+
+	if (!get_local(path, local))
+	{
+		fs::g_tls_error = fs::error::noent;
+		return nullptr;
+	}
+
+	const auto found = m_index.find(local);
+
+	if (found == m_index.end())
+	{
+		fs::g_tls_error = fs::error::noent;
+		return nullptr;
+	}
+
+	return &found->second;
+}
+
+bool iso_device::stat(const std::string& path, fs::stat_t& info)
+{
+	if (const auto ent = find(path))
+	{
+		info = ent->info;
+		return true;
+	}
+
+	return false;
+}
+
+bool iso_device::statfs(const std::string& path, fs::device_stat& info)
+{
+	if (!find(path))
+	{
+		return false;
+	}
+
+	info.block_size = m_block_size;
+	info.total_size = m_image->size();
+	info.total_free = 0;
+	info.avail_free = 0;
+	return true;
+}
+
+bool iso_device::remove_dir(const std::string& path)
+{
+	fs::g_tls_error = fs::error::readonly;
+	return false;
+}
+
+bool iso_device::create_dir(const std::string& path)
+{
+	fs::g_tls_error = fs::error::readonly;
+	return false;
+}
+
+bool iso_device::rename(const std::string& from, const std::string& to)
+{
+	fs::g_tls_error = fs::error::readonly;
+	return false;
+}
+
+bool iso_device::remove(const std::string& path)
+{
+	fs::g_tls_error = fs::error::readonly;
+	return false;
+}
+
+bool iso_device::trunc(const std::string& path, u64 length)
+{
+	fs::g_tls_error = fs::error::readonly;
+	return false;
+}
+
+bool iso_device::utime(const std::string& path, s64 atime, s64 mtime)
+{
+	fs::g_tls_error = fs::error::readonly;
+	return false;
+}
+
+std::unique_ptr<fs::file_base> iso_device::open(const std::string& path, bs_t<fs::open_mode> mode)
+{
+	if (mode & (fs::write + fs::append + fs::trunc))
+	{
+		fs::g_tls_error = fs::error::readonly;
+		return nullptr;
+	}
+
+	const auto ent = find(path);
+
+	if (!ent)
+	{
+		return nullptr;
+	}
+
+	if (mode & fs::excl)
+	{
+		fs::g_tls_error = fs::error::exist;
+		return nullptr;
+	}
+
+	if (ent->info.is_directory)
+	{
+		fs::g_tls_error = fs::error::isdir;
+		return nullptr;
+	}
+
+	return std::make_unique<iso_file>(m_image, *ent);
+}
+
+std::unique_ptr<fs::dir_base> iso_device::open_dir(const std::string& path)
+{
+	std::string local;
+
+	if (!get_local(path, local))
+	{
+		fs::g_tls_error = fs::error::noent;
+		return nullptr;
+	}
+
+	const auto found = m_index.find(local);
+
+	if (found == m_index.end() || !found->second.info.is_directory)
+	{
+		fs::g_tls_error = fs::error::noent;
+		return nullptr;
+	}
+
+	// Take the snapshot of the entries from the index
+	std::vector<fs::dir_entry> entries;
+	entries.reserve(found->second.children.size() + 2);
+
+	fs::dir_entry self;
+	static_cast<fs::stat_t&>(self) = found->second.info;
+	self.name = ".";
+	entries.emplace_back(self);
+	self.name = "..";
+	entries.emplace_back(self);
+
+	for (const auto& name : found->second.children)
+	{
+		fs::dir_entry& ent = entries.emplace_back();
+		static_cast<fs::stat_t&>(ent) = m_index.at(local.empty() ? name : local + '/' + name).info;
+		ent.name = name;
+	}
+
+	return std::make_unique<iso_dir>(std::move(entries));
+}
+
+bool iso_is_image(const std::string& path)
+{
+	return path.size() > 4 && fmt::to_lower(path.substr(path.size() - 4)) == ".iso" && fs::is_file(path);
+}
+
+std::string iso_mount(const std::string& image_path)
+{
+	auto device = std::make_shared<iso_device>(iso_bdvd_root, image_path);
+
+	if (!device->init())
+	{
+		return {};
+	}
+
+	fs::set_virtual_device(iso_bdvd_root, device);
+	return iso_bdvd_root;
+}
+
+std::string iso_get_image_path()
+{
+	if (const auto device = std::dynamic_pointer_cast<iso_device>(fs::get_virtual_device(std::string(iso_bdvd_root) + '/')))
+	{
+		return device->get_image_path();
+	}
+
+	return {};
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Utilities/File.h"
+
+#include <unordered_map>
+
+// Read-only ISO 9660 disc image exposed as a virtual device (Joliet names are used if available)
+class iso_device final : public fs::device_base
+{
+public:
+	// File data location in the image (byte offset, size)
+	using extent = std::pair<u64, u64>;
+
+	struct entry
+	{
+		fs::stat_t info{};
+
+		// File data (several extents for multi-extent files)
+		std::vector<extent> extents;
+
+		// Directory contents (names)
+		std::vector<std::string> children;
+	};
+
+private:
+	// Source image (shared with opened files)
+	std::shared_ptr<fs::file> m_image;
+
+	std::string m_image_path;
+
+	// Device root (//name)
+	std::string m_root;
+
+	// Directory index built at mount (normalized path -> entry, root is empty string)
+	std::unordered_map<std::string, entry> m_index;
+
+	u64 m_block_size = 2048;
+
+	// Get normalized path relative to the device root (false if the path escapes the root)
+	bool get_local(const std::string& path, std::string& local) const;
+
+	const entry* find(const std::string& path) const;
+
+	bool build_index(u32 root_lba, u32 root_size, bool joliet);
+
+public:
+	iso_device(const std::string& root, const std::string& image_path);
+
+	~iso_device() override;
+
+	// Parse the image and build the directory index (false if it's not a valid disc image)
+	bool init();
+
+	const std::string& get_image_path() const
+	{
+		return m_image_path;
+	}
+
+	bool stat(const std::string& path, fs::stat_t& info) override;
+	bool statfs(const std::string& path, fs::device_stat& info) override;
+	bool remove_dir(const std::string& path) override;
+	bool create_dir(const std::string& path) override;
+	bool rename(const std::string& from, const std::string& to) override;
+	bool remove(const std::string& path) override;
+	bool trunc(const std::string& path, u64 length) override;
+	bool utime(const std::string& path, s64 atime, s64 mtime) override;
+
+	std::unique_ptr<fs::file_base> open(const std::string& path, bs_t<fs::open_mode> mode) override;
+	std::unique_ptr<fs::dir_base> open_dir(const std::string& path) override;
+};
+
+// Virtual device name used for the mounted disc image
+constexpr auto iso_bdvd_root = "//iso_bdvd";
+
+// Check whether the path points to a disc image (by extension)
+bool iso_is_image(const std::string& path);
+
+// Mount disc image at iso_bdvd_root (replaces previously mounted image), returns the root path (without trailing slash) or empty string on failure
+std::string iso_mount(const std::string& image_path);
+
+// Get path of the image mounted at iso_bdvd_root (empty string if none)
+std::string iso_get_image_path();
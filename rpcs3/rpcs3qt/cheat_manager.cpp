@@ -13,6 +13,7 @@
 #include "Emu/System.h"
 #include "Emu/Memory/vm.h"
 #include "Emu/CPU/CPUThread.h"
+#include "Emu/RSX/rsx_vertex_cache.h"
 
 #include "Emu/IdManager.h"
 #include "Emu/Cell/PPUAnalyser.h"
@@ -399,6 +400,8 @@ bool cheat_engine::set_value(const u32 offset, const T value)
 
 	*vm::get_super_ptr<T>(offset) = value;
 
+	rsx::vertex_cache::g_page_tracker.on_sudo_write(utils::address_range::start_length(offset, sizeof(T)));
+
 	const bool exec_code_at_start = vm::check_addr(offset, 1, vm::page_executable);
 	const bool exec_code_at_end = [&]()
 	{
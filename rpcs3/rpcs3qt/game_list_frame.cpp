@@ -12,6 +12,7 @@
 #include "Loader/PSF.h"
 #include "Utilities/types.h"
 #include "Utilities/lockless.h"
+#include "Utilities/StrUtil.h"
 
 #include <algorithm>
 #include <iterator>
@@ -1343,26 +1344,70 @@ bool game_list_frame::RemovePPUCache(const std::string& base_dir, bool is_intera
 
 	const QStringList filter{ QStringLiteral("v*.obj"), QStringLiteral("v*.obj.gz") };
 
+	auto remove_files = [&](QDirIterator& dir_iter)
+	{
+		while (dir_iter.hasNext())
+		{
+			const QString filepath = dir_iter.next();
+
+			if (QFile::remove(filepath))
+			{
+				++files_removed;
+				game_list_log.notice("Removed PPU cache file: %s", sstr(filepath));
+			}
+			else
+			{
+				game_list_log.warning("Could not remove PPU cache file: %s", sstr(filepath));
+			}
+
+			++files_total;
+		}
+	};
+
 	QDirIterator dir_iter(qstr(base_dir), filter, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+	remove_files(dir_iter);
 
-	while (dir_iter.hasNext())
+	// Shared library caches used by the title (listed in the manifest)
+	const std::string manifest_path = base_dir + "/ppu-modules.lst";
+
+	if (const fs::file manifest{manifest_path})
 	{
-		const QString filepath = dir_iter.next();
+		const std::string cache_dir = fs::get_cache_dir() + "cache/";
+		const std::string title_dir = base_dir.substr(base_dir.find_last_of("/\\") + 1);
 
-		if (QFile::remove(filepath))
+		// Shared library caches still used by other titles must be kept
+		std::set<std::string> used_elsewhere;
+
+		for (const auto& entry : fs::dir(cache_dir))
 		{
-			++files_removed;
-			game_list_log.notice("Removed PPU cache file: %s", sstr(filepath));
+			if (!entry.is_directory || entry.name == "." || entry.name == ".." || entry.name == title_dir)
+			{
+				continue;
+			}
+
+			if (const fs::file other{cache_dir + entry.name + "/ppu-modules.lst"})
+			{
+				for (std::string& module_dir : fmt::split(other.to_string(), {"\n"}))
+				{
+					used_elsewhere.emplace(std::move(module_dir));
+				}
+			}
 		}
-		else
+
+		for (const std::string& module_dir : fmt::split(manifest.to_string(), {"\n"}))
 		{
-			game_list_log.warning("Could not remove PPU cache file: %s", sstr(filepath));
-		}
+			if (used_elsewhere.count(module_dir))
+			{
+				game_list_log.notice("Kept shared PPU cache used by other titles: %s", module_dir);
+				continue;
+			}
 
-		++files_total;
+			QDirIterator shared_iter(qstr(cache_dir + module_dir), filter, QDir::Files | QDir::NoDotAndDotDot);
+			remove_files(shared_iter);
+		}
 	}
 
-	const bool success = files_total == files_removed;
+	const bool success = files_total == files_removed && (!fs::is_file(manifest_path) || fs::remove_file(manifest_path));
 
 	if (success)
 		game_list_log.success("Removed PPU cache in %s", base_dir);
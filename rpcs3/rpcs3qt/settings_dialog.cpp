@@ -621,7 +621,7 @@ settings_dialog::settings_dialog(std::shared_ptr<gui_settings> guiSettings, std:
 
 	auto EnableBuffering = [this, EnableBufferingOptions](const QString& text)
 	{
-		const bool enabled = text == "XAudio2" || text == "OpenAL" || text == "FAudio";
+		const bool enabled = text == "XAudio2" || text == "OpenAL" || text == "FAudio" || text == "Null";
 		ui->enableBuffering->setEnabled(enabled);
 		EnableBufferingOptions(enabled && ui->enableBuffering->isChecked());
 	};